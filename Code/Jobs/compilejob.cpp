@@ -1,86 +1,417 @@
 #include <iostream>
 #include <string>
-#include <fstream>
 #include <filesystem>
+#include <map>
+#include <glob.h>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
 
 #include "../lib/jobsystem.h"
 
 #include "compilejob.h"
+#include "compileunitjob.h"
 #include "parsingjob.h"
 
 namespace fs = std::filesystem;
 
+extern char** environ;
+
+// Process of every command started, by its pipe. What popen() used to keep for us.
+static std::mutex s_commandProcessesMutex;
+struct CommandProcess
+{
+    pid_t   m_processID;
+    bool    m_hasJobServerToken; // Given back when it is done
+};
+static std::map<FILE*, CommandProcess> s_commandProcesses;
+
 // Define the constructor
-CompileJob::CompileJob(const char* jsonData)
-    : Job(jsonData)
+CompileJob::CompileJob(const json& jsonObject)
+    : Job(jsonObject)
 {
-    json jsonObject = json::parse(jsonData);
     std::string makefile = jsonObject.value("makefile", "");
     bool isFilePath = jsonObject.value("isFilePath", true);
+    m_useJobServer = jsonObject.value("useJobServer", true);
 
+    m_isIncremental = jsonObject.value("incremental", false);
+    if(m_isIncremental){
+        m_sources = jsonObject.value("sources", std::vector<std::string>{});
+        m_compiler = jsonObject.value("compiler", "clang++");
+        m_compilerFlags = jsonObject.value("flags", "");
+        m_linkerFlags = jsonObject.value("linkFlags", "");
+        m_outputPath = jsonObject.value("output", "");
+        m_objectDir = jsonObject.value("objectDir", "./Data/build");
+        return; // No makefile involved
+    }
+
+    // NOTE:    Every compile job of a script usually points to the same makefile. It is read once, and
+    //          they all hold the same buffer, instead of a copy each (read again by every constructor).
+    InternTable* internTable = JobSystem::CreateOrGet()->GetInternTable();
     if(isFilePath){
-        std::ifstream fileStream(makefile);
-        if(fileStream.is_open()){
-            std::string line;
-            while (std::getline(fileStream, line)){
-                m_makefileContent += line + '\n';
-            }
-            fileStream.close();
-        }
-        else{
+        int readResult = 0;
+        m_makefileContent = internTable->InternFile(makefile, JobSystem::CreateOrGet()->GetFileIOService(), readResult);
+        if(readResult != 0){
             std::cerr << "Unable to open file: " << makefile << std::endl;
         }
     }
     else{
-        m_makefileContent = makefile;
+        m_makefileContent = internTable->InternString(std::move(makefile));
     }
 }
 
 void CompileJob::Execute(){
-    std::array<char, 128> buffer;
+    if(m_isIncremental){
+        ExecuteIncremental();
+        return;
+    }
 
     // NOTE: I was using the same file name "temp_file" for all the thread. Result? Race condition
     // I was getting inconsistent results. Either an error, or the same output for both job, even though
     // they were handling different files. Now, temporary files will have the job id appended to it to avoid
     // collisions.
-    std::string tempFileName = "temp_makefile_"+ std::to_string(GetUniqueID());
-    std::ofstream tempFile(tempFileName);
-    if (!tempFile.is_open()) {
+    m_tempFileName = "temp_makefile_"+ std::to_string(GetUniqueID());
+    std::shared_ptr<FileIOBatch> tempFileWrite = JobSystem::CreateOrGet()->GetFileIOService()->WriteFile(m_tempFileName, m_makefileContent ? *m_makefileContent : std::string());
+    tempFileWrite->Wait(); // make reads it right away
+    if (tempFileWrite->GetResult(0) != 0) {
         std::cerr << "Error: Unable to create a temporary Makefile." << std::endl;
+        this->returnCode = -1;
+        m_compilationOutput = "Unable to create a temporary Makefile: " + m_tempFileName;
+        SetMakeOutput();
         return;
     }
-    tempFile << m_makefileContent;
-    tempFile.close();
-    std::string command = "make -f " + tempFileName;
-    
-    // Redirect cerr (2) to cout (&1)
-    command.append(" 2>&1");
+    std::string command = "make -f " + m_tempFileName;
 
-    // Open pipe and run the command
-    FILE* pipe = popen(command.c_str(), "r");
-    if (!pipe) {
-        std::cout << "popen Failed: Failed to open file" << std::endl;
+    // NOTE:    make spends almost all of its time compiling, and used to hold this worker (one of only
+    //          a couple on the compile channel) blocked in fgets() the whole time. Now the job suspends
+    //          on the pipe instead, and the worker is free for the next compile as soon as make started.
+    m_makePipe = StartCommand(command, m_useJobServer, this);
+    if (m_makePipe == nullptr) {
+        this->returnCode = -1;
+        m_compilationOutput = "Unable to start: " + command;
+        std::remove( m_tempFileName.c_str() );
+        SetMakeOutput();
         return;
     }
 
+    int pipeFD = fileno(m_makePipe);
+    fcntl(pipeFD, F_SETFL, fcntl(pipeFD, F_GETFL) | O_NONBLOCK);
+    AwaitReadable(pipeFD, [this](){ ReadMakeOutput(); });
+}
+
+void CompileJob::ReadMakeOutput(){
+    int pipeFD = fileno(m_makePipe);
+    char buffer[4096];
+    while(true){
+        ssize_t numBytesRead = read(pipeFD, buffer, sizeof(buffer));
+        if(numBytesRead > 0){
+            m_compilationOutput.append(buffer, numBytesRead);
+        } else if(numBytesRead < 0 && errno == EINTR){
+            continue;
+        } else if(numBytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            AwaitReadable(pipeFD, [this](){ ReadMakeOutput(); }); // Drained, make is still at it
+            return;
+        } else {
+            break; // End of file: make exited (or at least closed its output)
+        }
+    }
+
+    this->returnCode = FinishCommand(m_makePipe, this);
+    m_makePipe = nullptr;
+
+    // Clean up the temporary file
+    std::remove( m_tempFileName.c_str() );
+
+    SetMakeOutput();
+}
+
+// NOTE:    Also when make could not even be started: a job without an output (and a NONE result) read as
+//          "no information" to the parsing jobs, conditionals and retries downstream, rather than a failure.
+void CompileJob::SetMakeOutput(){
+    json compilationOutputJson;
+    compilationOutputJson["jobChannels"] = 536870912; // 0x20000000
+    compilationOutputJson["jobType"] = 2;
+    compilationOutputJson["content"] = m_compilationOutput;
+    compilationOutputJson["returnCode"] = this->returnCode;
+    compilationOutputJson["status"] = (this->returnCode == 0) ? "success" : "failure";
+    SetResult((this->returnCode == 0) ? JOB_RESULT_SUCCESS : JOB_RESULT_FAILURE); // Conditionals, retries and reuse all go by it
+    setOutputJson(std::move(compilationOutputJson));
+}
+
+// Runs a shell command, and collects everything it prints (stdout and stderr). Returns -1 if it could not be started.
+int CompileJob::RunCommand(const std::string& shellCommand, std::string& commandOutput, bool useJobServer, Job* owner){
+    FILE* pipe = StartCommand(shellCommand, useJobServer, owner);
+    if (!pipe) {
+        return -1;
+    }
+
     // Read until the end of the process
+    std::array<char, 128> buffer;
     while (fgets(buffer.data(), 128, pipe) != NULL) {
-        this->m_compilationOutput.append(buffer.data());
+        commandOutput.append(buffer.data());
+    }
+
+    return FinishCommand(pipe, owner);
+}
+
+FILE* CompileJob::StartCommand(const std::string& shellCommand, bool useJobServer, Job* owner){
+    std::string command = shellCommand;
+
+    // Redirect cerr (2) to cout (&1)
+    command.append(" 2>&1");
+
+    // NOTE:    The token we take stands for the process itself. If it is "make", any extra parallel child
+    //          it wants, it reads from the same pipe, because MAKEFLAGS tells it where the pipe is.
+    //          Waiting for the token still blocks: that is the throttle, not something to work around.
+    JobServer* jobServer = useJobServer ? JobSystem::CreateOrGet()->GetJobServer() : nullptr;
+    bool hasJobServerToken = jobServer && jobServer->AcquireToken();
+    if(hasJobServerToken){
+        command = "MAKEFLAGS='" + jobServer->GetMakeFlags() + "' " + command;
+    }
+
+    // NOTE:    Was popen(). Same shell, same pipe, but the command now leads its own process group, so killing
+    //          the group stops make AND the compilers it started. Its input is /dev/null: a command waiting
+    //          on stdin used to hang its job forever (and read what the user typed in the interpreter).
+    int pipeFDs[2];
+    if(pipe2(pipeFDs, O_CLOEXEC) != 0){
+        std::cout << "popen Failed: Failed to open file" << std::endl;
+        if(hasJobServerToken){
+            jobServer->ReleaseToken();
+        }
+        return nullptr;
+    }
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_adddup2(&fileActions, pipeFDs[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&fileActions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    sigset_t noSignals; // A "jobworker" blocks its interrupt signal, the command should not inherit that
+    sigemptyset(&noSignals);
+    posix_spawnattr_setsigmask(&attributes, &noSignals);
+
+    pid_t processID = -1;
+    char* arguments[] = { (char*)"sh", (char*)"-c", &command[0], nullptr };
+    int result = posix_spawn(&processID, "/bin/sh", &fileActions, &attributes, arguments, environ);
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&fileActions);
+    close(pipeFDs[1]);
+
+    if (result != 0) {
+        std::cout << "popen Failed: Failed to open file" << std::endl;
+        close(pipeFDs[0]);
+        if(hasJobServerToken){
+            jobServer->ReleaseToken();
+        }
+        return nullptr;
+    }
+
+    FILE* pipe = fdopen(pipeFDs[0], "r");
+    s_commandProcessesMutex.lock();
+    s_commandProcesses[pipe] = { processID, hasJobServerToken };
+    s_commandProcessesMutex.unlock();
+
+    if(owner){
+        owner->SetChildProcess(processID, true, SIGTERM, SIGKILL); // SIGTERM first: make gives its children's jobserver tokens back
+    }
+    return pipe;
+}
+
+int CompileJob::FinishCommand(FILE* commandPipe, Job* owner){
+    s_commandProcessesMutex.lock();
+    CommandProcess commandProcess = s_commandProcesses[commandPipe];
+    s_commandProcesses.erase(commandPipe);
+    s_commandProcessesMutex.unlock();
+
+    if(owner){
+        owner->ClearChildProcess();
     }
 
     // Close the pipe and get the return code
-    this->returnCode = pclose(pipe);
+    fclose(commandPipe);
+    int returnCode = -1;
+    while(waitpid(commandProcess.m_processID, &returnCode, 0) < 0 && errno == EINTR) {}
+    if(commandProcess.m_hasJobServerToken){
+        JobSystem::CreateOrGet()->GetJobServer()->ReleaseToken();
+    }
 
-    // Clean up the temporary file
-    std::remove( tempFileName.c_str() );
+    return returnCode;
+}
+
+// Turns "./Data/testCode/main.cpp" into "Data_testCode_main.o", so units from different folders never collide
+static std::string objectFileNameFor(const std::string& source){
+    std::string objectName;
+    for(char c: fs::path(source).lexically_normal().replace_extension(".o").string()){
+        if(c == '/' || c == '\\'){
+            objectName += '_';
+        } else if (c != '.' || !objectName.empty()){
+            objectName += c;
+        }
+    }
+    return objectName;
+}
+
+// NOTE:    In incremental mode, there is no makefile. The job knows its translation units, and the
+//          build manifest knows what each object was last built from. Only the stale units get compiled.
+//          When more than one is stale, each becomes its own COMPILE_UNIT_JOB so they build in parallel.
+//          Their output is cached in the manifest, so the job reports the diagnostics of EVERY unit, fresh or not.
+void CompileJob::ExecuteIncremental(){
+    BuildManifest* manifest = JobSystem::CreateOrGet()->GetBuildManifest();
+
+    std::vector<std::string> sources;
+    for(const std::string& pattern: m_sources){
+        glob_t globResult;
+        if(glob(pattern.c_str(), 0, nullptr, &globResult) == 0){
+            for(size_t i = 0; i < globResult.gl_pathc; i++){
+                sources.push_back(globResult.gl_pathv[i]);
+            }
+        }
+        globfree(&globResult);
+    }
+
+    std::error_code errorCode;
+    fs::create_directories(m_objectDir, errorCode);
+
+    std::vector<std::string> objects;
+    std::vector<std::string> commands;
+    std::vector<size_t> staleUnits;
+    for(size_t i = 0; i < sources.size(); i++){
+        std::string object = (fs::path(m_objectDir) / objectFileNameFor(sources[i])).string();
+        std::string command = m_compiler + " " + m_compilerFlags + " -c " + sources[i] + " -o " + object + " -MD -MF " + object + ".d";
+        objects.push_back(object);
+        commands.push_back(command);
+
+        if(!manifest->IsUpToDate(object, command)){
+            staleUnits.push_back(i);
+        }
+    }
+
+    m_objects = objects;
+    m_numRebuiltUnits = staleUnits.size();
+    m_allUnitsSucceeded = true;
+    m_unitOutputs.clear();
+    m_unitJobIDs.clear();
+    m_numUnitJobsCollected = 0;
 
-    // Set the output of the job
+    if(staleUnits.size() == 1 || !JobSystem::CreateOrGet()->IsJobTypeRegistered("COMPILE_UNIT_JOB")){
+        for(size_t unit: staleUnits){
+            std::string unitOutput;
+            m_allUnitsSucceeded &= (CompileUnitJob::BuildUnit(sources[unit], objects[unit], commands[unit], m_useJobServer, unitOutput, this) == 0);
+            m_unitOutputs[unit] = unitOutput;
+        }
+        LinkIncremental(true);
+        return;
+    }
+
+    for(size_t unit: staleUnits){
+        json unitInput;
+        unitInput["jobType"] = 5;
+        unitInput["priority"] = GetPriority();
+        unitInput["source"] = sources[unit];
+        unitInput["object"] = objects[unit];
+        unitInput["command"] = commands[unit];
+        unitInput["useJobServer"] = m_useJobServer;
+
+        Job* unitJob = JobSystem::CreateOrGet()->CreateJob("COMPILE_UNIT_JOB", unitInput);
+        unitJob->SetTransient(true); // If we crash, re-running this job spawns them again
+        m_unitJobIDs.push_back({ unit, unitJob->GetUniqueID() });
+        JobSystem::CreateOrGet()->QueueJob(unitJob);
+    }
+    CollectUnitJobs();
+}
+
+// NOTE:    Used to block the worker in WaitForJob() on every unit. With every worker inside an incremental
+//          compile, nothing was left to run the units. Now the job suspends on the next unit still pending.
+void CompileJob::CollectUnitJobs(){
+    JobSystem* jobSystem = JobSystem::CreateOrGet();
+    while(m_numUnitJobsCollected < m_unitJobIDs.size()){
+        size_t unit = m_unitJobIDs[m_numUnitJobsCollected].first;
+        int unitJobID = m_unitJobIDs[m_numUnitJobsCollected].second;
+        JobStatus unitJobStatus = jobSystem->GetJobStatus(unitJobID);
+        if(unitJobStatus == JOB_STATUS_QUEUED || unitJobStatus == JOB_STATUS_RUNNING){
+            AwaitJob(unitJobID, [this](){ CollectUnitJobs(); });
+            return;
+        }
+
+        std::shared_ptr<const json> unitOutput = jobSystem->GetJobOutputByID(unitJobID);
+        m_allUnitsSucceeded &= (unitOutput && unitOutput->value("returnCode", -1) == 0);
+        m_unitOutputs[unit] = unitOutput ? unitOutput->value("content", "") : "";
+        jobSystem->FinishJob(unitJobID);
+        m_numUnitJobsCollected++;
+    }
+
+    LinkIncremental(false);
+}
+
+// NOTE:    Called from a continuation, the link runs as a unit job of its own (its inputs being the objects).
+//          Run right there, it would block the reactor, and with it the compile jobs whose jobserver token it waits for.
+void CompileJob::LinkIncremental(bool isOnWorker){
+    BuildManifest* manifest = JobSystem::CreateOrGet()->GetBuildManifest();
+    for(size_t i = 0; i < m_objects.size(); i++){
+        auto freshIter = m_unitOutputs.find(i);
+        m_compilationOutput += (freshIter != m_unitOutputs.end()) ? freshIter->second : manifest->GetDiagnostics(m_objects[i]);
+    }
+
+    // Link, if something changed (the objects are the inputs of the output)
+    this->returnCode = m_allUnitsSucceeded ? 0 : 1;
+    if(m_allUnitsSucceeded && !m_outputPath.empty() && !m_objects.empty()){
+        std::string linkCommand = m_compiler;
+        for(const std::string& object: m_objects){
+            linkCommand += " " + object;
+        }
+        linkCommand += " " + m_linkerFlags + " -o " + m_outputPath;
+
+        if(isOnWorker || !JobSystem::CreateOrGet()->IsJobTypeRegistered("COMPILE_UNIT_JOB")){
+            std::string linkOutput;
+            this->returnCode = CompileUnitJob::BuildUnit("", m_outputPath, linkCommand, m_useJobServer, linkOutput, this, m_objects);
+            m_compilationOutput += linkOutput;
+        } else {
+            json linkInput;
+            linkInput["jobType"] = 5;
+            linkInput["priority"] = GetPriority();
+            linkInput["object"] = m_outputPath;
+            linkInput["command"] = linkCommand;
+            linkInput["inputs"] = m_objects;
+            linkInput["useJobServer"] = m_useJobServer;
+
+            Job* linkJob = JobSystem::CreateOrGet()->CreateJob("COMPILE_UNIT_JOB", linkInput);
+            linkJob->SetTransient(true);
+            int linkJobID = linkJob->GetUniqueID();
+            JobSystem::CreateOrGet()->QueueJob(linkJob);
+            AwaitJob(linkJobID, [this, linkJobID](){
+                std::shared_ptr<const json> linkOutput = JobSystem::CreateOrGet()->GetJobOutputByID(linkJobID);
+                this->returnCode = linkOutput ? linkOutput->value("returnCode", -1) : -1;
+                m_compilationOutput += linkOutput ? linkOutput->value("content", "") : "";
+                JobSystem::CreateOrGet()->FinishJob(linkJobID);
+                SetIncrementalOutput();
+            });
+            return;
+        }
+    }
+
+    SetIncrementalOutput();
+}
+
+void CompileJob::SetIncrementalOutput(){
+    JobSystem::CreateOrGet()->GetBuildManifest()->Save();
+
+    // Set the output of the job. Same shape as a regular compile job, so parsing jobs can consume it.
     json compilationOutputJson;
     compilationOutputJson["jobChannels"] = 536870912; // 0x20000000
     compilationOutputJson["jobType"] = 2;
     compilationOutputJson["content"] = m_compilationOutput;
-    compilationOutputJson["status"] = "success";
-    setOutputJson(compilationOutputJson);
+    compilationOutputJson["rebuiltUnits"] = m_numRebuiltUnits;
+    compilationOutputJson["totalUnits"] = m_objects.size();
+    compilationOutputJson["returnCode"] = this->returnCode; // Non-zero if a unit or the link failed
+    compilationOutputJson["status"] = (this->returnCode == 0) ? "success" : "failure";
+    SetResult((this->returnCode == 0) ? JOB_RESULT_SUCCESS : JOB_RESULT_FAILURE);
+    setOutputJson(std::move(compilationOutputJson));
 }
 
 void CompileJob::JobCompleteCallback(){
@@ -95,21 +426,14 @@ void CompileJob::JobCompleteCallback(){
     std::string fileName = "CompileJob-" + std::to_string(GetUniqueID()) + "-output.txt";
     fs::path filePath = dataFolderPath / fileName;
 
-    std::ofstream file(filePath);
-    if (file.is_open()) {
-        file << m_compilationOutput;
-        file.close();
-        // std::cout << "File created: " << filePath << std::endl;
-    } else {
-        std::cerr << "Failed to create the file: " << filePath << std::endl;
-    }
+    JobSystem::CreateOrGet()->GetFileIOService()->WriteFile(filePath.string(), m_compilationOutput);
 }
 
-void CompileJob::setOutputJson(const json& json){
-    m_outputJson = json;
+void CompileJob::setOutputJson(json outputJson){
+    m_outputJson = std::make_shared<const json>(std::move(outputJson));
 }
 
-json CompileJob::GetOutputJson() const{
+std::shared_ptr<const json> CompileJob::GetOutputJson() const {
     return m_outputJson;
 }
 
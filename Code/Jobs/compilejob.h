@@ -1,3 +1,5 @@
+#include <cstdio>
+#include <map>
 #include "../lib/job.h"
 #include "../lib/json.hpp"
 
@@ -6,21 +8,58 @@ using json = nlohmann::json;
 class CompileJob: public Job{
 public:
 
-    // NOTE:    Compile Job accepts either path to make file or its content
-    CompileJob(const char* jsonData = nullptr);
+    // NOTE:    Compile Job accepts either path to make file or its content.
+    //          OR, with "incremental": true, a list of "sources" (globs are fine) built with "compiler" and
+    //          "flags" into "objectDir", then linked into "output". Only the units that changed get rebuilt.
+    CompileJob(const char* jsonData = nullptr): CompileJob(json::parse(jsonData)) {}
+    CompileJob(const json& jsonObject);
     ~CompileJob(){};
 
     // Polymorphic methods Inherited from the "Job"
     void Execute();
     void JobCompleteCallback();
-    void setOutputJson(const json& outputJson);
-    json GetOutputJson() const;
+    void setOutputJson(json outputJson);
+    std::shared_ptr<const json> GetOutputJson() const;
+    bool CanRunInWorkerProcess() const { return !m_isIncremental; } // Incremental builds queue compile units, and use the build manifest
+
+    // The command runs in its own process group, registered on "owner" (if any) so it can be timed out or cancelled
+    static int RunCommand(const std::string& shellCommand, std::string& commandOutput, bool useJobServer, Job* owner = nullptr);
+
+    // RunCommand() in two halves, for callers that read the output themselves (without blocking, for instance)
+    static FILE* StartCommand(const std::string& shellCommand, bool useJobServer, Job* owner = nullptr); // nullptr if it could not be started
+    static int FinishCommand(FILE* commandPipe, Job* owner = nullptr); // Its return code, as pclose() returns it. Gives its jobserver token back.
 
 private:
-    std::string     m_makefileContent;
+    void ExecuteIncremental();
+    void CollectUnitJobs(); // Continuation: collects the unit jobs that are done, suspends on the next one still pending
+    void LinkIncremental(bool isOnWorker); // Once every unit is in. Not on the worker: links in a unit job, and suspends on it.
+    void SetIncrementalOutput();
+    void ReadMakeOutput(); // Continuation: reads what make printed so far, waits for more, or wraps up once it exits
+    void SetMakeOutput(); // Output and result of the job, from "returnCode" and what make printed
+
+    std::shared_ptr<const std::string> m_makefileContent; // Interned: shared by the jobs using the same makefile
+    std::string     m_tempFileName;
+    FILE*           m_makePipe = nullptr; // Set while make runs
+    bool            m_useJobServer = true; // Draw from the job system's token pool, and share it with make's children
+
+    bool                        m_isIncremental = false;
+    std::vector<std::string>    m_sources;
+    std::string                 m_compiler;
+    std::string                 m_compilerFlags;
+    std::string                 m_linkerFlags;
+    std::string                 m_outputPath;
+    std::string                 m_objectDir;
+
+    // State of an incremental build, kept between its continuations
+    std::vector<std::string>                    m_objects; // One per source
+    size_t                                      m_numRebuiltUnits = 0;
+    std::vector< std::pair<size_t, int> >       m_unitJobIDs; // Unit (index in "m_objects"), ID of the job rebuilding it
+    size_t                                      m_numUnitJobsCollected = 0;
+    std::map<size_t, std::string>               m_unitOutputs; // Output of the units rebuilt, by unit
+    bool                                        m_allUnitsSucceeded = true;
 
     int             returnCode; 
     std::string     m_compilationOutput;
 
-    json m_outputJson;
+    std::shared_ptr<const json> m_outputJson;
 };
\ No newline at end of file
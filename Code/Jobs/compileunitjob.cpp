@@ -0,0 +1,81 @@
+#include <iostream>
+#include <string>
+
+#include "../lib/jobsystem.h"
+
+#include "compilejob.h"
+#include "compileunitjob.h"
+
+//json data shape
+//  {
+//     "jobType": 5,
+//     "source": "./Data/testCode/main.cpp",
+//     "object": "./Data/build/Data_testCode_main.o",
+//     "command": "clang++ -g -c ./Data/testCode/main.cpp -o ./Data/build/Data_testCode_main.o -MD -MF ./Data/build/Data_testCode_main.o.d",
+//     "useJobServer": true
+// }
+// A link is a unit too: no source, the output as "object", and its objects as "inputs"
+CompileUnitJob::CompileUnitJob(const json& jsonObject)
+    : Job(jsonObject)
+{
+    m_source = jsonObject.value("source", "");
+    m_object = jsonObject.value("object", "");
+    m_command = jsonObject.value("command", "");
+    m_inputPaths = jsonObject.value("inputs", std::vector<std::string>{});
+    m_useJobServer = jsonObject.value("useJobServer", true);
+}
+
+void CompileUnitJob::Execute(){
+    std::string compilationOutput;
+    int returnCode = BuildUnit(m_source, m_object, m_command, m_useJobServer, compilationOutput, this, m_inputPaths);
+
+    json unitOutputJson;
+    unitOutputJson["jobType"] = 5;
+    unitOutputJson["source"] = m_source;
+    unitOutputJson["object"] = m_object;
+    unitOutputJson["content"] = compilationOutput;
+    unitOutputJson["returnCode"] = returnCode;
+    unitOutputJson["status"] = (returnCode == 0) ? "success" : "failure";
+    SetResult((returnCode == 0) ? JOB_RESULT_SUCCESS : JOB_RESULT_FAILURE);
+    setOutputJson(std::move(unitOutputJson));
+}
+
+int CompileUnitJob::BuildUnit(const std::string& source, const std::string& object, const std::string& command, bool useJobServer, std::string& compilationOutput, Job* owner, const std::vector<std::string>& inputPaths){
+    BuildManifest* manifest = JobSystem::CreateOrGet()->GetBuildManifest();
+
+    // Another job may be building the very same object. Wait for it, it might have done our work.
+    manifest->AcquireOutput(object);
+
+    if(manifest->IsUpToDate(object, command)){
+        compilationOutput = manifest->GetDiagnostics(object);
+        manifest->ReleaseOutput(object);
+        return 0;
+    }
+
+    int returnCode = CompileJob::RunCommand(command, compilationOutput, useJobServer, owner);
+
+    if(returnCode == 0){
+        std::vector<std::string> recordedInputPaths = inputPaths.empty() ? BuildManifest::ParseDepfile(object + ".d") : inputPaths;
+        if(recordedInputPaths.empty()){
+            recordedInputPaths.push_back(source); // No depfile? At least track the source itself
+        }
+        manifest->Record(object, command, recordedInputPaths, compilationOutput);
+    } else {
+        manifest->Forget(object);
+    }
+
+    manifest->ReleaseOutput(object);
+    return returnCode;
+}
+
+void CompileUnitJob::JobCompleteCallback(){
+    // NOTE: Nothing to write. The compile job that spawned this unit reports for all of its units.
+}
+
+void CompileUnitJob::setOutputJson(json outputJson){
+    m_outputJson = std::make_shared<const json>(std::move(outputJson));
+}
+
+std::shared_ptr<const json> CompileUnitJob::GetOutputJson() const {
+    return m_outputJson;
+}
@@ -0,0 +1,32 @@
+#include "../lib/job.h"
+#include "../lib/json.hpp"
+
+using json = nlohmann::json;
+
+// Compiles ONE translation unit of an incremental compile job, and records what it read in the build manifest
+class CompileUnitJob: public Job{
+public:
+    CompileUnitJob(const char* jsonData = nullptr): CompileUnitJob(json::parse(jsonData)) {}
+    CompileUnitJob(const json& jsonObject);
+    ~CompileUnitJob(){};
+
+    // Polymorphic methods Inherited from the "Job"
+    void Execute();
+    void JobCompleteCallback();
+    void setOutputJson(json outputJson);
+    std::shared_ptr<const json> GetOutputJson() const;
+    bool CanRunInWorkerProcess() const { return false; } // Records what it built in the build manifest
+
+    // Also used directly by CompileJob, when there is a single unit to rebuild (not worth a job).
+    // "inputPaths" are what "object" is built from. Empty: read from the compiler's depfile (a link has none).
+    static int BuildUnit(const std::string& source, const std::string& object, const std::string& command, bool useJobServer, std::string& compilationOutput, Job* owner = nullptr, const std::vector<std::string>& inputPaths = {});
+
+private:
+    std::string     m_source;
+    std::string     m_object;
+    std::string     m_command;
+    std::vector<std::string> m_inputPaths; // Given for a link: its objects
+    bool            m_useJobServer = true;
+
+    std::shared_ptr<const json> m_outputJson;
+};
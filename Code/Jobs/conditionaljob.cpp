@@ -3,7 +3,6 @@
 
 #include<vector>
 #include <filesystem>
-#include <fstream>
 
 
 namespace fs = std::filesystem;
@@ -14,20 +13,21 @@ namespace fs = std::filesystem;
 //     "dependencies": [],
 //     "input": {
 //         "logicalOperation": "LOGICAL_OP",
-//         "if_true_job_type": "JOB_TYPE",
+//         "if_true_job_type": "JOB_TYPE",      <- Optional, see below
 //         "else_type_job_type": "JOB_TYPE",
 //         "if_true_input": "JSON_INPUT",
 //         "else_input": "JSON_INPUT",
 //     }
 // }
-LogicalConditionalJob::LogicalConditionalJob(const char* jsonData): Job(jsonData){
-    json jsonObject = json::parse(jsonData);
-    
-    m_logicalOperation = ParseLogicOperation(jsonObject["logicalOperation"]);
-    m_if_true_job_type = jsonObject["if_true_job_type"];
-    m_else_type_job_type = jsonObject["else_type_job_type"];
-    m_if_true_json_input = jsonObject["if_true_input"];
-    m_else_json_input = jsonObject["else_input"];
+// NOTE:    The branches are normally queued along with the conditional job, gated on it (see Job::SetGate).
+//          It only decides, and its output says how: {"conditionMet": true / false}. With the (old) branch
+//          fields, it still creates the job of the branch it takes and queues it itself.
+LogicalConditionalJob::LogicalConditionalJob(const json& jsonObject): Job(jsonObject){
+    m_logicalOperation = ParseLogicOperation(jsonObject.at("logicalOperation"));
+    m_if_true_job_type = jsonObject.value("if_true_job_type", "");
+    m_else_type_job_type = jsonObject.value("else_type_job_type", "");
+    m_if_true_json_input = jsonObject.value("if_true_input", "");
+    m_else_json_input = jsonObject.value("else_input", "");
 
     // m_targetCount = jsonObject.value("targetCount", 1);
 }
@@ -35,10 +35,18 @@ LogicalConditionalJob::LogicalConditionalJob(const char* jsonData): Job(jsonData
 void LogicalConditionalJob::Execute(){
     if(GetDependencies().empty()){
         std::cout << "Conditional job without dependencies. Nothing to work with" << std::endl;
+        setOutputJson({ {"conditionMet", false} });
         return;
     }
+
+    bool conditionMet = EvaluateLogicalCondition();
+    SetResult(JOB_RESULT_SUCCESS); // It decided. Whichever way, that is what it is for.
+    setOutputJson({ {"conditionMet", conditionMet} });
+    if(m_if_true_job_type.empty() && m_else_type_job_type.empty()){
+        return; // The job system releases the branch we took, and skips the other one
+    }
     
-    if (EvaluateLogicalCondition()){
+    if (conditionMet){
         // Conditional Met queue job
         Job* job = JobSystem::CreateOrGet()->CreateJob(m_if_true_job_type, json::parse(m_if_true_json_input.c_str()));
         JobSystem::CreateOrGet()->QueueJob(job);
@@ -49,32 +57,35 @@ void LogicalConditionalJob::Execute(){
     }
 }
 
+// NOTE:    Reads the typed result of each dependency (see JobResult), not their outputs: no lock, no JSON.
+//          A dependency whose output had no "status" counts as neither a success nor a failure.
 bool LogicalConditionalJob::EvaluateLogicalCondition() const{
-    // Get dependencies; statuses
-    std::vector<int> dependencies = GetDependencies();
-    std::vector<std::string> statuses;
+    const std::vector<int>& dependencies = GetDependencies();
+    JobSystem* jobSystem = JobSystem::CreateOrGet();
 
+    int numSuccesses = 0;
+    int numFailures = 0;
     for(int jobId: dependencies){
-        // Get the status of each dependency job
-        json outputJson = JobSystem::CreateOrGet()->GetJsonJobOutputByID(jobId);
-        std::string status = outputJson["status"];
-        statuses.push_back(status);
+        JobResult result = jobSystem->GetJobResult(jobId);
+        numSuccesses += (result == JOB_RESULT_SUCCESS);
+        numFailures += (result == JOB_RESULT_FAILURE);
     }
 
     // Perform the specified logical operation
+    int numDependencies = (int)dependencies.size();
     switch (m_logicalOperation) {
         case LogicalOperation::ALL_SUCCESS:
-            return std::all_of(statuses.begin(), statuses.end(), [](const std::string& status) { return status == "success"; });
+            return numSuccesses == numDependencies;
         case LogicalOperation::ANY_SUCCESS:
-            return std::any_of(statuses.begin(), statuses.end(), [](const std::string& status) { return status == "success"; });
+            return numSuccesses > 0;
         case LogicalOperation::ALL_FAILURE:
-            return std::all_of(statuses.begin(), statuses.end(), [](const std::string& status) { return status == "failure"; });
+            return numFailures == numDependencies;
         case LogicalOperation::ANY_FAILURE:
-            return std::any_of(statuses.begin(), statuses.end(), [](const std::string& status) { return status == "failure"; });
+            return numFailures > 0;
         case LogicalOperation::N_SUCCESS:
-            return std::count(statuses.begin(), statuses.end(), "success") >= m_targetCount;
+            return numSuccesses >= m_targetCount;
         case LogicalOperation::N_FAILURE:
-            return std::count(statuses.begin(), statuses.end(), "failure") >= m_targetCount;
+            return numFailures >= m_targetCount;
     }
 
     return false; // Invalid operation, consider condition not met
@@ -103,21 +114,14 @@ void LogicalConditionalJob::JobCompleteCallback(){
     std::string fileName = "ConditionalJob-" + std::to_string(GetUniqueID()) + "-output.txt";
     fs::path filePath = dataFolderPath / fileName;
 
-    std::ofstream file(filePath);
-    if (file.is_open()) {
-        file << "Conditional job ran successfully";
-        file.close();
-        // std::cout << "File created: " << filePath << std::endl;
-    } else {
-        std::cerr << "Failed to create the file: " << filePath << std::endl;
-    }
+    JobSystem::CreateOrGet()->GetFileIOService()->WriteFile(filePath.string(), "Conditional job ran successfully");
 
 }
 
-void LogicalConditionalJob::setOutputJson(const json& json){
-    m_outputJson = json;
+void LogicalConditionalJob::setOutputJson(json outputJson){
+    m_outputJson = std::make_shared<const json>(std::move(outputJson));
 }
 
-json LogicalConditionalJob::GetOutputJson() const {
+std::shared_ptr<const json> LogicalConditionalJob::GetOutputJson() const {
     return m_outputJson;
 }
@@ -15,13 +15,15 @@ class LogicalConditionalJob: public Job{
     };
 
     public:
-    LogicalConditionalJob(const char* jsonData = nullptr);
+    LogicalConditionalJob(const char* jsonData = nullptr): LogicalConditionalJob(json::parse(jsonData)) {}
+    LogicalConditionalJob(const json& jsonObject);
     ~LogicalConditionalJob(){};
 
     void Execute();
     void JobCompleteCallback();
-    void setOutputJson(const json& outputJson);
-    json GetOutputJson() const;
+    void setOutputJson(json outputJson);
+    std::shared_ptr<const json> GetOutputJson() const;
+    bool CanRunInWorkerProcess() const { return false; } // Reads the outputs of its dependencies from the job system (and may queue a job)
 
     private:
     LogicalOperation ParseLogicOperation(const std::string& operation) const;
@@ -37,5 +39,5 @@ class LogicalConditionalJob: public Job{
     int m_targetCount = 1;
 
 
-    json m_outputJson;
+    std::shared_ptr<const json> m_outputJson;
 };
\ No newline at end of file
@@ -2,7 +2,6 @@
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <fstream>
 #include <filesystem>
 
 namespace fs = std::filesystem;
@@ -13,25 +12,39 @@ void JsonJob::Execute(){
         // NOTE: This type of jobs expects only one dependent. The rest is IGNORED.
         int compileJobID = GetDependencies().at(0);
         // Retreive the JSON output of the dependent (i.e. compile job) from the job history located in the job system
-        json compileJobOutput = JobSystem::CreateOrGet()->GetJsonJobOutputByID(compileJobID);
-        m_json = compileJobOutput["jsonContent"];
+        std::shared_ptr<const json> compileJobOutput = JobSystem::CreateOrGet()->GetJobOutputByID(compileJobID);
+        // We add context to the diagnostics, so this part (only) has to be copied
+        m_json = (compileJobOutput && compileJobOutput->contains("jsonContent")) ? compileJobOutput->at("jsonContent") : json::object();
     } else {
         m_json["status"] = "failure";
-        setOutputJson(m_json);
+        SetResult(JOB_RESULT_FAILURE);
+        setOutputJson(std::move(m_json));
         std::cout << "ERROR: No dependencies: Nothing to work with" << std::endl;
         return;
     }
 
+    // NOTE:    Every file with diagnostics is read in one batch (it used to be read again for each of its
+    //          diagnostics, blocking). The job suspends until they are all in, its worker moves on meanwhile.
+    m_sourceFiles = std::make_shared<FileIOBatch>();
+    for (auto& entry: m_json.items()) {
+        m_sourceFiles->Read(entry.key());
+    }
+    JobSystem::CreateOrGet()->GetFileIOService()->Submit(m_sourceFiles);
+    AwaitReadable(m_sourceFiles->GetCompletionFD(), [this](){ AddContextLines(); });
+}
+
+void JsonJob::AddContextLines(){
     // Extract file name and line number from the JSON
+    size_t fileIndex = 0;
     for (auto& entry: m_json.items()) {
-        auto& fileName = entry.key();
+        const std::string& fileContent = m_sourceFiles->GetData(fileIndex++); // Empty if it could not be read
         auto& diagnostics = entry.value();
 
         for (auto& diagnostic : diagnostics) {
             int lineNumber = diagnostic["lineNumber"];
             
             // Read lines before and after the specified line number
-            auto contextLines = readContextLines(fileName, lineNumber);
+            auto contextLines = readContextLines(fileContent, lineNumber);
 
             // Add the context lines to the JSON object
             diagnostic["contextBefore"] = contextLines.first;
@@ -39,9 +52,12 @@ void JsonJob::Execute(){
         }
     }
 
+    m_sourceFiles = nullptr;
+
     // Set JSON job output
     m_json["status"] = "success";
-    setOutputJson(m_json);
+    SetResult(JOB_RESULT_SUCCESS);
+    setOutputJson(std::move(m_json));
 }
 
 void JsonJob::JobCompleteCallback(){
@@ -56,22 +72,12 @@ void JsonJob::JobCompleteCallback(){
     std::string fileName = "JsonJob-" + std::to_string(GetUniqueID()) + "-output.txt";
     fs::path filePath = dataFolderPath / fileName;
 
-    std::ofstream file(filePath);
-    if (file.is_open()) {
-        file << m_json.dump(4);
-        file.close();
-        // std::cout << "File created: " << filePath << std::endl;
-    } else {
-        std::cerr << "Failed to create the file: " << filePath << std::endl;
-    }
+    JobSystem::CreateOrGet()->GetFileIOService()->WriteFile(filePath.string(), (m_outputJson ? *m_outputJson : m_json).dump(4)); // "m_json" was moved into the output
 }
 
-std::pair<std::string, std::string> JsonJob::readContextLines(const std::string& fileName, int lineNumber){
+std::pair<std::string, std::string> JsonJob::readContextLines(const std::string& fileContent, int lineNumber){
     
-    std::ifstream file(fileName);
-    if (!file.is_open()) {
-        return {"", ""}; // Return empty strings if the file cannot be opened
-    }
+    std::istringstream file(fileContent);
 
     std::string line;
     std::string contextBefore = "";
@@ -90,10 +96,10 @@ std::pair<std::string, std::string> JsonJob::readContextLines(const std::string&
     return {contextBefore, contextAfter};
 }
 
-void JsonJob::setOutputJson(const json& json){
-    m_outputJson = json;
+void JsonJob::setOutputJson(json outputJson){
+    m_outputJson = std::make_shared<const json>(std::move(outputJson));
 }
 
-json JsonJob::GetOutputJson() const {
+std::shared_ptr<const json> JsonJob::GetOutputJson() const {
     return m_outputJson;
 }
\ No newline at end of file
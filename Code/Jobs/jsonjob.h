@@ -6,20 +6,23 @@ using json = nlohmann::json;
 
 class JsonJob: public Job{
 public:
-    JsonJob(const char* jsonData = nullptr): Job(jsonData){
-        json jsonObject = json::parse(jsonData);
+    JsonJob(const char* jsonData = nullptr): JsonJob(json::parse(jsonData)) {}
+    JsonJob(const json& jsonObject): Job(jsonObject){
         m_json = jsonObject.value("jsonContent", json{});
     }
     ~JsonJob(){};
 
     void Execute();
     void JobCompleteCallback();
-    void setOutputJson(const json& outputJson);
-    json GetOutputJson() const;
+    void setOutputJson(json outputJson);
+    std::shared_ptr<const json> GetOutputJson() const;
 
 private:
+    void AddContextLines(); // Continuation, once the source files are read
+
     json m_json;
-    static std::pair<std::string, std::string> readContextLines(const std::string& fileName, int lineNumber);
+    std::shared_ptr<FileIOBatch> m_sourceFiles; // One read per file with diagnostics
+    static std::pair<std::string, std::string> readContextLines(const std::string& fileContent, int lineNumber);
 
-    json m_outputJson;
+    std::shared_ptr<const json> m_outputJson;
 };
\ No newline at end of file
@@ -4,7 +4,6 @@
 #include <algorithm>
 #include <cctype>
 #include <filesystem>
-#include <fstream>
 #include <string>
 
 #include "../lib/jobsystem.h"
@@ -22,6 +21,8 @@ struct Diagnostic {
 };
 
 void ParsingJob::Execute(){
+    std::shared_ptr<const json> compileJobOutput; // Keeps the compile job's output alive while we read its log in place
+    const std::string* content = &m_content;
 
     // If there are dependencies...
     if (!GetDependencies().empty()) {
@@ -29,8 +30,10 @@ void ParsingJob::Execute(){
         // NOTE: This type of jobs expects only one dependent. The rest is IGNORED.
         int compileJobID = GetDependencies().at(0);
         // Retreive the JSON output of the dependent (i.e. compile job) from the job history located in the job system
-        json compileJobOutput = JobSystem::CreateOrGet()->GetJsonJobOutputByID(compileJobID);
-        m_content = compileJobOutput["content"];
+        compileJobOutput = JobSystem::CreateOrGet()->GetJobOutputByID(compileJobID);
+        if (compileJobOutput && compileJobOutput->contains("content") && compileJobOutput->at("content").is_string()) {
+            content = &compileJobOutput->at("content").get_ref<const std::string&>();
+        }
     } else {
         std::cout << "ERROR: No dependencies: Nothing to parse" << std::endl;
 
@@ -40,17 +43,24 @@ void ParsingJob::Execute(){
         parsingOutputJson["jobType"] = 3;
         parsingOutputJson["jsonContent"] = "";
         parsingOutputJson["status"] = "failure";
-        setOutputJson(parsingOutputJson);
+        SetResult(JOB_RESULT_FAILURE);
+        setOutputJson(std::move(parsingOutputJson));
 
         return;
     }
     
     std::string line;
-    std::istringstream error_stream(m_content);
     std::vector< std::vector< std::string > > diagnosticData;
 
-    // Parse warnings and errors, if any...
-    while (std::getline(error_stream, line)) {
+    // Parse warnings and errors, if any... One line at a time, in place. An istringstream would copy the whole log once more.
+    size_t lineStart = 0;
+    while (lineStart < content->size()) {
+        size_t lineEnd = content->find('\n', lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = content->size();
+        }
+        line.assign(*content, lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
         
         if (line.find("error") != std::string::npos) {
             // Split line - separator is ":"
@@ -128,7 +138,8 @@ void ParsingJob::Execute(){
     parsingOutputJson["jobType"] = 3;
     parsingOutputJson["jsonContent"] = m_parsedContent;
     parsingOutputJson["status"] = "success";
-    setOutputJson(parsingOutputJson);
+    SetResult(JOB_RESULT_SUCCESS);
+    setOutputJson(std::move(parsingOutputJson));
 }
 
 void ParsingJob::JobCompleteCallback(){
@@ -143,14 +154,7 @@ void ParsingJob::JobCompleteCallback(){
     std::string fileName = "ParsingJob-" + std::to_string(GetUniqueID()) + "-output.txt";
     fs::path filePath = dataFolderPath / fileName;
 
-    std::ofstream file(filePath);
-    if (file.is_open()) {
-        file << m_parsedContent.dump(4);
-        file.close();
-        // std::cout << "File created: " << filePath << std::endl;
-    } else {
-        std::cerr << "Failed to create the file: " << filePath << std::endl;
-    }
+    JobSystem::CreateOrGet()->GetFileIOService()->WriteFile(filePath.string(), m_parsedContent.dump(4));
 }
 
 std::vector<std::string> ParsingJob::splitLine(const std::string& line, char delimiter) {
@@ -183,10 +187,10 @@ std::string ParsingJob::trim(const std::string& input) {
     return std::string(start, end);
 }
 
-void ParsingJob::setOutputJson(const json& json) {
-    m_outputJson = json;
+void ParsingJob::setOutputJson(json outputJson){
+    m_outputJson = std::make_shared<const json>(std::move(outputJson));
 }
 
-json ParsingJob::GetOutputJson() const {
+std::shared_ptr<const json> ParsingJob::GetOutputJson() const {
     return m_outputJson;
 }
\ No newline at end of file
@@ -6,16 +6,16 @@ using json = nlohmann::json;
 
 class ParsingJob: public Job{
 public:    
-    ParsingJob(const char* jsonData = nullptr): Job(jsonData){
-        json jsonObject = json::parse(jsonData);
+    ParsingJob(const char* jsonData = nullptr): ParsingJob(json::parse(jsonData)) {}
+    ParsingJob(const json& jsonObject): Job(jsonObject){
         m_content = jsonObject.value("content", "");
     }
     ~ParsingJob(){};
 
     void Execute();
     void JobCompleteCallback();
-    void setOutputJson(const json& outputJson);
-    json GetOutputJson() const;
+    void setOutputJson(json outputJson);
+    std::shared_ptr<const json> GetOutputJson() const;
 
 private:
     std::string     m_content;
@@ -24,5 +24,5 @@ private:
     static std::vector<std::string> splitLine(const std::string& line, char delimiter);
     static std::string trim(const std::string& input);
 
-    json m_outputJson;
+    std::shared_ptr<const json> m_outputJson;
 };
\ No newline at end of file
@@ -68,10 +68,12 @@ class Var(Stmt):
 		return visitor.visit_var_stmt(self)
 
 class JobDeclaration(Stmt):
-	def __init__(self, job_identifier, job_type, input):
+	def __init__(self, job_identifier, job_type, input, priority, foreach):
 		self.job_identifier = job_identifier
 		self.job_type = job_type
 		self.input = input
+		self.priority = priority
+		self.foreach = foreach
 	
 	def accept(self, visitor: Visitor):
 		return visitor.visit_jobdeclaration_stmt(self)
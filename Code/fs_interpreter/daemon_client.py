@@ -0,0 +1,86 @@
+# Talks to a running jobsystemd (see Code/lib/jobsystemdaemon.h) over its Unix domain socket.
+# Pure Python, on top of the same frames the worker processes use: a FlowScript run with --daemon starts no job system of its own.
+#
+#   ./Code/jobsystemd.out &
+#   python3 Code/fs_interpreter/flowscript.py --daemon ./Data/jobsystemd.sock Data/FlowScript/dependency.fscript
+import json
+import socket
+import struct
+
+DEFAULT_DAEMON_SOCKET = "./Data/jobsystemd.sock"
+
+# NOTE: Frame header: size of the message (uint32, native byte order, both ends are on this machine), then its encoding
+FRAME_HEADER = struct.Struct("=IB")
+FRAME_FORMAT_JSON = 0 # JOB_DATA_FORMAT_JSON. The daemon replies in the encoding it was asked in.
+
+
+class DaemonError(Exception):
+    pass
+
+
+class DaemonClient:
+    def __init__(self, socket_path: str = DEFAULT_DAEMON_SOCKET):
+        self.socket_path = socket_path
+        self.socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            self.socket.connect(socket_path)
+        except OSError as error:
+            self.socket.close()
+            raise DaemonError(f"No job system daemon listens on '{socket_path}' ({error.strerror}). Start one with ./Code/jobsystemd.out") from None
+
+    def close(self):
+        self.socket.close()
+
+    def request(self, op: str, **arguments) -> dict:
+        message = json.dumps({"op": op, **arguments}).encode('utf-8')
+        try:
+            self.socket.sendall(FRAME_HEADER.pack(len(message), FRAME_FORMAT_JSON) + message)
+            size, _ = FRAME_HEADER.unpack(self._receive(FRAME_HEADER.size))
+            reply = json.loads(self._receive(size))
+        except OSError as error:
+            raise DaemonError(f"Lost the connection to the job system daemon ({error.strerror})") from None
+        if "error" in reply:
+            raise DaemonError(reply["error"])
+        return reply
+
+    def _receive(self, size: int) -> bytes:
+        data = bytearray()
+        while len(data) < size:
+            chunk = self.socket.recv(size - len(data))
+            if not chunk:
+                raise DaemonError("The job system daemon closed the connection")
+            data += chunk
+        return bytes(data)
+
+    # One helper per op
+    def submit(self, jobs: list) -> dict:
+        return self.request("submit", jobs=jobs)["jobIDs"]
+
+    def status(self, ids: list) -> list:
+        return self.request("status", ids=ids)["statuses"]
+
+    def status_and_results(self, ids: list) -> tuple:
+        # How the jobs went too (see JOB_RESULT_NAMES), 0 until they completed. From the same request.
+        reply = self.request("status", ids=ids)
+        return reply["statuses"], reply["results"]
+
+    def wait(self, ids: list) -> list:
+        return self.request("wait", ids=ids)["statuses"]
+
+    def outputs(self, ids: list) -> list:
+        return self.request("outputs", ids=ids)["outputs"]
+
+    def finish(self, ids: list) -> list:
+        return self.request("finish", ids=ids)["finished"]
+
+    def cancel(self, ids: list, recursive: bool = True) -> int:
+        return self.request("cancel", ids=ids, recursive=recursive)["cancelled"]
+
+    def job_types(self) -> list:
+        return self.request("job_types")["jobTypes"]
+
+    def ping(self) -> dict:
+        return self.request("ping")
+
+    def shutdown(self):
+        self.request("shutdown")
@@ -17,16 +17,31 @@ class FlowScript:
     def main():
         parser = argparse.ArgumentParser(description="Run the Lox interpreter.")
         parser.add_argument("script", nargs="?", help="Path to the Lox script to execute.")
+        parser.add_argument("--critical-path", action="store_true", help="Run the jobs on the longest dependency chains first.")
+        parser.add_argument("--pin-workers", action="store_true", help="Give compile workers whole cores, and let parsing/JSON workers share SMT siblings.")
+        parser.add_argument("--journal", metavar="FILE", help="Journal the jobs to FILE. If a previous run crashed, resume its unfinished jobs instead of submitting new ones.")
+        parser.add_argument("--history-store", metavar="FOLDER", help="Keep the status and output of every job in FOLDER, after the run too.")
+        parser.add_argument("--worker-processes", action="store_true", help="Run compile jobs in separate jobworker processes, so a crashing compile cannot take the job system down.")
+        parser.add_argument("--submission-ring", metavar="NAME", help="Let other processes submit jobs through the shared-memory ring NAME (see Code/tools/ring_client.py).")
+        parser.add_argument("--daemon", metavar="SOCKET", help="Submit the jobs to the jobsystemd listening on SOCKET (it listens on ./Data/jobsystemd.sock by default), instead of starting a job system.")
+        parser.add_argument("--no-reduce", action="store_true", help="Keep every dependency of the script, even the ones already implied by other dependencies.")
+        parser.add_argument("--no-cse", action="store_true", help="Run every job of the script, even the ones identical to another (same type, input and dependencies).")
+        parser.add_argument("--lazy", action="store_true", help="Submit the graph as compact nodes: a job is only created once its dependencies are done, and freed once it completed. For very large graphs.")
+        parser.add_argument("--incremental", metavar="FILE", help="Keep the graph and the outputs of the run in FILE. The next run only runs the jobs that changed (and what depends on them), and reuses the others' outputs.")
+        parser.add_argument("--native-scanner", action="store_true", help="Tokenize the script in the job system library (memory-mapped, one pass), instead of in Python. For very large scripts.")
         args = parser.parse_args()
 
         if args.script:
-            FlowScript.run_file(args.script)
+            FlowScript.run_file(args.script, args.critical_path, args.pin_workers, args.journal, args.history_store, args.worker_processes, args.submission_ring, args.daemon, not args.no_cse, not args.no_reduce, args.lazy, args.native_scanner, args.incremental)
 
     @staticmethod
-    def run_file(path: str):
-        with open(path, 'r') as file:
-            source = file.read()
-        FlowScript.run(source)
+    def run_file(path: str, critical_path: bool = False, pin_workers: bool = False, journal: str = None, history_store: str = None, worker_processes: bool = False, submission_ring: str = None, daemon: str = None, cse: bool = True, reduce_dependencies: bool = True, lazy: bool = False, native_scanner: bool = False, incremental: str = None):
+        if native_scanner:
+            tokens = scanner.NativeTokens(path)
+        else:
+            with open(path, 'r') as file:
+                tokens = scanner.Scanner(file.read()).scan_tokens()
+        FlowScript.run_tokens(tokens, critical_path, pin_workers, journal, history_store, worker_processes, submission_ring, daemon, cse, reduce_dependencies, lazy, incremental)
 
         if FlowScript.had_error:
             sys.exit(65)
@@ -34,10 +49,12 @@ class FlowScript:
             sys.exit(70)
     
     
-    def run(source: str):
+    def run(source: str, critical_path: bool = False, pin_workers: bool = False, journal: str = None, history_store: str = None, worker_processes: bool = False, submission_ring: str = None, daemon: str = None, cse: bool = True, reduce_dependencies: bool = True, lazy: bool = False):
         lexer = scanner.Scanner(source)
         tokens = lexer.scan_tokens()
+        FlowScript.run_tokens(tokens, critical_path, pin_workers, journal, history_store, worker_processes, submission_ring, daemon, cse, reduce_dependencies, lazy)
 
+    def run_tokens(tokens, critical_path: bool = False, pin_workers: bool = False, journal: str = None, history_store: str = None, worker_processes: bool = False, submission_ring: str = None, daemon: str = None, cse: bool = True, reduce_dependencies: bool = True, lazy: bool = False, incremental: str = None):
         parser = fsParser.Parser(tokens)
         statements = parser.parse()
 
@@ -52,7 +69,7 @@ class FlowScript:
 
         # At this point, the parser have IDENTIFIED All TYPE of statements the user have typed,
         # Now, it is the responsibility of the interpreter to 'execute' those statements.
-        interpreter = Interpreter()
+        interpreter = Interpreter(critical_path, pin_workers, journal, history_store, worker_processes, submission_ring, daemon, cse, reduce_dependencies, lazy, incremental)
         interpreter.interpret(statements)
         
 
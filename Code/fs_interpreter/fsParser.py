@@ -1,5 +1,6 @@
 import sys
 import flowscript
+import scanner
 import Stmt
 import Expr
 
@@ -13,8 +14,11 @@ class Parser:
     class ParseError(RuntimeError):
         pass
     
+    # NOTE: "tokens" is a list of Token, or the NativeTokens of the native scanner. Either way, checking the type
+    #       of a token only reads "token_types", without building a Token.
     def __init__(self, tokens: List[Token]) -> None:
         self.tokens = tokens
+        self.token_types = tokens.token_types if isinstance(tokens, scanner.NativeTokens) else [token.type for token in tokens]
         self.current = 0
 
     def parse(self):
@@ -117,10 +121,39 @@ class Parser:
         self.consume(TokenType.INPUT, "Expect 'input' parameter. When declared Jobs must be given an JSON input")
         self.consume(TokenType.EQUAL, "Expect '=' after 'input'.")
         input = self.assignment() # input can of type 'Expr.Variable' , or a 'STRING', but we take it as is :)
+
+        # Parsing the optional attributes, in any order
+        priority = None
+        foreach = None
+        while True:
+            # Jobs with a higher priority get picked first by the job system
+            if priority is None and self.match(TokenType.PRIORITY):
+                self.consume(TokenType.EQUAL, "Expect '=' after 'priority'.")
+                priority = self.consume(TokenType.NUMBER, "Expect a number after 'priority'.")
+
+            # A fan-out: one job per item, either a list of items "(a, b, c)" or a glob pattern
+            elif foreach is None and self.match(TokenType.FOREACH):
+                self.consume(TokenType.EQUAL, "Expect '=' after 'foreach'.")
+                foreach = self.foreach_items()
+            else:
+                break
+
         self.consume(TokenType.RIGHT_BRACK, "Expect a closing ']' after the input")
         self.consume(TokenType.SEMICOLON, "Semicolon expected at the end of statement.")
 
-        return Stmt.JobDeclaration(job_id, job_type, input)
+        return Stmt.JobDeclaration(job_id, job_type, input, priority, foreach)
+
+    def foreach_items(self):
+        # A glob pattern: a string or a variable, like the input
+        if not self.match(TokenType.LEFT_PAREN):
+            return self.assignment()
+
+        # A list of items
+        items = [self.assignment()]
+        while self.match(TokenType.COMMA):
+            items.append(self.assignment())
+        self.consume(TokenType.RIGHT_PAREN, "Expect a closing ')' after the 'foreach' items.")
+        return items
 
     def conditional_job_declaration(self, job_id: Token):
         # Parse shape for conditional jobs
@@ -210,7 +243,7 @@ class Parser:
     def match(self, *types: TokenType):
         for token_type in types:
             if self.check(token_type):
-                self.advance()
+                self.current += 1 # Not at the end, check() says so. advance() would build the Token for nothing.
                 return True
         
         return False
@@ -218,7 +251,8 @@ class Parser:
     # Is the current token the expected type? Make advance. If no... error and show message
     def consume(self, token_type: TokenType, message: str):
         if self.check(token_type):
-            return self.advance()
+            self.current += 1
+            return self.previous()
         
         raise self.error(self.previous(), message)
     
@@ -234,7 +268,7 @@ class Parser:
         if self.is_at_end():
             return False
         
-        return self.peek().type == token_type
+        return self.token_types[self.current] is token_type
     
     def advance(self) -> Token:
         if not self.is_at_end():
@@ -243,7 +277,7 @@ class Parser:
         return self.previous()
     
     def is_at_end(self) -> bool:
-        return self.peek().type == TokenType.EOF
+        return self.token_types[self.current] is TokenType.EOF
     
     # Give me the current token
     def peek(self) -> Token:
@@ -0,0 +1,247 @@
+# Passes over the job graph the interpreter staged, run before any job is submitted.
+# The graph is the staging area: job name -> {"type": bytes, "input": bytes, "dependencies": [names], "priority"?: int, "foreach"?: glob or [items],
+#                                     "gate"?: [name of a conditional job, whether the job runs if its condition is met]}
+# A fan-out ("foreach") is a single node: the job system expands it, and its dependencies apply to all of its jobs.
+import glob
+import hashlib
+import json
+import os
+
+
+def topological_order(staging_area: dict) -> list:
+    # Every job after the jobs it depends on. Jobs on a cycle (or waiting on one) come last, in declaration order.
+    num_dependencies = {name: len(set(job["dependencies"])) for name, job in staging_area.items()}
+    dependents = {name: [] for name in staging_area}
+    for name, job in staging_area.items():
+        for dependency in set(job["dependencies"]):
+            dependents[dependency].append(name)
+
+    order = [name for name in staging_area if num_dependencies[name] == 0]
+    for name in order: # Grows while we walk it
+        for dependent in dependents[name]:
+            num_dependencies[dependent] -= 1
+            if num_dependencies[dependent] == 0:
+                order.append(dependent)
+
+    ordered = set(order)
+    return order + [name for name in staging_area if name not in ordered]
+
+
+def job_input_key(job_input: bytes) -> str:
+    # Same JSON, same key: the key order and the spacing of the script do not matter
+    text = job_input.rstrip(b'\0').decode('utf-8')
+    try:
+        return json.dumps(json.loads(text), sort_keys=True, separators=(',', ':'))
+    except ValueError:
+        return text
+
+
+# NOTE: Common subexpression elimination. Two jobs with the same type, the same input and the same
+#       (already merged) dependencies compute the same thing, so only the first one is kept. Its
+#       output fans out to the dependents of both. Walking the graph in topological order merges
+#       whole identical chains: once two compile jobs are one, the parsing jobs on top of them
+#       have the same dependencies too. Dependencies keep their order (a JSON job only reads its first).
+def eliminate_common_subexpressions(staging_area: dict):
+    # Returns the new staging area, and the merged jobs: name -> name of the job that runs in its place
+    merged_into = {}
+    kept_by_key = {}
+
+    for name in topological_order(staging_area):
+        job = staging_area[name]
+
+        dependencies = []
+        for dependency in job["dependencies"]:
+            dependency = merged_into.get(dependency, dependency)
+            if dependency not in dependencies:
+                dependencies.append(dependency)
+        job["dependencies"] = dependencies
+        if "gate" in job:
+            job["gate"] = [merged_into.get(job["gate"][0], job["gate"][0]), job["gate"][1]]
+
+        key = (job["type"], job_input_key(job["input"]), tuple(dependencies), json.dumps(job.get("foreach")), json.dumps(job.get("gate")))
+        if key not in kept_by_key:
+            kept_by_key[key] = name
+            continue
+
+        # Runs once, as soon as the most urgent of them would have
+        kept_job = staging_area[kept_by_key[key]]
+        if "priority" in job:
+            kept_job["priority"] = max(kept_job.get("priority", job["priority"]), job["priority"])
+        merged_into[name] = kept_by_key[key]
+
+    optimized = {name: job for name, job in staging_area.items() if name not in merged_into}
+    return optimized, merged_into
+
+
+class DependencyCycleError(ValueError):
+    def __init__(self, cycle: list):
+        super().__init__(" -> ".join(cycle))
+        self.cycle = cycle # Job names, as the script's "A -> B" statements go. The first one is repeated at the end.
+
+
+def topological_levels(staging_area: dict) -> dict:
+    # Job name -> 0 for the jobs without dependencies, else 1 + the highest level of their dependencies.
+    # Jobs of the same level never depend on each other. Raises DependencyCycleError.
+    levels = {}
+    for name in topological_order(staging_area):
+        dependencies = staging_area[name]["dependencies"]
+        if any(dependency not in levels for dependency in dependencies):
+            raise DependencyCycleError(find_cycle(staging_area, levels))
+        levels[name] = 1 + max((levels[dependency] for dependency in dependencies), default=-1)
+    return levels
+
+
+def find_cycle(staging_area: dict, levels: dict) -> list:
+    # NOTE: Every job Kahn's walk could not reach still has a dependency it could not reach either, so following
+    #       those from any of them has to come back to a job it already went through, in at most one step per job.
+    name = next(name for name in staging_area if name not in levels)
+    path = []
+    step_of = {}
+    while name not in step_of:
+        step_of[name] = len(path)
+        path.append(name)
+        name = next(dependency for dependency in staging_area[name]["dependencies"] if dependency not in levels)
+
+    cycle = path[step_of[name]:] + [name]
+    cycle.reverse() # We followed dependencies: target to source
+    return cycle
+
+
+# NOTE: Transitive reduction. When a job depends on B and on C, and C already depends on B (directly or
+#       not), the B dependency is redundant: the job system would check it for nothing. For each job with
+#       several dependencies, we walk down from its dependencies, highest level first. A dependency met on
+#       the way down from another one is dropped. The walk never goes below the lowest level of the job's
+#       dependencies, since nothing down there can be one of them. Build graphs are shallow, so that is
+#       usually a few steps per edge. The exact reduction is not linear in the worst case though (a wide,
+#       deep lattice), so the walks share a budget proportional to the size of the graph: once it is spent,
+#       the remaining edges are kept as they are. That is always correct, just not minimal.
+#       A glob fan-out may match nothing: what depends on it does not depend on anything through it, so
+#       the walks stop there. (A list fan-out has at least one job.)
+#       Some jobs read their dependencies: JSON and parsing jobs read the output of their FIRST one (never
+#       dropped), and conditional jobs check the status of every one of them (not reduced at all).
+def reduce_transitive_dependencies(staging_area: dict, levels: dict, budget_per_edge: int = 8):
+    # Edits the staging area. Returns the number of dependencies dropped.
+    num_edges = sum(len(job["dependencies"]) for job in staging_area.values())
+    budget = budget_per_edge * (len(staging_area) + num_edges)
+    num_dropped = 0
+    reached_by = {} # Job name -> the job whose walk reached it last. Saves clearing a visited set for each job.
+
+    for name, job in staging_area.items():
+        if job["type"] == b"CONDITIONAL_JOB":
+            continue
+        dependencies = list(dict.fromkeys(job["dependencies"]))
+        if len(dependencies) < 2:
+            job["dependencies"] = dependencies
+            continue
+
+        lowest_level = min(levels[dependency] for dependency in dependencies)
+        redundant = set()
+        for dependency in sorted(dependencies, key=lambda dependency: -levels[dependency]):
+            if reached_by.get(dependency) == name:
+                redundant.add(dependency) # A higher dependency already depends on it
+                continue
+            if budget <= 0:
+                break
+
+            reached_by[dependency] = name
+            stack = [dependency]
+            while stack and budget > 0:
+                job_below = staging_area[stack.pop()]
+                if isinstance(job_below.get("foreach"), str):
+                    continue
+                for below in job_below["dependencies"]:
+                    budget -= 1
+                    if levels[below] >= lowest_level and reached_by.get(below) != name:
+                        reached_by[below] = name
+                        stack.append(below)
+
+        redundant.discard(dependencies[0])
+        job["dependencies"] = [dependency for dependency in dependencies if dependency not in redundant]
+        num_dropped += len(redundant)
+
+    return num_dropped
+
+
+
+# Compile jobs read files the graph knows nothing about: the ones next to their makefile, or next to the sources
+# they list. Those folders are part of their fingerprint. A makefile given inline could read anything: no fingerprint,
+# they always run again, and so does everything downstream of them. (Incremental compile jobs only rebuild the units
+# that changed anyway, see BuildManifest.)
+COMPILE_JOB_TYPES = {b"COMPILE_JOB", b"COMPILE_UNIT_JOB"}
+
+
+def compile_input_folders(job_input: bytes):
+    # The folders a compile job reads, or None if they cannot be told from its input
+    try:
+        parsed = json.loads(job_input.rstrip(b'\0'))
+    except ValueError:
+        return None
+    paths = list(parsed.get("sources", []))
+    if "source" in parsed:
+        paths.append(parsed["source"])
+    if "makefile" in parsed:
+        if not parsed.get("isFilePath", True):
+            return None
+        paths.append(parsed["makefile"])
+    if not paths:
+        return None
+
+    folders = set()
+    for path in paths:
+        first_wildcard = min([path.index(c) for c in "*?[" if c in path], default=len(path))
+        folders.add(os.path.dirname(path[:first_wildcard]) or ".")
+    return sorted(folders)
+
+
+def folder_digest(folder: str) -> str:
+    # Every file under the folder: its path and a hash of its content
+    digest = hashlib.sha256()
+    for root, dirs, files in os.walk(folder):
+        dirs.sort()
+        for file_name in sorted(files):
+            file_path = os.path.join(root, file_name)
+            try:
+                with open(file_path, 'rb') as file:
+                    content_hash = hashlib.sha256(file.read()).hexdigest()
+            except OSError:
+                content_hash = None
+            digest.update(json.dumps([os.path.relpath(file_path, folder), content_hash]).encode('utf-8'))
+    return digest.hexdigest()
+
+
+# NOTE: Fingerprints for incremental runs. A job's content key covers what it computes from: its type, its input
+#       (see job_input_key), its fan-out items (a glob, as the paths it matches now), which branch of its conditional
+#       job it is, and for a compile job, the files it reads. Its fingerprint adds the fingerprints of its
+#       dependencies, in order (a conditional job is one), so editing one job changes the fingerprint of everything
+#       downstream of it, and of nothing else. Two runs of a job with the same fingerprint compute the same thing.
+#       The priority is left out: it changes when a job runs, not what it computes.
+def fingerprint_jobs(staging_area: dict) -> dict:
+    # Job name -> (fingerprint or None, content key). Expects the jobs in topological order (see topological_levels).
+    fingerprints = {}
+    folder_digests = {} # Jobs compiling the same folder only read it once
+    for name, job in staging_area.items():
+        foreach = job.get("foreach")
+        if isinstance(foreach, str):
+            foreach = {"glob": foreach, "paths": sorted(glob.glob(foreach))}
+        gate = job["gate"][1] if "gate" in job else None
+        is_volatile = False
+        read_folders = None
+        if job["type"] in COMPILE_JOB_TYPES:
+            folders = compile_input_folders(job["input"])
+            is_volatile = folders is None
+            if folders is not None:
+                read_folders = {}
+                for folder in folders:
+                    if folder not in folder_digests:
+                        folder_digests[folder] = folder_digest(folder)
+                    read_folders[folder] = folder_digests[folder]
+        content = json.dumps([job["type"].decode('utf-8'), job_input_key(job["input"]), foreach, gate, read_folders])
+        content_key = hashlib.sha256(content.encode('utf-8')).hexdigest()
+
+        dependency_fingerprints = [fingerprints[dependency][0] for dependency in job["dependencies"]]
+        if is_volatile or None in dependency_fingerprints:
+            fingerprints[name] = (None, content_key)
+            continue
+        fingerprint = hashlib.sha256(json.dumps([content_key, dependency_fingerprints]).encode('utf-8')).hexdigest()
+        fingerprints[name] = (fingerprint, content_key)
+    return fingerprints
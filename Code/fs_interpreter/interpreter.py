@@ -1,6 +1,7 @@
 import Stmt
 import Expr
 import flowscript
+import os
 import json
 import ctypes
 from ctypes import CFUNCTYPE, c_void_p, POINTER, cdll, c_int, c_char_p, c_char
@@ -9,12 +10,29 @@ from typing import List
 from runtimeError import runtimeError
 from Environment import Environment
 from job_sys_functions import *
+from daemon_client import DaemonClient, DaemonError
+from graph_passes import eliminate_common_subexpressions, topological_levels, reduce_transitive_dependencies, fingerprint_jobs, DependencyCycleError
 
 
 class Interpreter(Expr.Visitor, Stmt.Visitor):
-    def __init__(self):
+    def __init__(self, critical_path: bool = False, pin_workers: bool = False, journal: str = None, history_store: str = None, worker_processes: bool = False, submission_ring: str = None, daemon: str = None, cse: bool = True, reduce_dependencies: bool = True, lazy: bool = False, incremental: str = None):
         self.environment = Environment()
         self.staging_area = {} # Where jobs are placed BEFORE being submitted to the job system
+        self.critical_path = critical_path # Let the job system run the jobs on the longest chains first
+        self.pin_workers = pin_workers # Pin the job system's workers to CPUs
+        self.journal = journal # Path of the job journal, used to survive crashes
+        self.history_store = history_store # Folder where job statuses and outputs are kept, after the run too
+        self.worker_processes = worker_processes # Run compile jobs in jobworker processes instead of the job system's
+        self.submission_ring = submission_ring # Name of the shared-memory ring other processes can submit jobs through
+        self.daemon = daemon # Socket of a running jobsystemd to submit the jobs to, instead of starting a job system
+        self.cse = cse # Merge jobs with the same type, input and dependencies before submitting them
+        self.merged_jobs = {} # Job name -> name of the identical job that runs in its place
+        self.reduce_dependencies = reduce_dependencies # Drop the dependencies already implied by other dependencies
+        self.lazy = lazy # Submit the graph as compact nodes: the job system only creates a job once it can run
+        self.incremental = incremental # Path of the state of the previous run: the jobs it already ran are not run again
+        self.fingerprints = {} # Job name -> (fingerprint, content key), see fingerprint_jobs
+        self.reused_jobs = {} # Job name -> what the previous run saved of its jobs, for the jobs that are not run again
+        self.submitted_job_ids = {} # Job name -> the IDs of its jobs (several for a fan-out)
 
     def interpret(self, statements: List[Stmt.Stmt]):
         self.total = len(statements)
@@ -22,8 +40,23 @@ class Interpreter(Expr.Visitor, Stmt.Visitor):
             for statement in statements:
                 self.execute(statement)
 
+            # A cycle would leave its jobs (and everything after them) waiting forever in the job system
+            self.validate_job_graph()
+
+            # Identical jobs only run once
+            if self.cse:
+                self.staging_area, self.merged_jobs = eliminate_common_subexpressions(self.staging_area)
+
+            self.optimize_job_graph()
+
+            if self.incremental is not None:
+                self.plan_incremental_run()
+
             # Move jobs from the staging area to the job system.
-            self.schedule_jobs()
+            if self.daemon is not None:
+                self.schedule_jobs_on_daemon()
+            else:
+                self.schedule_jobs()
         except runtimeError as error:
             flowscript.FlowScript.runtime_error(error)
 
@@ -102,30 +135,34 @@ class Interpreter(Expr.Visitor, Stmt.Visitor):
             name = job["job_if_false"]
             raise runtimeError(name, f"[Line: {name.line}]: Job identifier '{name.lexeme}' has never been declared. Make sure to declare it before referring to it.")
 
+        # A job can only be on one branch, of one conditional job
+        if job["job_if_true"].lexeme == job["job_if_false"].lexeme:
+            name = job["job_if_false"]
+            raise runtimeError(name, f"[Line: {name.line}]: Job '{name.lexeme}' cannot be on both branches of a conditional job.")
+        for name in [job["job_if_true"], job["job_if_false"]]:
+            if "gate" in self.staging_area[name.lexeme]:
+                raise runtimeError(name, f"[Line: {name.line}]: Job '{name.lexeme}' is already a branch of conditional job '{self.staging_area[name.lexeme]['gate'][0]}'.")
+
         # Place job in staging area
         tmp_dict = {
             "type": "CONDITIONAL_JOB".encode('utf-8'),
             "dependencies": [],
             "input": json.dumps({
                 "logicalOperation": job["test_type"].literal,
-                "if_true_job_type": self.environment.get(job["job_if_true"]),
-                "else_type_job_type": self.environment.get(job["job_if_false"]),
-                "if_true_input": self.staging_area[ job["job_if_true"].lexeme ]["input"].decode('utf-8'), # Needs to be string
-                "else_input": self.staging_area[ job["job_if_false"].lexeme ]["input"].decode('utf-8'), # Needs to be string
                 "jobType": 4
             }).encode('utf-8')
         }
 
         self.staging_area[ job["name"].lexeme ] = tmp_dict
 
-        # Since the jobs inside the conditional job declaration statement are to be queued by
-        # the conditional job ITSELF, we need to remove them from the staging area, so that
-        # the interpreter does NOT queue them to run BEFORE their time.
-        job_if_true = job["job_if_true"].lexeme
-        job_if_false = job["job_if_false"].lexeme
-
-        del self.staging_area[job_if_true]
-        del self.staging_area[job_if_false]
+        # NOTE: The conditional job used to create (and queue) the job of its branch itself, from inputs we
+        #       stringified into its own. Now both branches are submitted with it, gated on it: the job system
+        #       releases the one the condition picks, and skips the other, with everything depending on it.
+        conditional_name = job["name"].lexeme
+        for name, run_if_condition_met in [(job["job_if_true"], True), (job["job_if_false"], False)]:
+            branch = self.staging_area[name.lexeme]
+            branch["gate"] = [conditional_name, run_if_condition_met]
+            branch["dependencies"].append(conditional_name)
 
         return None
     
@@ -133,7 +170,8 @@ class Interpreter(Expr.Visitor, Stmt.Visitor):
         job = {
             "name": stmt.job_identifier,
             "type": stmt.job_type,
-            "input": stmt.input
+            "input": stmt.input,
+            "priority": stmt.priority
         }
         
         # If a job with the same identifier has declared already...
@@ -161,7 +199,24 @@ class Interpreter(Expr.Visitor, Stmt.Visitor):
             "dependencies": [], # will put string identifier of jobs here later
             "input": json_input.encode('utf-8') + b'\0'
         }
-        
+
+        # NOTE: When not given, the job keeps the priority from its JSON input (if any)
+        if job["priority"] is not None:
+            tmp_dict["priority"] = int(job["priority"].literal)
+
+        # NOTE: A fan-out stays ONE job here, whatever its size. The job system expands it when it is submitted,
+        #       replacing "${item}" (and "${index}") in the strings of the input. A glob is only expanded then too.
+        if stmt.foreach is not None:
+            if isinstance(stmt.foreach, list):
+                foreach = [self.evaluate(item) for item in stmt.foreach]
+            else:
+                foreach = self.evaluate(stmt.foreach)
+
+            if not all(isinstance(item, str) for item in (foreach if isinstance(foreach, list) else [foreach])):
+                name = job["name"]
+                raise runtimeError(name, f"[Line: {name.line}]: The 'foreach' of job '{name.lexeme}' must be a glob pattern, or a list of strings")
+            tmp_dict["foreach"] = foreach
+
         self.staging_area[ job["name"].lexeme ] = tmp_dict
 
         return None
@@ -182,37 +237,152 @@ class Interpreter(Expr.Visitor, Stmt.Visitor):
         self.environment.print()
 
 
+    def validate_job_graph(self):
+        try:
+            topological_levels(self.staging_area)
+        except DependencyCycleError as error:
+            raise runtimeError(None, f"Dependency cycle: {error}. Jobs on a cycle would wait on each other forever, nothing was submitted.")
+
+    def optimize_job_graph(self):
+        levels = topological_levels(self.staging_area)
+        num_dropped = 0
+        if self.reduce_dependencies:
+            num_dropped = reduce_transitive_dependencies(self.staging_area, levels)
+
+        # Level by level: every job is submitted after the jobs it depends on
+        names = sorted(self.staging_area, key=lambda name: levels[name])
+        self.staging_area = {name: self.staging_area[name] for name in names}
+
+        num_levels = 1 + max(levels.values(), default=-1)
+        print(f"Job graph: {len(self.staging_area)} jobs on {num_levels} levels, {num_dropped} redundant dependencies dropped")
+
+    # NOTE: Diffs the graph against the one the previous run saved (see save_incremental_state). A job is reused
+    #       when its fingerprint is the same as a job that completed last time, and every job it depends on is
+    #       reused too. The others run: the ones that changed, and everything downstream of them.
+    def plan_incremental_run(self):
+        if self.daemon is not None or self.journal is not None:
+            print("Incremental runs need our own job system, without a journal: every job runs")
+            self.incremental = None
+            return
+
+        previous_nodes = {}
+        try:
+            with open(self.incremental, 'r') as file:
+                previous_nodes = json.load(file).get("nodes", {})
+        except FileNotFoundError:
+            pass
+        except ValueError:
+            print(f"The incremental state '{self.incremental}' is unreadable: every job runs")
+
+        saved_jobs = {node["fingerprint"]: node["jobs"] for node in previous_nodes.values() if node.get("fingerprint") and node.get("jobs") is not None}
+        self.fingerprints = fingerprint_jobs(self.staging_area)
+
+        changed = []
+        for name, job_infos in self.staging_area.items():
+            fingerprint, content_key = self.fingerprints[name]
+            if fingerprint in saved_jobs and all(dependency in self.reused_jobs for dependency in job_infos["dependencies"]):
+                self.reused_jobs[name] = saved_jobs[fingerprint]
+            elif name not in previous_nodes or previous_nodes[name].get("content") != content_key:
+                changed.append(name)
+
+        num_removed = len([name for name in previous_nodes if name not in self.staging_area])
+        num_to_run = len(self.staging_area) - len(self.reused_jobs)
+        print(f"Incremental run: {len(self.reused_jobs)} jobs reused, {num_to_run} to run ({len(changed)} new or changed, the others downstream of a change or never reused), {num_removed} removed")
+        if changed and len(changed) <= 10:
+            print(f"Changed: {', '.join(changed)}")
+
+    # What the next incremental run can reuse: every job that completed (and did not fail), with its output
+    def save_incremental_state(self, job_system_handle):
+        if self.incremental is None:
+            return
+
+        all_job_ids = [job_id for job_ids in self.submitted_job_ids.values() for job_id in job_ids]
+        outputs = get_job_outputs(job_system_handle, all_job_ids) if all_job_ids else {}
+
+        nodes = {}
+        num_reusable = 0
+        for name, (fingerprint, content_key) in self.fingerprints.items():
+            node = {"fingerprint": fingerprint, "content": content_key, "jobs": None}
+            job_ids = self.submitted_job_ids.get(name)
+            if fingerprint is not None and job_ids is not None:
+                job_type = json.loads(self.staging_area[name]["input"].rstrip(b'\0')).get("jobType", -1)
+                jobs = []
+                for job_id in job_ids:
+                    status = get_job_status(job_system_handle, job_id)
+                    result = get_job_result(job_system_handle, job_id)
+                    if status not in (JOB_STATUS_COMPLETED, JOB_STATUS_RETIRED) or result == JOB_RESULT_FAILURE or outputs.get(job_id) is None:
+                        jobs = None # Not done, or failed: it runs again next time
+                        break
+                    jobs.append({"jobType": job_type, "result": result, "output": outputs[job_id]})
+                node["jobs"] = jobs
+                num_reusable += (jobs is not None)
+            nodes[name] = node
+
+        state_folder = os.path.dirname(self.incremental)
+        if state_folder:
+            os.makedirs(state_folder, exist_ok=True)
+        temporary_path = self.incremental + ".tmp"
+        with open(temporary_path, 'w') as file:
+            json.dump({"version": 1, "nodes": nodes}, file)
+        os.replace(temporary_path, self.incremental) # A run interrupted while saving keeps the previous state
+        print(f"Incremental state saved to '{self.incremental}': {num_reusable} of {len(nodes)} jobs can be reused by the next run")
+
+    def describe_job_ids(self, job_ids):
+        if not job_ids:
+            return "nothing matched"
+        if len(job_ids) == 1:
+            return f"# {job_ids[0]}"
+        if job_ids == list(range(job_ids[0], job_ids[0] + len(job_ids))):
+            return f"# {job_ids[0]} to # {job_ids[-1]}"
+        return ", ".join(f"# {job_id}" for job_id in job_ids)
+
+    def print_merged_jobs(self):
+        for merged_job, kept_job in self.merged_jobs.items():
+            print(f"Job {merged_job} MERGED into job {kept_job}: same type, input and dependencies")
+
     # submit jobs to the job system
     def schedule_jobs(self):
-        job_handles = {}
-
         # Kick off the job system
         job_system_handle = get_job_system_instance()
         init_job_system()
 
-        # Create all job the jobs
-        for job_id_string, job_infos in self.staging_area.items():
+        if self.critical_path:
+            set_scheduling_mode(job_system_handle, JOB_SCHEDULING_CRITICAL_PATH)
 
-            job_identifier_cstr = ctypes.c_char_p(job_infos["type"])     
-            job_handle = create_job_func(job_system_handle, job_identifier_cstr, job_infos["input"])
-            job_handles[job_id_string] = job_handle
-            
-        # Attach dependencies
-        for job_id_string, job_infos in self.staging_area.items():
-            job_handle = job_handles[job_id_string]
-            
-            dependencies = job_infos["dependencies"]
-            for dep_id in dependencies:
-                dep_handle = job_handles[dep_id]
+        if self.pin_workers:
+            set_worker_placement(job_system_handle, JOB_CHANNEL_COMPILE, WORKER_PLACEMENT_WHOLE_CORES, None)
+            set_worker_placement(job_system_handle, JOB_CHANNEL_PARSING, WORKER_PLACEMENT_SMT_SIBLINGS, None)
+            set_worker_placement(job_system_handle, JOB_CHANNEL_JSON, WORKER_PLACEMENT_SMT_SIBLINGS, None)
 
-                # NOTE: second job IS dependent on the first job.
-                add_dependency(job_handle, dep_handle)
+        if self.worker_processes:
+            set_worker_processes(job_system_handle, JOB_CHANNEL_COMPILE, None)
 
-        # Submit all to the job system
-        print("\nInterpreter submitting jobs (˵ ͡° ͜ʖ ͡°˵): \n")
-        for job_id_string, job_handle in job_handles.items():
-            queue_job(job_system_handle, job_handle)
-            print(f"Job {job_id_string} SUBMITTED to the JOB SYSTEM") 
+        if self.submission_ring is not None:
+            if enable_job_submission_ring(job_system_handle, self.submission_ring.encode('utf-8'), 1024 * 1024):
+                print(f"\nOther processes can submit jobs through the ring '{self.submission_ring}'\n")
+
+        # Before any job is created, so they get IDs after the ones already in the store
+        if self.history_store is not None:
+            enable_job_history_store(job_system_handle, self.history_store.encode('utf-8'))
+
+        # A previous run left a journal behind: resume its jobs, rather than submitting the script's all over again
+        if self.journal is not None:
+            num_recovered_jobs = recover_from_journal(job_system_handle, self.journal.encode('utf-8'))
+            if num_recovered_jobs >= 0:
+                print(f"\nRecovered {num_recovered_jobs} jobs from the journal '{self.journal}'. Unfinished ones were re-queued.\n")
+                self.staging_area = {}
+
+        if self.lazy and self.journal is not None:
+            print("Lazy graphs are not journaled: the jobs are submitted one by one, so they survive a crash")
+        if self.lazy and self.reused_jobs:
+            print("Lazy graphs cannot depend on reused jobs: the jobs are submitted one by one")
+        if self.lazy and self.journal is None and not self.reused_jobs:
+            self.submit_lazy_job_graph(job_system_handle)
+        else:
+            self.submit_jobs(job_system_handle)
+        self.print_merged_jobs()
+        if self.journal is not None:
+            sync_job_journal(job_system_handle) # Once we say they are submitted, they survive a crash
         print("\n")
         print("Your jobs are running. Interact with the job system to manipulate them ╰( ͡° ͜ʖ ͡° )つ──☆*: \n")
 
@@ -220,12 +390,14 @@ class Interpreter(Expr.Visitor, Stmt.Visitor):
         # with the job system and see their jobs
         running = True
         while running:
-            command = input("Enter: \"stop\", \"destroy\", \"finish\", \"status\", \"finishjob\", or \"job_types\", \"history\":\n")
+            command = input("Enter: \"stop\", \"destroy\", \"finish\", \"status\", \"finishjob\", or \"job_types\", \"history\", \"output\", \"cancel\":\n")
             
             if command == "stop":
+                self.save_incremental_state(job_system_handle)
                 running = False
             elif command == "destroy":
                 finish_jobs(job_system_handle)
+                self.save_incremental_state(job_system_handle)
                 destroy_job_system(job_system_handle)
                 running = False
             elif command == "finish":
@@ -238,7 +410,273 @@ class Interpreter(Expr.Visitor, Stmt.Visitor):
                     print("Invalid input. Please enter a valid job ID.")
             elif command == "history":
                 get_job_details(job_system_handle)
+            elif command == "cancel":
+                try:
+                    jobID = int(input("Enter ID of job to cancel (with every job depending on it): "))
+                    print(str(cancel_job(job_system_handle, jobID, 1)) + " job(s) cancelled")
+                except ValueError:
+                    print("Invalid input. Please enter a valid job ID.")
+            elif command == "output":
+                try:
+                    jobID = int(input("Enter ID of job: "))
+                    output = get_job_output(job_system_handle, jobID)
+                    if output is None:
+                        print("Job # " + str(jobID) + " has no output (yet)")
+                    else:
+                        print("Result: " + JOB_RESULT_NAMES[get_job_result(job_system_handle, jobID)])
+                        print(json.dumps(output, indent=4))
+                except ValueError:
+                    print("Invalid input. Please enter a valid job ID.")
             else:
                 print("Invalid command")
 
-    
\ No newline at end of file
+    
+
+    # Every job of the staging area becomes a Job in the job system, right away
+    def submit_jobs(self, job_system_handle):
+        job_handles = {}
+
+        # Create all job the jobs
+        fan_out_handles = {} # Fan-outs: one handle for all of their jobs
+        reused_job_ids = {} # Jobs of the previous run, recorded as they completed then (see plan_incremental_run)
+        for job_id_string, job_infos in self.staging_area.items():
+
+            if job_id_string in self.reused_jobs:
+                reused_job_ids[job_id_string] = [record_reused_job(job_system_handle, job["jobType"], job["result"], json.dumps(job["output"]).encode('utf-8')) for job in self.reused_jobs[job_id_string]]
+                continue
+
+            job_identifier_cstr = ctypes.c_char_p(job_infos["type"])     
+            if "foreach" in job_infos:
+                fan_out_handle = create_job_fan_out(job_system_handle, job_infos["type"], job_infos["input"], job_infos["foreach"])
+                if not fan_out_handle:
+                    raise runtimeError(None, f"Job '{job_id_string}' could not be created: '{job_infos['type'].decode('utf-8')}' is not a registered job type, or its input template (or one of its items) made an invalid input")
+                fan_out_handles[job_id_string] = fan_out_handle
+                if "priority" in job_infos:
+                    set_job_fan_out_priority(fan_out_handle, job_infos["priority"])
+                continue
+
+            job_handle = create_job_func(job_system_handle, job_identifier_cstr, job_infos["input"])
+            job_handles[job_id_string] = job_handle
+
+            if "priority" in job_infos:
+                set_job_priority(job_handle, job_infos["priority"])
+            
+        # Attach dependencies
+        for job_id_string, job_infos in self.staging_area.items():
+            job_handle = job_handles.get(job_id_string)
+            fan_out_handle = fan_out_handles.get(job_id_string)
+            if job_id_string in reused_job_ids:
+                continue # Everything it depends on is reused too
+            
+            dependencies = job_infos["dependencies"]
+            for dep_id in dependencies:
+                dep_handle = job_handles.get(dep_id)
+                dep_fan_out_handle = fan_out_handles.get(dep_id)
+
+                # NOTE: second job IS dependent on the first job. A fan-out depends (or is depended on) as a whole.
+                if dep_id in reused_job_ids:
+                    for reused_job_id in reused_job_ids[dep_id]:
+                        if job_handle is not None:
+                            add_dependency_by_id(job_handle, reused_job_id)
+                        else:
+                            add_dependency_by_id_to_fan_out(fan_out_handle, reused_job_id)
+                elif job_handle is not None and dep_handle is not None:
+                    add_dependency(job_handle, dep_handle)
+                elif job_handle is not None:
+                    add_fan_out_dependency(job_handle, dep_fan_out_handle)
+                elif dep_handle is not None:
+                    add_dependency_to_fan_out(fan_out_handle, dep_handle)
+                else:
+                    add_fan_out_to_fan_out_dependency(fan_out_handle, dep_fan_out_handle)
+
+        # Gate the branches of conditional jobs
+        for job_id_string, job_infos in self.staging_area.items():
+            if "gate" not in job_infos or job_id_string in reused_job_ids:
+                continue
+            run_if_condition_met = int(job_infos["gate"][1])
+            if job_infos["gate"][0] in reused_job_ids:
+                conditional_job_id = reused_job_ids[job_infos["gate"][0]][0]
+                if job_id_string in fan_out_handles:
+                    set_job_fan_out_gate_by_id(fan_out_handles[job_id_string], conditional_job_id, run_if_condition_met)
+                else:
+                    set_job_gate_by_id(job_handles[job_id_string], conditional_job_id, run_if_condition_met)
+                continue
+            conditional_handle = job_handles[job_infos["gate"][0]]
+            if job_id_string in fan_out_handles:
+                set_job_fan_out_gate(fan_out_handles[job_id_string], conditional_handle, run_if_condition_met)
+            else:
+                set_job_gate(job_handles[job_id_string], conditional_handle, run_if_condition_met)
+
+        # Submit all to the job system
+        print("\nInterpreter submitting jobs (˵ ͡° ͜ʖ ͡°˵): \n")
+        for job_id_string in self.staging_area:
+            if job_id_string in reused_job_ids:
+                self.submitted_job_ids[job_id_string] = reused_job_ids[job_id_string]
+                print(f"Job {job_id_string} REUSED from the previous run: {self.describe_job_ids(reused_job_ids[job_id_string])}")
+                continue
+            if job_id_string in fan_out_handles:
+                fan_out_handle = fan_out_handles[job_id_string]
+                fan_out_ids = get_job_fan_out_ids(fan_out_handle)
+                queue_job_fan_out(job_system_handle, fan_out_handle)
+                self.submitted_job_ids[job_id_string] = fan_out_ids
+                print(f"Job {job_id_string} SUBMITTED to the JOB SYSTEM as {len(fan_out_ids)} jobs: {self.describe_job_ids(fan_out_ids)}")
+                continue
+            self.submitted_job_ids[job_id_string] = [get_job_id(job_system_handle, job_handles[job_id_string])]
+            queue_job(job_system_handle, job_handles[job_id_string])
+            print(f"Job {job_id_string} SUBMITTED to the JOB SYSTEM") 
+
+    # NOTE: The whole staging area goes in as one lazy graph: a node per job (per item for a fan-out), and its edges.
+    #       A node costs the job system a few bytes until its dependencies are done. Only then is its job created.
+    def submit_lazy_job_graph(self, job_system_handle):
+        if not self.staging_area:
+            return
+        graph_handle = create_lazy_job_graph()
+        nodes = {} # Job name -> its nodes
+        for job_id_string, job_infos in self.staging_area.items():
+            priority = job_infos.get("priority", LAZY_JOB_INPUT_PRIORITY)
+            if "foreach" in job_infos:
+                nodes[job_id_string] = add_lazy_graph_fan_out(graph_handle, job_infos["type"], job_infos["input"], job_infos["foreach"], priority)
+                if nodes[job_id_string] is None:
+                    raise runtimeError(None, f"Job '{job_id_string}' could not be added to the lazy graph: its input template is not JSON, or the graph is full")
+                continue
+            node = add_lazy_graph_job(graph_handle, job_infos["type"], job_infos["input"], priority)
+            if node < 0:
+                raise runtimeError(None, f"Job '{job_id_string}' could not be added to the lazy graph: its input is not JSON")
+            nodes[job_id_string] = [node]
+
+        # NOTE: second job IS dependent on the first job. A fan-out depends (or is depended on) as a whole.
+        edges = []
+        for job_id_string, job_infos in self.staging_area.items():
+            for dep_id in job_infos["dependencies"]:
+                edges.extend((dependency_node, node) for node in nodes[job_id_string] for dependency_node in nodes[dep_id])
+        add_lazy_graph_dependencies(graph_handle, edges)
+
+        for job_id_string, job_infos in self.staging_area.items():
+            if "gate" in job_infos:
+                conditional_node = nodes[job_infos["gate"][0]][0]
+                for node in nodes[job_id_string]:
+                    set_lazy_graph_gate(graph_handle, node, conditional_node, int(job_infos["gate"][1]))
+
+        first_job_id = queue_lazy_job_graph(job_system_handle, graph_handle)
+        if first_job_id < 0:
+            raise runtimeError(None, "The job system refused the lazy job graph, nothing was submitted.")
+
+        print("\nInterpreter submitting jobs (˵ ͡° ͜ʖ ͡°˵): \n")
+        for job_id_string in self.staging_area:
+            job_ids = [first_job_id + node for node in nodes[job_id_string]]
+            self.submitted_job_ids[job_id_string] = job_ids
+            if "foreach" in self.staging_area[job_id_string]:
+                print(f"Job {job_id_string} SUBMITTED to the JOB SYSTEM as {len(job_ids)} lazy jobs: {self.describe_job_ids(job_ids)}")
+            else:
+                print(f"Job {job_id_string} SUBMITTED to the JOB SYSTEM as lazy job # {job_ids[0]}")
+
+    # submit jobs to a running jobsystemd, which keeps its job types, build manifest and worker threads between runs
+    def schedule_jobs_on_daemon(self):
+        try:
+            daemon = DaemonClient(self.daemon)
+        except DaemonError as error:
+            print(error)
+            flowscript.FlowScript.had_runtime_error = True
+            return
+
+        # NOTE: Job inputs hold paths relative to where the script runs, but the daemon resolves them against its own directory
+        daemon_cwd = daemon.ping()["cwd"]
+        if os.path.realpath(daemon_cwd) != os.path.realpath(os.getcwd()):
+            print(f"Warning: the daemon runs in '{daemon_cwd}', relative paths in the job inputs resolve from there")
+
+        jobs = []
+        for job_id_string, job_infos in self.staging_area.items():
+            job = {
+                "name": job_id_string,
+                "jobTypeIdentifier": job_infos["type"].decode('utf-8'),
+                "input": json.loads(job_infos["input"].rstrip(b'\0')),
+                "dependencies": job_infos["dependencies"]
+            }
+            if "priority" in job_infos:
+                job["priority"] = job_infos["priority"]
+            if "foreach" in job_infos:
+                job["foreach"] = job_infos["foreach"]
+            if "gate" in job_infos:
+                job["gate"] = {"job": job_infos["gate"][0], "runIfConditionMet": job_infos["gate"][1]}
+            jobs.append(job)
+
+        try:
+            job_ids = daemon.submit(jobs)
+        except DaemonError as error:
+            print(f"The daemon refused the jobs: {error}")
+            daemon.close()
+            flowscript.FlowScript.had_runtime_error = True
+            return
+
+        print("\nInterpreter submitting jobs to the daemon (˵ ͡° ͜ʖ ͡°˵): \n")
+        for job_id_string, job_id in job_ids.items():
+            if isinstance(job_id, list):
+                print(f"Job {job_id_string} SUBMITTED to the DAEMON as {len(job_id)} jobs: {self.describe_job_ids(job_id)}")
+            else:
+                print(f"Job {job_id_string} SUBMITTED to the DAEMON as job # {job_id}")
+        self.print_merged_jobs()
+        print("\n")
+        print("Your jobs are running. Interact with the daemon to manipulate them ╰( ͡° ͜ʖ ͡° )つ──☆*: \n")
+
+        # Same commands as with our own job system, but about this run's jobs only: the daemon serves other runs too.
+        # "stop" and "destroy" leave the daemon running, "shutdown" stops it.
+        ids = []
+        id_names = []
+        for job_id_string, job_id in job_ids.items():
+            for index, fan_out_id in enumerate(job_id if isinstance(job_id, list) else [job_id]):
+                ids.append(fan_out_id)
+                id_names.append(f"{job_id_string}[{index}]" if isinstance(job_id, list) else job_id_string)
+        status_names = JOB_STATUS_NAMES
+        running = True
+        while running:
+            command = input("Enter: \"stop\", \"destroy\", \"finish\", \"status\", \"finishjob\", or \"job_types\", \"output\", \"cancel\", \"shutdown\":\n")
+
+            try:
+                if command == "stop":
+                    running = False
+                elif command == "destroy":
+                    daemon.wait(ids)
+                    daemon.finish(ids)
+                    running = False
+                elif command == "finish":
+                    daemon.finish(ids)
+                elif command == "finishjob":
+                    try:
+                        jobID = int(input("Enter ID of job to finish: "))
+                        if not daemon.finish([jobID]):
+                            print("Job # " + str(jobID) + " has not completed")
+                    except ValueError:
+                        print("Invalid input. Please enter a valid job ID.")
+                elif command == "status":
+                    statuses, results = daemon.status_and_results(ids)
+                    for job_id_string, job_id, status, result in zip(id_names, ids, statuses, results):
+                        result_text = f" ({JOB_RESULT_NAMES[result]})" if result else ""
+                        print(f"Job {job_id_string} (# {job_id}): {status_names[status]}{result_text}")
+                elif command == "job_types":
+                    print(daemon.job_types())
+                elif command == "cancel":
+                    try:
+                        jobID = int(input("Enter ID of job to cancel (with every job depending on it): "))
+                        print(str(daemon.cancel([jobID])) + " job(s) cancelled")
+                    except ValueError:
+                        print("Invalid input. Please enter a valid job ID.")
+                elif command == "output":
+                    try:
+                        jobID = int(input("Enter ID of job: "))
+                        output = daemon.outputs([jobID])[0]
+                        if output is None:
+                            print("Job # " + str(jobID) + " has no output (yet)")
+                        else:
+                            print(json.dumps(output, indent=4))
+                    except ValueError:
+                        print("Invalid input. Please enter a valid job ID.")
+                elif command == "shutdown":
+                    daemon.shutdown()
+                    running = False
+                else:
+                    print("Invalid command")
+            except DaemonError as error:
+                print(error)
+                running = False
+
+        daemon.close()
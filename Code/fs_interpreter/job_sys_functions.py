@@ -39,6 +39,75 @@ create_job.restype = JobHandle
 queue_job = job_system_lib.QueueJob
 queue_job.argtypes = [JobSystemHandle, JobHandle]
 
+# Functions to create jobs from, and read outputs in, a binary encoding. Inputs and outputs skip JSON text parsing.
+JOB_DATA_FORMAT_JSON    = 0
+JOB_DATA_FORMAT_CBOR    = 1
+JOB_DATA_FORMAT_MSGPACK = 2
+create_job_from_binary = job_system_lib.CreateJobFromBinary
+create_job_from_binary.argtypes = [JobSystemHandle, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int]
+create_job_from_binary.restype = JobHandle
+
+get_job_output_encoded = job_system_lib.GetJobOutputEncoded
+get_job_output_encoded.argtypes = [JobSystemHandle, ctypes.c_int, ctypes.c_int, ctypes.c_char_p, ctypes.c_size_t]
+get_job_output_encoded.restype = ctypes.c_longlong
+
+def get_job_output_bytes(job_system_handle, job_id: int, data_format: int):
+    """Output of a completed job, encoded in data_format. None if it has no output (yet)."""
+    size = get_job_output_encoded(job_system_handle, job_id, data_format, None, 0)
+    if size < 0:
+        return None
+    buffer = ctypes.create_string_buffer(max(size, 1))
+    size = get_job_output_encoded(job_system_handle, job_id, data_format, buffer, len(buffer))
+    if size < 0 or size > len(buffer):
+        return None # It changed between the two calls, which a completed job's output never does
+    return buffer.raw[:size]
+
+# Functions to read outputs straight from the job system, instead of from the ./Data/*-output.txt files
+get_job_output_size = job_system_lib.GetJobOutputSize
+get_job_output_size.argtypes = [JobSystemHandle, ctypes.c_int]
+get_job_output_size.restype = ctypes.c_longlong
+
+get_job_output_text = job_system_lib.GetJobOutput
+get_job_output_text.argtypes = [JobSystemHandle, ctypes.c_int, ctypes.c_char_p, ctypes.c_size_t]
+get_job_output_text.restype = ctypes.c_longlong
+
+get_job_outputs_text = job_system_lib.GetJobOutputs
+get_job_outputs_text.argtypes = [JobSystemHandle, POINTER(c_int), c_int, ctypes.c_char_p, ctypes.c_size_t, POINTER(ctypes.c_longlong), POINTER(ctypes.c_longlong)]
+get_job_outputs_text.restype = ctypes.c_longlong
+
+def get_job_output(job_system_handle, job_id: int):
+    """Output of a completed job. None if it has no output (yet)."""
+    size = get_job_output_size(job_system_handle, job_id)
+    if size < 0:
+        return None
+    buffer = ctypes.create_string_buffer(size + 1)
+    size = get_job_output_text(job_system_handle, job_id, buffer, len(buffer))
+    if size < 0 or size >= len(buffer):
+        return None
+    return json.loads(buffer.raw[:size])
+
+def get_job_outputs(job_system_handle, job_ids, buffer_size: int = 64 * 1024):
+    """Outputs of many jobs in one call: {job_id: output}, None for jobs without output (yet)."""
+    num_jobs = len(job_ids)
+    ids = (c_int * num_jobs)(*job_ids)
+    offsets = (ctypes.c_longlong * num_jobs)()
+    sizes = (ctypes.c_longlong * num_jobs)()
+
+    buffer = ctypes.create_string_buffer(max(buffer_size, 1))
+    num_bytes_needed = get_job_outputs_text(job_system_handle, ids, num_jobs, buffer, len(buffer), offsets, sizes)
+    if num_bytes_needed > len(buffer):
+        # Did not all fit, one more call with a buffer of the right size
+        buffer = ctypes.create_string_buffer(num_bytes_needed)
+        get_job_outputs_text(job_system_handle, ids, num_jobs, buffer, len(buffer), offsets, sizes)
+
+    outputs = {}
+    for i, job_id in enumerate(job_ids):
+        if sizes[i] < 0 or offsets[i] < 0:
+            outputs[job_id] = None
+        else:
+            outputs[job_id] = json.loads(buffer.raw[offsets[i]:offsets[i] + sizes[i]])
+    return outputs
+
 # Function to add dependency
 add_dependency = job_system_lib.AddDependency
 add_dependency.argtypes = [JobHandle, JobHandle]
@@ -48,13 +117,26 @@ finish_job = job_system_lib.FinishJob
 finish_job.argtypes = [JobSystemHandle, ctypes.c_int]
 
 # Function to get job status
+JOB_STATUS_NAMES = ["NEVER_SEEN", "QUEUED", "RUNNING", "COMPLETED", "RETIRED", "SKIPPED", "CANCELLED"]
+JOB_STATUS_COMPLETED = 3
+JOB_STATUS_RETIRED = 4
+JOB_STATUS_SKIPPED = 5
+JOB_STATUS_CANCELLED = 6
 get_job_status = job_system_lib.GetJobStatus
 get_job_status.argtypes = [JobSystemHandle, ctypes.c_int]
 get_job_status.restype = ctypes.c_int
 
+# Function to get how a job went (success / failure), without reading its output. Does not take any lock.
+JOB_RESULT_NAMES = ["NONE", "SUCCESS", "FAILURE"]
+JOB_RESULT_SUCCESS = 1
+JOB_RESULT_FAILURE = 2
+get_job_result = job_system_lib.GetJobResult
+get_job_result.argtypes = [JobSystemHandle, ctypes.c_int]
+get_job_result.restype = ctypes.c_int
+
 # Function to get job id
 get_job_id = job_system_lib.GetJobID
-get_job_id.argtypes = [JobSystemHandle, ctypes.c_int]
+get_job_id.argtypes = [JobSystemHandle, JobHandle]
 get_job_id.restype = ctypes.c_int
 
 # DEFINE the function signature for FinishCompleted jobs and WRAP it with the function signature
@@ -68,6 +150,287 @@ finish_jobs.restype = ctypes.c_void_p
 get_job_details = job_system_lib.GetJobDetails
 get_job_details.argtypes = [JobSystemHandle]
 
+# Function to set the priority of a job. Higher priority jobs are claimed first.
+set_job_priority = job_system_lib.SetJobPriority
+set_job_priority.argtypes = [JobHandle, ctypes.c_int]
+
+# Functions to time a job out (milliseconds, 0 for none), and to run it again when it fails (retries, backoff in milliseconds)
+set_job_timeout = job_system_lib.SetJobTimeout
+set_job_timeout.argtypes = [JobHandle, ctypes.c_int]
+
+set_job_retries = job_system_lib.SetJobRetries
+set_job_retries.argtypes = [JobHandle, ctypes.c_int, ctypes.c_int]
+
+# Function to cancel a job (and, if recursive, every job depending on it). Returns the number of jobs cancelled.
+cancel_job = job_system_lib.CancelJob
+cancel_job.argtypes = [JobSystemHandle, ctypes.c_int, ctypes.c_int]
+cancel_job.restype = ctypes.c_int
+
+# Functions to create many jobs from one template (a fan-out), in one call. The handle is freed once queued.
+JobFanOutHandle = ctypes.c_void_p
+_create_job_fan_out = job_system_lib.CreateJobFanOut
+_create_job_fan_out.argtypes = [JobSystemHandle, ctypes.c_char_p, ctypes.c_char_p, POINTER(ctypes.c_char_p), ctypes.c_int, ctypes.c_char_p]
+_create_job_fan_out.restype = JobFanOutHandle
+
+def create_job_fan_out(job_system_handle, job_type: bytes, input_template: bytes, foreach):
+    """One job per item of foreach: a list of strings, or a glob pattern (str). None if the job type is not registered, the input template is not JSON, or if any of the jobs could not be created."""
+    if isinstance(foreach, str):
+        return _create_job_fan_out(job_system_handle, job_type, input_template, None, 0, foreach.encode('utf-8'))
+    items = (ctypes.c_char_p * len(foreach))(*[item.encode('utf-8') for item in foreach])
+    return _create_job_fan_out(job_system_handle, job_type, input_template, items, len(foreach), None)
+
+get_job_fan_out_size = job_system_lib.GetJobFanOutSize
+get_job_fan_out_size.argtypes = [JobFanOutHandle]
+get_job_fan_out_size.restype = ctypes.c_int
+
+_get_job_fan_out_ids = job_system_lib.GetJobFanOutIDs
+_get_job_fan_out_ids.argtypes = [JobFanOutHandle, POINTER(ctypes.c_int), ctypes.c_int]
+_get_job_fan_out_ids.restype = ctypes.c_int
+
+def get_job_fan_out_ids(fan_out_handle):
+    size = get_job_fan_out_size(fan_out_handle)
+    job_ids = (ctypes.c_int * max(size, 1))()
+    _get_job_fan_out_ids(fan_out_handle, job_ids, size)
+    return list(job_ids[:size])
+
+add_dependency_to_fan_out = job_system_lib.AddDependencyToFanOut
+add_dependency_to_fan_out.argtypes = [JobFanOutHandle, JobHandle]
+
+add_fan_out_dependency = job_system_lib.AddFanOutDependency
+add_fan_out_dependency.argtypes = [JobHandle, JobFanOutHandle]
+
+add_fan_out_to_fan_out_dependency = job_system_lib.AddFanOutToFanOutDependency
+add_fan_out_to_fan_out_dependency.argtypes = [JobFanOutHandle, JobFanOutHandle]
+
+set_job_fan_out_priority = job_system_lib.SetJobFanOutPriority
+set_job_fan_out_priority.argtypes = [JobFanOutHandle, ctypes.c_int]
+
+queue_job_fan_out = job_system_lib.QueueJobFanOut
+queue_job_fan_out.argtypes = [JobSystemHandle, JobFanOutHandle]
+
+# Functions to make a job (or every job of a fan-out) a branch of a conditional job: it runs only if the
+# condition comes out as run_if_condition_met, and is skipped otherwise
+set_job_gate = job_system_lib.SetJobGate
+set_job_gate.argtypes = [JobHandle, JobHandle, ctypes.c_int]
+
+set_job_fan_out_gate = job_system_lib.SetJobFanOutGate
+set_job_fan_out_gate.argtypes = [JobFanOutHandle, JobHandle, ctypes.c_int]
+
+# Functions for incremental runs: the result of a previous run is recorded as a retired job (no job is created),
+# and the jobs that run depend on it (or are gated on it) by its ID
+record_reused_job = job_system_lib.RecordReusedJob
+record_reused_job.argtypes = [JobSystemHandle, ctypes.c_int, ctypes.c_int, ctypes.c_char_p]
+record_reused_job.restype = ctypes.c_int
+
+add_dependency_by_id = job_system_lib.AddDependencyByID
+add_dependency_by_id.argtypes = [JobHandle, ctypes.c_int]
+
+add_dependency_by_id_to_fan_out = job_system_lib.AddDependencyByIDToFanOut
+add_dependency_by_id_to_fan_out.argtypes = [JobFanOutHandle, ctypes.c_int]
+
+set_job_gate_by_id = job_system_lib.SetJobGateByID
+set_job_gate_by_id.argtypes = [JobHandle, ctypes.c_int, ctypes.c_int]
+
+set_job_fan_out_gate_by_id = job_system_lib.SetJobFanOutGateByID
+set_job_fan_out_gate_by_id.argtypes = [JobFanOutHandle, ctypes.c_int, ctypes.c_int]
+
+# Functions to submit a whole graph at once, as compact nodes. The job system only creates the job of a node
+# once its dependencies are done (see JobSystem::QueueLazyJobGraph). Nodes are numbered 0, 1, ... as they are added.
+LazyJobGraphHandle = ctypes.c_void_p
+LAZY_JOB_INPUT_PRIORITY = -2**31 # The node keeps the priority of its input
+
+create_lazy_job_graph = job_system_lib.CreateLazyJobGraph
+create_lazy_job_graph.argtypes = []
+create_lazy_job_graph.restype = LazyJobGraphHandle
+
+add_lazy_graph_job = job_system_lib.AddLazyGraphJob
+add_lazy_graph_job.argtypes = [LazyJobGraphHandle, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int]
+add_lazy_graph_job.restype = ctypes.c_int
+
+_add_lazy_graph_fan_out = job_system_lib.AddLazyGraphFanOut
+_add_lazy_graph_fan_out.argtypes = [LazyJobGraphHandle, ctypes.c_char_p, ctypes.c_char_p, POINTER(ctypes.c_char_p), ctypes.c_int, ctypes.c_char_p, ctypes.c_int, POINTER(ctypes.c_int)]
+_add_lazy_graph_fan_out.restype = ctypes.c_int
+
+def add_lazy_graph_fan_out(graph_handle, job_type: bytes, input_template: bytes, foreach, priority: int = LAZY_JOB_INPUT_PRIORITY):
+    """One node per item of foreach (a list of strings, or a glob pattern). Returns the range of their indices, None (and no node) if the template is not JSON or the graph is full."""
+    first_node = ctypes.c_int(0)
+    if isinstance(foreach, str):
+        num_nodes = _add_lazy_graph_fan_out(graph_handle, job_type, input_template, None, 0, foreach.encode('utf-8'), priority, ctypes.byref(first_node))
+    else:
+        items = (ctypes.c_char_p * len(foreach))(*[item.encode('utf-8') for item in foreach])
+        num_nodes = _add_lazy_graph_fan_out(graph_handle, job_type, input_template, items, len(foreach), None, priority, ctypes.byref(first_node))
+    if num_nodes < 0:
+        return None
+    return range(first_node.value, first_node.value + num_nodes)
+
+_add_lazy_graph_dependencies = job_system_lib.AddLazyGraphDependencies
+_add_lazy_graph_dependencies.argtypes = [LazyJobGraphHandle, POINTER(ctypes.c_int), POINTER(ctypes.c_int), ctypes.c_int]
+
+def add_lazy_graph_dependencies(graph_handle, edges):
+    """edges: (dependency node, dependent node) pairs. Passed in one call."""
+    if not edges:
+        return
+    dependency_nodes = (ctypes.c_int * len(edges))(*[edge[0] for edge in edges])
+    dependent_nodes = (ctypes.c_int * len(edges))(*[edge[1] for edge in edges])
+    _add_lazy_graph_dependencies(graph_handle, dependency_nodes, dependent_nodes, len(edges))
+
+set_lazy_graph_gate = job_system_lib.SetLazyGraphGate
+set_lazy_graph_gate.argtypes = [LazyJobGraphHandle, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+
+queue_lazy_job_graph = job_system_lib.QueueLazyJobGraph
+queue_lazy_job_graph.argtypes = [JobSystemHandle, LazyJobGraphHandle]
+queue_lazy_job_graph.restype = ctypes.c_int
+
+# Functions to tokenize a FlowScript file natively (see FlowScriptScanner). No job system needed.
+FlowScriptTokensHandle = ctypes.c_void_p
+
+scan_flowscript_file = job_system_lib.ScanFlowScriptFile
+scan_flowscript_file.argtypes = [ctypes.c_char_p]
+scan_flowscript_file.restype = FlowScriptTokensHandle
+
+get_flowscript_num_tokens = job_system_lib.GetFlowScriptNumTokens
+get_flowscript_num_tokens.argtypes = [FlowScriptTokensHandle]
+get_flowscript_num_tokens.restype = ctypes.c_int
+
+_get_flowscript_token_arrays = job_system_lib.GetFlowScriptTokenArrays
+_get_flowscript_token_arrays.argtypes = [FlowScriptTokensHandle, POINTER(POINTER(ctypes.c_uint8)), POINTER(POINTER(ctypes.c_uint32)), POINTER(POINTER(ctypes.c_uint32)), POINTER(POINTER(ctypes.c_uint32))]
+
+_get_flowscript_source = job_system_lib.GetFlowScriptSource
+_get_flowscript_source.argtypes = [FlowScriptTokensHandle, POINTER(ctypes.c_size_t)]
+_get_flowscript_source.restype = ctypes.c_void_p
+
+get_flowscript_num_errors = job_system_lib.GetFlowScriptNumErrors
+get_flowscript_num_errors.argtypes = [FlowScriptTokensHandle]
+get_flowscript_num_errors.restype = ctypes.c_int
+
+_get_flowscript_error = job_system_lib.GetFlowScriptError
+_get_flowscript_error.argtypes = [FlowScriptTokensHandle, ctypes.c_int, POINTER(ctypes.c_int)]
+_get_flowscript_error.restype = ctypes.c_char_p
+
+free_flowscript_tokens = job_system_lib.FreeFlowScriptTokens
+free_flowscript_tokens.argtypes = [FlowScriptTokensHandle]
+
+def get_flowscript_token_arrays(tokens_handle):
+    """(types, offsets, lengths, lines) of every token, as memoryviews over the scanner's arrays. Valid until the handle is freed."""
+    num_tokens = get_flowscript_num_tokens(tokens_handle)
+    types = POINTER(ctypes.c_uint8)()
+    offsets = POINTER(ctypes.c_uint32)()
+    lengths = POINTER(ctypes.c_uint32)()
+    lines = POINTER(ctypes.c_uint32)()
+    _get_flowscript_token_arrays(tokens_handle, ctypes.byref(types), ctypes.byref(offsets), ctypes.byref(lengths), ctypes.byref(lines))
+    return (_array_view(types, num_tokens, ctypes.c_uint8, 'B'), _array_view(offsets, num_tokens, ctypes.c_uint32, 'I'),
+            _array_view(lengths, num_tokens, ctypes.c_uint32, 'I'), _array_view(lines, num_tokens, ctypes.c_uint32, 'I'))
+
+def _array_view(pointer, num_items: int, item_type, item_format: str):
+    # ctypes arrays have a '<I'-like format, memoryview only casts from bytes
+    return memoryview((item_type * num_items).from_address(ctypes.addressof(pointer.contents))).cast('B').cast(item_format)
+
+def get_flowscript_source(tokens_handle):
+    """The script's bytes, as a memoryview over the mapped file"""
+    source_size = ctypes.c_size_t(0)
+    address = _get_flowscript_source(tokens_handle, ctypes.byref(source_size))
+    if not address or source_size.value == 0:
+        return memoryview(b"")
+    return memoryview((ctypes.c_char * source_size.value).from_address(address)).cast('B')
+
+def get_flowscript_errors(tokens_handle):
+    """(line, message) of every lexical error, in the order they were met"""
+    errors = []
+    for error_index in range(get_flowscript_num_errors(tokens_handle)):
+        line = ctypes.c_int(0)
+        message = _get_flowscript_error(tokens_handle, error_index, ctypes.byref(line))
+        errors.append((line.value, message.decode('utf-8', errors='replace')))
+    return errors
+
+# Function to pick how ready jobs are ordered. 0: FIFO, 1: critical path first
+JOB_SCHEDULING_FIFO = 0
+JOB_SCHEDULING_CRITICAL_PATH = 1
+set_scheduling_mode = job_system_lib.SetSchedulingMode
+set_scheduling_mode.argtypes = [JobSystemHandle, ctypes.c_int]
+
+# Function to set how many compile processes (make and its children) may run at once, across all compile jobs
+set_compile_parallelism = job_system_lib.SetCompileParallelism
+set_compile_parallelism.argtypes = [JobSystemHandle, ctypes.c_int]
+
+# Functions to bound how many workers serve a channel. The pool controller grows and shrinks the pool within those bounds
+JOB_CHANNEL_COMPILE = 0x10000000
+JOB_CHANNEL_PARSING = 0x20000000
+JOB_CHANNEL_JSON    = 0x40000000
+JOB_CHANNEL_OTHER   = 0x8000000
+set_worker_pool_limits = job_system_lib.SetWorkerPoolLimits
+set_worker_pool_limits.argtypes = [JobSystemHandle, ctypes.c_ulong, ctypes.c_int, ctypes.c_int]
+
+start_worker_pool_controller = job_system_lib.StartWorkerPoolController
+start_worker_pool_controller.argtypes = [JobSystemHandle]
+
+stop_worker_pool_controller = job_system_lib.StopWorkerPoolController
+stop_worker_pool_controller.argtypes = [JobSystemHandle]
+
+# Function to pin the workers of a channel to CPUs. The cpu list (e.g. b"0-3,8") is only used by WORKER_PLACEMENT_CPU_SET
+WORKER_PLACEMENT_NONE         = 0
+WORKER_PLACEMENT_WHOLE_CORES  = 1
+WORKER_PLACEMENT_SMT_SIBLINGS = 2
+WORKER_PLACEMENT_CPU_SET      = 3
+set_worker_placement = job_system_lib.SetWorkerPlacement
+set_worker_placement.argtypes = [JobSystemHandle, ctypes.c_ulong, ctypes.c_int, ctypes.c_char_p]
+
+# Function to run the jobs of a channel in separate jobworker processes (None: the jobworker.out built with the library)
+set_worker_processes = job_system_lib.SetWorkerProcesses
+set_worker_processes.argtypes = [JobSystemHandle, ctypes.c_ulong, ctypes.c_char_p]
+
+# Functions to journal every job submission and status change, and to pick up where a crashed run left off.
+# recover_from_journal returns the number of jobs found in the journal (-1 if there is none), and keeps journaling to it.
+enable_job_journal = job_system_lib.EnableJobJournal
+enable_job_journal.argtypes = [JobSystemHandle, ctypes.c_char_p]
+enable_job_journal.restype = ctypes.c_int
+
+recover_from_journal = job_system_lib.RecoverFromJournal
+recover_from_journal.argtypes = [JobSystemHandle, ctypes.c_char_p]
+recover_from_journal.restype = ctypes.c_int
+
+sync_job_journal = job_system_lib.SyncJobJournal
+sync_job_journal.argtypes = [JobSystemHandle]
+
+# Function to keep job statuses and outputs in memory-mapped files, readable after exit (see Code/tools/history_inspector.py)
+enable_job_history_store = job_system_lib.EnableJobHistoryStore
+enable_job_history_store.argtypes = [JobSystemHandle, ctypes.c_char_p]
+enable_job_history_store.restype = ctypes.c_int
+
+# Functions to submit jobs from another process, through a shared-memory ring the job system drains (see Code/lib/jobring.h)
+JobRingHandle = ctypes.c_void_p
+JOB_RING_REJECTED = -1
+
+enable_job_submission_ring = job_system_lib.EnableJobSubmissionRing
+enable_job_submission_ring.argtypes = [JobSystemHandle, ctypes.c_char_p, ctypes.c_ulonglong]
+enable_job_submission_ring.restype = ctypes.c_int
+
+open_job_ring = job_system_lib.OpenJobRing
+open_job_ring.argtypes = [ctypes.c_char_p]
+open_job_ring.restype = JobRingHandle
+
+close_job_ring = job_system_lib.CloseJobRing
+close_job_ring.argtypes = [JobRingHandle]
+
+submit_job_to_ring = job_system_lib.SubmitJobToRing
+submit_job_to_ring.argtypes = [JobRingHandle, ctypes.c_ulonglong, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int, POINTER(ctypes.c_ulonglong), ctypes.c_int, ctypes.c_int]
+submit_job_to_ring.restype = ctypes.c_int
+
+poll_job_ring_completion = job_system_lib.PollJobRingCompletion
+poll_job_ring_completion.argtypes = [JobRingHandle, POINTER(ctypes.c_ulonglong), POINTER(c_int), POINTER(c_int), ctypes.c_char_p, ctypes.c_size_t]
+poll_job_ring_completion.restype = ctypes.c_longlong
+
+def poll_ring_completion(ring_handle):
+    """Next completion of the ring as (tag, job_id, status, output bytes), None if there is none yet."""
+    tag, job_id, status = ctypes.c_ulonglong(), c_int(), c_int()
+    buffer = ctypes.create_string_buffer(64 * 1024)
+    size = poll_job_ring_completion(ring_handle, ctypes.byref(tag), ctypes.byref(job_id), ctypes.byref(status), buffer, len(buffer))
+    if size > len(buffer):
+        buffer = ctypes.create_string_buffer(size)
+        size = poll_job_ring_completion(ring_handle, ctypes.byref(tag), ctypes.byref(job_id), ctypes.byref(status), buffer, len(buffer))
+    if size < 0:
+        return None
+    return tag.value, job_id.value, status.value, buffer.raw[:size]
+
 
 
 if __name__ == "__main__":
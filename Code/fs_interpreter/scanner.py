@@ -25,7 +25,9 @@ class Scanner:
         "test"      : TokenType.TEST,
         "if_true"   : TokenType.IF_TRUE,
         "else"      : TokenType.ELSE,
-        "diamond"   : TokenType.DIAMOND
+        "diamond"   : TokenType.DIAMOND,
+        "priority"  : TokenType.PRIORITY,
+        "foreach"   : TokenType.FOREACH
     }
 
     def __init__(self, source: str):
@@ -200,4 +202,61 @@ class Scanner:
     
     def is_alpha_numeric(self, c: str) -> bool:
         return self.is_alpha(c) or self.is_digit(c)
-        
\ No newline at end of file
+        
+
+TOKEN_TYPES_BY_VALUE = {token_type.value: token_type for token_type in TokenType}
+
+# NOTE: Tokens of the native scanner (FlowScriptScanner, in the job system library). The file is scanned
+#       in one pass into flat arrays: "types" is what the parser checks, token after token. A Token (and
+#       the copy of its lexeme) is only built when the parser asks for one, for the few it keeps.
+class NativeTokens:
+    def __init__(self, path: str):
+        import job_sys_functions # Loads the library, only when the native scanner is used
+        self.lib = job_sys_functions
+        self.handle = job_sys_functions.scan_flowscript_file(path.encode('utf-8'))
+        if not self.handle:
+            raise OSError(f"Unable to read {path}")
+
+        self.types, self.offsets, self.lengths, self.lines = job_sys_functions.get_flowscript_token_arrays(self.handle)
+        self.source = job_sys_functions.get_flowscript_source(self.handle)
+
+        self.token_types = [TOKEN_TYPES_BY_VALUE[token_type] for token_type in self.types] # What the parser compares, without the cost of TokenType(value)
+        self.last_index = -1 # The parser asks for the same token a few times in a row (advance(), then previous())
+        self.last_token = None
+
+        # Reported like the Python scanner does, as it meets them
+        for line, message in job_sys_functions.get_flowscript_errors(self.handle):
+            flowscript.FlowScript.error(line, message)
+
+    def __del__(self):
+        if getattr(self, "handle", None):
+            # The views point into the scanner's arrays and mapping: released before they go away
+            for view in (self.types, self.offsets, self.lengths, self.lines, self.source):
+                view.release()
+            self.lib.free_flowscript_tokens(self.handle)
+            self.handle = None
+
+    def __len__(self) -> int:
+        return len(self.types)
+
+    def __getitem__(self, index: int) -> Token:
+        if index < 0:
+            index += len(self.types)
+        if index == self.last_index:
+            return self.last_token
+
+        token_type = self.token_types[index]
+        offset = self.offsets[index]
+        lexeme = str(self.source[offset: offset + self.lengths[index]], 'utf-8')
+        if '\r' in lexeme:
+            lexeme = lexeme.replace('\r\n', '\n') # The Python scanner reads the file in text mode
+
+        literal = None
+        if token_type == TokenType.STRING:
+            literal = lexeme[1:-1].replace('\\"', '"')
+        elif token_type == TokenType.NUMBER:
+            literal = float(lexeme)
+
+        self.last_index = index
+        self.last_token = Token(token_type, lexeme, literal, self.lines[index])
+        return self.last_token
@@ -55,6 +55,8 @@ class TokenType(Enum):
     IF_TRUE         = auto()
     ELSE            = auto()
     DIAMOND         = auto()
+    PRIORITY        = auto()
+    FOREACH         = auto()
 
     # End of file token
     EOF             = auto()
\ No newline at end of file
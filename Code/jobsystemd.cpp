@@ -0,0 +1,48 @@
+// A long-lived job system, served on a Unix domain socket (see lib/jobsystemdaemon.h).
+// FlowScript runs with --daemon submit their jobs here, instead of starting (and tearing down) a job system each.
+//
+//   ./Code/jobsystemd.out                          -> listens on ./Data/jobsystemd.sock
+//   ./Code/jobsystemd.out /tmp/jobsystemd.sock
+#include <iostream>
+#include <string>
+#include <csignal>
+
+#include "lib/jobsystem.h"
+#include "lib/jobsystemdaemon.h"
+
+static JobSystemDaemon* s_daemon = nullptr;
+
+static void OnSignal(int){
+    if(s_daemon != nullptr){
+        s_daemon->RequestShutdown();
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    std::string socketPath = argc > 1 ? argv[1] : "./Data/jobsystemd.sock";
+
+    // A client going away mid-reply is its problem, not ours
+    signal(SIGPIPE, SIG_IGN);
+
+    InitJobSystem();
+    JobSystemDaemon* daemon = new JobSystemDaemon(JobSystem::CreateOrGet(), socketPath);
+    if(!daemon->Listen()){
+        delete daemon;
+        JobSystem::Destroy();
+        return 1;
+    }
+
+    s_daemon = daemon;
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    std::cout << "jobsystemd listening on " << socketPath << std::endl;
+    daemon->Serve();
+
+    s_daemon = nullptr;
+    delete daemon;
+    JobSystem::Destroy();
+    std::cout << "jobsystemd stopped" << std::endl;
+    return 0;
+}
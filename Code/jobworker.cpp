@@ -0,0 +1,51 @@
+// Runs the jobs a job system sends it, one at a time, until the job system closes the socket.
+// Started by the job system itself (see JobSystem::SetWorkerProcesses), not by hand.
+#include <iostream>
+#include <cstdlib>
+#include <csignal>
+#include <thread>
+
+#include "lib/jobsystem.h"
+#include "lib/workerprocess.h"
+
+int main(int argc, char const *argv[])
+{
+    if(argc < 2){
+        std::cerr << "Usage: " << argv[0] << " <socket file descriptor>" << std::endl;
+        return 1;
+    }
+
+    int socketFD = std::atoi(argv[1]);
+
+    // The job system closing its end is our cue to exit, not a reason to die writing a reply
+    signal(SIGPIPE, SIG_IGN);
+
+    // NOTE:    The job system sends us INTERRUPT_SIGNAL to time out (or cancel) the job we run. It is blocked
+    //          BEFORE any thread starts, so every thread inherits the mask, and only this one receives it.
+    //          It can then lock what it needs, unlike a signal handler.
+    sigset_t interruptSignal;
+    sigemptyset(&interruptSignal);
+    sigaddset(&interruptSignal, WorkerProcess::INTERRUPT_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &interruptSignal, nullptr);
+    std::thread([interruptSignal](){
+        int signalNumber;
+        while(sigwait(&interruptSignal, &signalNumber) == 0){
+            JobSystem::CreateOrGet()->InterruptJobRequest();
+        }
+    }).detach();
+
+    // Only the job types. No worker threads: jobs run right here, one at a time.
+    JobSystem* jobSystem = JobSystem::CreateOrGet();
+    jobSystem->RegisterBuiltInJobTypes();
+
+    json request;
+    while(ReadJobFrame(socketFD, request)){
+        json reply = jobSystem->ExecuteJobRequest(request);
+        if(!WriteJobFrame(socketFD, reply)){
+            break;
+        }
+    }
+
+    JobSystem::Destroy();
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <iomanip>
+#include <cctype>
+
+#include "buildmanifest.h"
+
+namespace fs = std::filesystem;
+
+static std::string hashToString(uint64_t hash){
+    std::ostringstream hashStream;
+    hashStream << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hashStream.str();
+}
+
+BuildManifest::BuildManifest(const std::string& manifestPath): m_manifestPath(manifestPath){
+    m_entries = json::object();
+
+    std::ifstream file(m_manifestPath);
+    if(file.is_open()){
+        try {
+            m_entries = json::parse(file);
+        } catch (const json::exception& error) {
+            std::cerr << "Warning: Ignoring corrupted build manifest '" << m_manifestPath << "': " << error.what() << std::endl;
+            m_entries = json::object();
+        }
+    }
+}
+
+bool BuildManifest::IsUpToDate(const std::string& outputPath, const std::string& command){
+    std::error_code errorCode;
+    if(!fs::exists(outputPath, errorCode)){
+        return false;
+    }
+
+    m_manifestMutex.lock();
+    json entry;
+    auto entryIter = m_entries.find(outputPath);
+    if(entryIter != m_entries.end()){
+        entry = *entryIter;
+    }
+    m_manifestMutex.unlock();
+
+    if(entry.is_null() || entry.value("command", "") != command){
+        return false;
+    }
+
+    // Hash outside of the lock. Other jobs may be checking their own outputs meanwhile.
+    for(auto& input: entry["inputs"].items()){
+        uint64_t currentHash = 0;
+        if(!HashFile(input.key(), currentHash) || hashToString(currentHash) != input.value().get<std::string>()){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BuildManifest::Record(const std::string& outputPath, const std::string& command, const std::vector<std::string>& inputPaths, const std::string& diagnostics){
+    json entry;
+    entry["command"] = command;
+    entry["inputs"] = json::object();
+    entry["diagnostics"] = diagnostics;
+
+    for(const std::string& inputPath: inputPaths){
+        uint64_t hash = 0;
+        if(!HashFile(inputPath, hash)){
+            Forget(outputPath); // Cannot vouch for an input we cannot read. Rebuild next time.
+            return;
+        }
+        entry["inputs"][inputPath] = hashToString(hash);
+    }
+
+    m_manifestMutex.lock();
+    m_entries[outputPath] = entry;
+    m_manifestMutex.unlock();
+}
+
+void BuildManifest::Forget(const std::string& outputPath){
+    m_manifestMutex.lock();
+    m_entries.erase(outputPath);
+    m_manifestMutex.unlock();
+}
+
+std::string BuildManifest::GetDiagnostics(const std::string& outputPath) const{
+    m_manifestMutex.lock();
+    std::string diagnostics;
+    auto entryIter = m_entries.find(outputPath);
+    if(entryIter != m_entries.end()){
+        diagnostics = entryIter->value("diagnostics", "");
+    }
+    m_manifestMutex.unlock();
+
+    return diagnostics;
+}
+
+void BuildManifest::AcquireOutput(const std::string& outputPath){
+    std::unique_lock<std::mutex> lock(m_manifestMutex);
+    m_outputReleased.wait(lock, [&](){ return m_outputsBeingBuilt.count(outputPath) == 0; });
+    m_outputsBeingBuilt.insert(outputPath);
+}
+
+void BuildManifest::ReleaseOutput(const std::string& outputPath){
+    m_manifestMutex.lock();
+    m_outputsBeingBuilt.erase(outputPath);
+    m_manifestMutex.unlock();
+
+    m_outputReleased.notify_all();
+}
+
+void BuildManifest::Save() const{
+    m_manifestMutex.lock();
+    std::string content = m_entries.dump(4);
+    m_manifestMutex.unlock();
+
+    // Write next to it, then swap, so a crash never leaves a half written manifest behind
+    std::string tempPath = m_manifestPath + ".tmp";
+    std::ofstream file(tempPath);
+    if(!file.is_open()){
+        std::cerr << "Failed to save the build manifest: " << m_manifestPath << std::endl;
+        return;
+    }
+    file << content;
+    file.close();
+
+    std::error_code errorCode;
+    fs::rename(tempPath, m_manifestPath, errorCode);
+    if(errorCode){
+        std::cerr << "Failed to save the build manifest: " << m_manifestPath << std::endl;
+    }
+}
+
+// NOTE:    Depfiles look like "main.o: main.cpp functions.h \"
+//          Paths are separated by spaces, a backslash at the end of a line continues it,
+//          and a space that belongs to a path is escaped with a backslash.
+std::vector<std::string> BuildManifest::ParseDepfile(const std::string& depfilePath){
+    std::vector<std::string> inputPaths;
+
+    std::ifstream file(depfilePath);
+    if(!file.is_open()){
+        return inputPaths;
+    }
+
+    std::stringstream contentStream;
+    contentStream << file.rdbuf();
+    std::string content = contentStream.str();
+
+    // Skip the target, everything after the first unescaped ':' followed by whitespace is an input
+    size_t position = 0;
+    while(position < content.size()){
+        if(content[position] == ':' && (position + 1 == content.size() || std::isspace((unsigned char)content[position + 1]))){
+            position++;
+            break;
+        }
+        position++;
+    }
+
+    std::string currentPath;
+    for(; position < content.size(); position++){
+        char c = content[position];
+
+        if(c == '\\' && position + 1 < content.size()){
+            char next = content[position + 1];
+            if(next == '\n' || next == '\r'){
+                position++; // Line continuation
+                continue;
+            }
+            if(next == ' '){
+                currentPath += ' ';
+                position++;
+                continue;
+            }
+        }
+
+        if(std::isspace((unsigned char)c)){
+            if(!currentPath.empty()){
+                inputPaths.push_back(currentPath);
+                currentPath.clear();
+            }
+            continue;
+        }
+
+        currentPath += c;
+    }
+
+    if(!currentPath.empty()){
+        inputPaths.push_back(currentPath);
+    }
+
+    return inputPaths;
+}
+
+// FNV-1a, 64 bits. Not cryptographic, but we only need to notice that a file changed.
+bool BuildManifest::HashFile(const std::string& filePath, uint64_t& hash){
+    std::error_code errorCode;
+    uintmax_t size = fs::file_size(filePath, errorCode);
+    if(errorCode){
+        return false;
+    }
+    int64_t modificationTime = (int64_t)fs::last_write_time(filePath, errorCode).time_since_epoch().count();
+    if(errorCode){
+        return false;
+    }
+
+    m_manifestMutex.lock();
+    auto cacheIter = m_fileHashCache.find(filePath);
+    if(cacheIter != m_fileHashCache.end() && cacheIter->second.m_modificationTime == modificationTime && cacheIter->second.m_size == size){
+        hash = cacheIter->second.m_hash;
+        m_manifestMutex.unlock();
+        return true;
+    }
+    m_manifestMutex.unlock();
+
+    std::ifstream file(filePath, std::ios::binary);
+    if(!file.is_open()){
+        return false;
+    }
+
+    hash = 14695981039346656037ULL;
+    char buffer[64 * 1024];
+    while(file.read(buffer, sizeof(buffer)) || file.gcount() > 0){
+        std::streamsize numBytesRead = file.gcount();
+        for(std::streamsize i = 0; i < numBytesRead; i++){
+            hash ^= (unsigned char)buffer[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    CachedFileHash cachedHash;
+    cachedHash.m_modificationTime = modificationTime;
+    cachedHash.m_size = size;
+    cachedHash.m_hash = hash;
+
+    m_manifestMutex.lock();
+    m_fileHashCache[filePath] = cachedHash;
+    m_manifestMutex.unlock();
+
+    return true;
+}
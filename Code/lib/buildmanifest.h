@@ -0,0 +1,52 @@
+// Remembers what every object file was built from, so incremental compile jobs only rebuild what changed
+#pragma once
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// NOTE:    Make decides what to rebuild from modification times, against a tree that every compile
+//          job shares. Here, each output records the exact command that produced it and a content hash
+//          of every input it read (the source, plus the headers listed in the compiler's -MD depfile).
+//          An output is up to date only if the command is the same and none of those hashes changed.
+class BuildManifest
+{
+public:
+    explicit BuildManifest(const std::string& manifestPath);
+
+    bool IsUpToDate(const std::string& outputPath, const std::string& command);
+    void Record(const std::string& outputPath, const std::string& command, const std::vector<std::string>& inputPaths, const std::string& diagnostics = "");
+    void Forget(const std::string& outputPath);
+    std::string GetDiagnostics(const std::string& outputPath) const; // Compiler output saved with the last successful build
+
+    // Only one job at a time may build a given output. The others wait, then find it up to date.
+    void AcquireOutput(const std::string& outputPath);
+    void ReleaseOutput(const std::string& outputPath);
+
+    void Save() const;
+
+    static std::vector<std::string> ParseDepfile(const std::string& depfilePath); // Inputs listed in a make-style depfile
+
+private:
+    bool HashFile(const std::string& filePath, uint64_t& hash); // Cached by modification time and size
+
+    struct CachedFileHash
+    {
+        int64_t m_modificationTime = 0;
+        uintmax_t m_size = 0;
+        uint64_t m_hash = 0;
+    };
+
+    std::string                                 m_manifestPath;
+    json                                        m_entries; // output path -> { "command", "inputs": { path: hash }, "diagnostics" }
+    std::map<std::string, CachedFileHash>       m_fileHashCache;
+    std::set<std::string>                       m_outputsBeingBuilt;
+    mutable std::mutex                          m_manifestMutex;
+    std::condition_variable                     m_outputReleased;
+};
@@ -0,0 +1,524 @@
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
+
+#include "fileioservice.h"
+
+// Steps of a request, in order
+enum FileIOStep
+{
+    FILE_IO_STEP_OPEN,
+    FILE_IO_STEP_TRANSFER, // Read or write, as many times as it takes
+    FILE_IO_STEP_CLOSE
+};
+
+constexpr size_t FILE_IO_FIRST_READ_SIZE = 16 * 1024; // Doubled every time the file turns out to be bigger
+constexpr uint64_t FILE_IO_WAKE_USER_DATA = 0; // Completion of the poll on "m_wakeFD". Steps carry their request.
+
+//-------------------------------------------------------------------------------------------------
+// FileIOBatch
+
+FileIOBatch::~FileIOBatch(){
+    if(m_completionFD >= 0){
+        close(m_completionFD);
+    }
+}
+
+size_t FileIOBatch::Read(const std::string& path){
+    m_requests.emplace_back(FILE_IO_READ, path, "");
+    return m_requests.size() - 1;
+}
+
+size_t FileIOBatch::Write(const std::string& path, std::string data){
+    m_requests.emplace_back(FILE_IO_WRITE, path, std::move(data));
+    return m_requests.size() - 1;
+}
+
+bool FileIOBatch::IsDone() const{
+    m_batchMutex.lock();
+    bool isDone = m_isSubmitted && m_numRequestsPending == 0;
+    m_batchMutex.unlock();
+
+    return isDone;
+}
+
+void FileIOBatch::Wait() const{
+    std::unique_lock<std::mutex> lock(m_batchMutex);
+    m_batchDone.wait(lock, [&](){ return m_isSubmitted && m_numRequestsPending == 0; });
+}
+
+int FileIOBatch::GetCompletionFD(){
+    m_batchMutex.lock();
+    if(m_completionFD < 0){
+        m_completionFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if(m_completionFD >= 0 && m_isSubmitted && m_numRequestsPending == 0){
+            uint64_t one = 1;
+            write(m_completionFD, &one, sizeof(one)); // Done before anyone asked
+        }
+    }
+    int completionFD = m_completionFD;
+    m_batchMutex.unlock();
+
+    return completionFD;
+}
+
+bool FileIOBatch::OnRequestDone(){
+    m_batchMutex.lock();
+    m_numRequestsPending--;
+    bool isLastRequest = (m_numRequestsPending == 0);
+    if(isLastRequest && m_completionFD >= 0){
+        uint64_t one = 1;
+        write(m_completionFD, &one, sizeof(one));
+    }
+    m_batchMutex.unlock();
+
+    if(isLastRequest){
+        m_batchDone.notify_all();
+    }
+    return isLastRequest;
+}
+
+//-------------------------------------------------------------------------------------------------
+// FileIOService
+
+FileIOService::FileIOService(int numFallbackThreads){
+    const char* disableIoUring = getenv("JOBSYSTEM_DISABLE_IO_URING");
+    if((disableIoUring == nullptr || strcmp(disableIoUring, "0") == 0) && SetUpRing(256)){
+        m_threads.push_back(new std::thread(&FileIOService::RingMain, this));
+        return;
+    }
+
+    for(int i = 0; i < (numFallbackThreads > 0 ? numFallbackThreads : 1); i++){
+        m_threads.push_back(new std::thread(&FileIOService::FallbackMain, this));
+    }
+}
+
+FileIOService::~FileIOService(){
+    m_serviceMutex.lock();
+    m_isStopping = true;
+    m_serviceMutex.unlock();
+
+    // The threads leave once everything submitted is done
+    m_requestsSubmittedSignal.notify_all();
+    if(m_wakeFD >= 0){
+        uint64_t one = 1;
+        write(m_wakeFD, &one, sizeof(one));
+    }
+
+    for(std::thread* thread: m_threads){
+        thread->join();
+        delete thread;
+    }
+    m_threads.clear();
+
+    if(m_submissionEntries){
+        munmap(m_submissionEntries, m_submissionEntriesSize);
+    }
+    if(m_completionRing && m_completionRing != m_submissionRing){
+        munmap(m_completionRing, m_completionRingSize);
+    }
+    if(m_submissionRing){
+        munmap(m_submissionRing, m_submissionRingSize);
+    }
+    if(m_ringFD >= 0){
+        close(m_ringFD);
+    }
+    if(m_wakeFD >= 0){
+        close(m_wakeFD);
+    }
+}
+
+void FileIOService::Submit(std::shared_ptr<FileIOBatch> batch){
+    batch->m_batchMutex.lock();
+    batch->m_isSubmitted = true;
+    batch->m_numRequestsPending = batch->m_requests.size();
+    batch->m_batchMutex.unlock();
+
+    if(batch->m_requests.empty()){
+        batch->m_batchDone.notify_all();
+        return;
+    }
+
+    m_serviceMutex.lock();
+    m_batchesInFlight[batch.get()] = batch;
+    for(FileIORequest& request: batch->m_requests){
+        request.m_batch = batch.get();
+        m_requestsSubmitted.push_back(&request);
+    }
+    m_serviceMutex.unlock();
+
+    if(IsUsingIoUring()){
+        uint64_t one = 1;
+        write(m_wakeFD, &one, sizeof(one));
+    } else {
+        m_requestsSubmittedSignal.notify_all();
+    }
+}
+
+void FileIOService::Flush(){
+    std::unique_lock<std::mutex> lock(m_serviceMutex);
+    m_batchesDoneSignal.wait(lock, [&](){ return m_batchesInFlight.empty(); });
+}
+
+std::shared_ptr<FileIOBatch> FileIOService::WriteFile(const std::string& path, std::string data){
+    std::shared_ptr<FileIOBatch> batch = std::make_shared<FileIOBatch>();
+    batch->Write(path, std::move(data));
+    Submit(batch);
+    return batch;
+}
+
+int FileIOService::ReadFile(const std::string& path, std::string& data){
+    std::shared_ptr<FileIOBatch> batch = std::make_shared<FileIOBatch>();
+    batch->Read(path);
+    Submit(batch);
+    batch->Wait();
+
+    data = std::move(batch->m_requests[0].m_data);
+    return batch->m_requests[0].m_result;
+}
+
+void FileIOService::OnRequestDone(FileIORequest* request){
+    if(request->m_operation == FILE_IO_WRITE && request->m_result < 0){
+        std::cerr << "Failed to create the file: " << request->m_path << " (" << strerror(-request->m_result) << ")" << std::endl; // Nobody may be waiting to hear it
+    }
+
+    FileIOBatch* batch = request->m_batch;
+    if(!batch->OnRequestDone()){
+        return;
+    }
+
+    // NOTE: May delete the batch, if nobody else holds it anymore. Nothing touches it after this.
+    m_serviceMutex.lock();
+    m_batchesInFlight.erase(batch);
+    bool isIdle = m_batchesInFlight.empty();
+    m_serviceMutex.unlock();
+
+    if(isIdle){
+        m_batchesDoneSignal.notify_all();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// io_uring
+
+// NOTE:    No liburing: the three system calls, and the layout of the rings, come straight from
+//          <linux/io_uring.h>. The kernel must support every operation we use (5.6 and up), or we
+//          fall back to threads.
+bool FileIOService::SetUpRing(unsigned numEntries){
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ringFD = (int)syscall(__NR_io_uring_setup, numEntries, &params);
+    if(m_ringFD < 0){
+        return false;
+    }
+
+    // Are the operations we need there?
+    std::vector<unsigned char> probeBuffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = (io_uring_probe*)probeBuffer.data();
+    bool hasOperations = syscall(__NR_io_uring_register, m_ringFD, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for(int operation: { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE, IORING_OP_POLL_ADD }){
+        hasOperations = hasOperations && operation <= probe->last_op && (probe->ops[operation].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    m_wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(!hasOperations || m_wakeFD < 0){
+        close(m_ringFD);
+        m_ringFD = -1;
+        return false;
+    }
+
+    m_submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool isSingleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if(isSingleMapping){
+        m_submissionRingSize = m_completionRingSize = std::max(m_submissionRingSize, m_completionRingSize);
+    }
+
+    m_submissionRing = mmap(nullptr, m_submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFD, IORING_OFF_SQ_RING);
+    if(m_submissionRing == MAP_FAILED){
+        m_submissionRing = nullptr;
+    }
+    m_completionRing = isSingleMapping ? m_submissionRing : mmap(nullptr, m_completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFD, IORING_OFF_CQ_RING);
+    if(m_completionRing == MAP_FAILED){
+        m_completionRing = nullptr;
+    }
+    m_submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_submissionEntries = mmap(nullptr, m_submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFD, IORING_OFF_SQES);
+    if(m_submissionEntries == MAP_FAILED){
+        m_submissionEntries = nullptr;
+    }
+
+    if(!m_submissionRing || !m_completionRing || !m_submissionEntries){
+        std::cerr << "Error: Unable to map the io_uring rings. File I/O falls back to threads." << std::endl;
+        if(m_submissionEntries){
+            munmap(m_submissionEntries, m_submissionEntriesSize);
+            m_submissionEntries = nullptr;
+        }
+        if(m_completionRing && m_completionRing != m_submissionRing){
+            munmap(m_completionRing, m_completionRingSize);
+        }
+        if(m_submissionRing){
+            munmap(m_submissionRing, m_submissionRingSize);
+        }
+        m_submissionRing = m_completionRing = nullptr;
+        close(m_ringFD);
+        m_ringFD = -1;
+        return false;
+    }
+
+    char* submissionRing = (char*)m_submissionRing;
+    char* completionRing = (char*)m_completionRing;
+    m_submissionTail = (unsigned*)(submissionRing + params.sq_off.tail);
+    m_submissionMask = *(unsigned*)(submissionRing + params.sq_off.ring_mask);
+    m_submissionArray = (unsigned*)(submissionRing + params.sq_off.array);
+    m_completionHead = (unsigned*)(completionRing + params.cq_off.head);
+    m_completionTail = (unsigned*)(completionRing + params.cq_off.tail);
+    m_completionMask = *(unsigned*)(completionRing + params.cq_off.ring_mask);
+    m_completionEntries = completionRing + params.cq_off.cqes;
+    m_numEntries = params.sq_entries;
+    return true;
+}
+
+// Only the ring thread writes submissions, so the tail needs no lock. Only the publication needs ordering.
+static io_uring_sqe* nextSubmissionEntry(void* submissionEntries, unsigned* submissionTail, unsigned submissionMask, unsigned* submissionArray){
+    unsigned tail = *submissionTail;
+    unsigned index = tail & submissionMask;
+    io_uring_sqe* entry = (io_uring_sqe*)submissionEntries + index;
+    memset(entry, 0, sizeof(*entry));
+    submissionArray[index] = index;
+    return entry;
+}
+
+static void publishSubmissionEntry(unsigned* submissionTail){
+    __atomic_store_n(submissionTail, *submissionTail + 1, __ATOMIC_RELEASE);
+}
+
+void FileIOService::ArmWakePoll(){
+    io_uring_sqe* entry = nextSubmissionEntry(m_submissionEntries, m_submissionTail, m_submissionMask, m_submissionArray);
+    entry->opcode = IORING_OP_POLL_ADD;
+    entry->fd = m_wakeFD;
+    entry->poll32_events = POLLIN;
+    entry->user_data = FILE_IO_WAKE_USER_DATA;
+    publishSubmissionEntry(m_submissionTail);
+    m_numEntriesToSubmit++;
+}
+
+void FileIOService::QueueStep(FileIORequest* request){
+    io_uring_sqe* entry = nextSubmissionEntry(m_submissionEntries, m_submissionTail, m_submissionMask, m_submissionArray);
+    entry->user_data = (uint64_t)(uintptr_t)request;
+
+    switch(request->m_step){
+        case FILE_IO_STEP_OPEN:
+            entry->opcode = IORING_OP_OPENAT;
+            entry->fd = AT_FDCWD;
+            entry->addr = (uint64_t)(uintptr_t)request->m_path.c_str();
+            entry->open_flags = (request->m_operation == FILE_IO_READ) ? (O_RDONLY | O_CLOEXEC) : (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+            entry->len = 0644;
+            break;
+        case FILE_IO_STEP_TRANSFER:
+            entry->opcode = (request->m_operation == FILE_IO_READ) ? IORING_OP_READ : IORING_OP_WRITE;
+            entry->fd = request->m_fileDescriptor;
+            entry->addr = (uint64_t)(uintptr_t)(&request->m_data[0] + request->m_offset);
+            entry->len = (unsigned)std::min<size_t>(request->m_data.size() - request->m_offset, 1u << 30);
+            entry->off = request->m_offset;
+            break;
+        default:
+            entry->opcode = IORING_OP_CLOSE;
+            entry->fd = request->m_fileDescriptor;
+            break;
+    }
+
+    publishSubmissionEntry(m_submissionTail);
+    m_numEntriesToSubmit++;
+    m_numStepsInFlight++;
+}
+
+void FileIOService::OnStepDone(FileIORequest* request, int stepResult){
+    switch(request->m_step){
+        case FILE_IO_STEP_OPEN:
+            if(stepResult < 0){
+                request->m_result = stepResult;
+                request->m_data.clear();
+                OnRequestDone(request);
+                return;
+            }
+            request->m_fileDescriptor = stepResult;
+            request->m_offset = 0;
+            request->m_step = FILE_IO_STEP_TRANSFER;
+            if(request->m_operation == FILE_IO_READ){
+                request->m_data.resize(FILE_IO_FIRST_READ_SIZE);
+            } else if (request->m_data.empty()){
+                request->m_step = FILE_IO_STEP_CLOSE; // Nothing to write, the file is already truncated
+            }
+            break;
+
+        case FILE_IO_STEP_TRANSFER:
+            if(stepResult == -EINTR || stepResult == -EAGAIN){
+                break; // Same step, again
+            }
+            if(stepResult < 0){
+                request->m_result = stepResult;
+                request->m_step = FILE_IO_STEP_CLOSE;
+                if(request->m_operation == FILE_IO_READ){
+                    request->m_data.clear();
+                }
+                break;
+            }
+
+            if(request->m_operation == FILE_IO_READ){
+                if(stepResult == 0){
+                    request->m_data.resize(request->m_offset); // End of file
+                    request->m_step = FILE_IO_STEP_CLOSE;
+                } else {
+                    request->m_offset += stepResult;
+                    if(request->m_offset == request->m_data.size()){
+                        request->m_data.resize(request->m_data.size() * 2);
+                    }
+                }
+            } else {
+                request->m_offset += stepResult;
+                if(request->m_offset >= request->m_data.size()){
+                    request->m_step = FILE_IO_STEP_CLOSE;
+                }
+            }
+            break;
+
+        default:
+            request->m_fileDescriptor = -1;
+            OnRequestDone(request);
+            return;
+    }
+
+    m_stepsToQueue.push_back(request);
+}
+
+// NOTE:    One io_uring_enter() per round: it hands every step written since the last round to the
+//          kernel, and waits for at least one to complete. The poll on "m_wakeFD" always being in
+//          flight is what lets Submit() interrupt that wait. One entry of the ring is kept for it.
+void FileIOService::RingMain(){
+    ArmWakePoll();
+
+    while(true){
+        m_serviceMutex.lock();
+        for(FileIORequest* request: m_requestsSubmitted){
+            request->m_step = FILE_IO_STEP_OPEN;
+            m_stepsToQueue.push_back(request);
+        }
+        m_requestsSubmitted.clear();
+        bool isStopping = m_isStopping;
+        m_serviceMutex.unlock();
+
+        if(isStopping && m_stepsToQueue.empty() && m_numStepsInFlight == 0){
+            break;
+        }
+
+        while(!m_stepsToQueue.empty() && m_numStepsInFlight + 1 < m_numEntries){
+            QueueStep(m_stepsToQueue.front());
+            m_stepsToQueue.pop_front();
+        }
+
+        int numSubmitted = (int)syscall(__NR_io_uring_enter, m_ringFD, m_numEntriesToSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if(numSubmitted >= 0){
+            m_numEntriesToSubmit -= numSubmitted;
+        } else if(errno != EINTR && errno != EAGAIN && errno != EBUSY){
+            std::cerr << "Error: io_uring_enter failed (" << strerror(errno) << ")" << std::endl;
+        }
+
+        unsigned head = *m_completionHead;
+        unsigned tail = __atomic_load_n(m_completionTail, __ATOMIC_ACQUIRE);
+        for(; head != tail; head++){
+            io_uring_cqe* completion = (io_uring_cqe*)m_completionEntries + (head & m_completionMask);
+            uint64_t userData = completion->user_data;
+            int result = completion->res;
+
+            if(userData == FILE_IO_WAKE_USER_DATA){
+                uint64_t numWakes;
+                read(m_wakeFD, &numWakes, sizeof(numWakes));
+                ArmWakePoll();
+                continue;
+            }
+
+            m_numStepsInFlight--;
+            OnStepDone((FileIORequest*)(uintptr_t)userData, result);
+        }
+        __atomic_store_n(m_completionHead, head, __ATOMIC_RELEASE);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Fallback: blocking system calls, on a few threads
+
+void FileIOService::FallbackMain(){
+    while(true){
+        std::unique_lock<std::mutex> lock(m_serviceMutex);
+        m_requestsSubmittedSignal.wait(lock, [&](){ return !m_requestsSubmitted.empty() || m_isStopping; });
+        if(m_requestsSubmitted.empty()){
+            return; // Stopping, and nothing left to do
+        }
+
+        FileIORequest* request = m_requestsSubmitted.front();
+        m_requestsSubmitted.pop_front();
+        lock.unlock();
+
+        ExecuteBlocking(*request);
+        OnRequestDone(request);
+    }
+}
+
+void FileIOService::ExecuteBlocking(FileIORequest& request){
+    bool isRead = (request.m_operation == FILE_IO_READ);
+    int fileDescriptor = open(request.m_path.c_str(), isRead ? (O_RDONLY | O_CLOEXEC) : (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC), 0644);
+    if(fileDescriptor < 0){
+        request.m_result = -errno;
+        request.m_data.clear();
+        return;
+    }
+
+    if(isRead){
+        request.m_data.resize(FILE_IO_FIRST_READ_SIZE);
+        size_t offset = 0;
+        while(true){
+            ssize_t numBytesRead = read(fileDescriptor, &request.m_data[offset], request.m_data.size() - offset);
+            if(numBytesRead < 0 && errno == EINTR){
+                continue;
+            }
+            if(numBytesRead < 0){
+                request.m_result = -errno;
+                offset = 0;
+                break;
+            }
+            if(numBytesRead == 0){
+                break;
+            }
+            offset += numBytesRead;
+            if(offset == request.m_data.size()){
+                request.m_data.resize(request.m_data.size() * 2);
+            }
+        }
+        request.m_data.resize(offset);
+    } else {
+        size_t offset = 0;
+        while(offset < request.m_data.size()){
+            ssize_t numBytesWritten = write(fileDescriptor, request.m_data.data() + offset, request.m_data.size() - offset);
+            if(numBytesWritten < 0 && errno == EINTR){
+                continue;
+            }
+            if(numBytesWritten < 0){
+                request.m_result = -errno;
+                break;
+            }
+            offset += numBytesWritten;
+        }
+    }
+
+    close(fileDescriptor);
+}
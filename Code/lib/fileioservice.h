@@ -0,0 +1,131 @@
+// Reads and writes whole files for the jobs, in batches, with io_uring when the kernel has it
+#pragma once
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+enum FileIOOperation
+{
+    FILE_IO_READ,   // The whole file, into "m_data"
+    FILE_IO_WRITE,  // "m_data", replacing the file
+    NUM_FILE_IO_OPERATIONS
+};
+
+class FileIOBatch;
+
+struct FileIORequest
+{
+    FileIORequest(FileIOOperation operation, const std::string& path, std::string data) : m_operation(operation), m_path(path), m_data(std::move(data)) {}
+
+    FileIOOperation m_operation;
+    std::string     m_path;
+    std::string     m_data;
+    int             m_result = 0; // 0, or -errno of the first step that failed
+
+    // Where the request is at. Only touched by the service.
+    FileIOBatch*    m_batch = nullptr;
+    int             m_fileDescriptor = -1;
+    size_t          m_offset = 0;
+    int             m_step = 0; // The one in flight: open, read / write, close
+};
+
+// NOTE:    Requests are added, then the whole batch is submitted at once. It completes when every one
+//          of its requests did (successfully or not). A job can Wait() for it, or suspend on its
+//          completion file descriptor (see Job::AwaitReadable) and leave its worker free meanwhile.
+class FileIOBatch
+{
+    friend class FileIOService;
+
+public:
+    FileIOBatch() {}
+    ~FileIOBatch();
+
+    size_t Read(const std::string& path); // Index of the request
+    size_t Write(const std::string& path, std::string data);
+
+    bool IsDone() const;
+    void Wait() const;
+    int GetCompletionFD(); // Readable once the batch is done. Created on demand, closed with the batch.
+
+    size_t GetNumRequests() const { return m_requests.size(); }
+    const std::string& GetData(size_t requestIndex) const { return m_requests[requestIndex].m_data; } // Only once done
+    int GetResult(size_t requestIndex) const { return m_requests[requestIndex].m_result; }
+
+private:
+    bool OnRequestDone(); // Called by the service, once per request. True for the last one.
+
+    std::vector<FileIORequest>      m_requests; // Not touched by anyone but the service once submitted
+    size_t                          m_numRequestsPending = 0;
+    bool                            m_isSubmitted = false;
+    int                             m_completionFD = -1;
+    mutable std::mutex              m_batchMutex;
+    mutable std::condition_variable m_batchDone;
+};
+
+// NOTE:    With io_uring, one thread owns the ring. Each request is a small state machine (open, read
+//          or write until done, close), and every step of every request in flight goes to the kernel
+//          in the same io_uring_enter() call, which also collects the steps that completed. Thousands
+//          of output files cost a handful of system calls instead of several each. Without io_uring
+//          (old kernel, seccomp, JOBSYSTEM_DISABLE_IO_URING set), a few threads do the same, blocking.
+class FileIOService
+{
+public:
+    explicit FileIOService(int numFallbackThreads = 2);
+    ~FileIOService(); // Completes whatever was submitted first
+
+    bool IsUsingIoUring() const { return m_ringFD >= 0; }
+
+    void Submit(std::shared_ptr<FileIOBatch> batch); // The service keeps the batch alive until it is done
+    void Flush(); // Blocks until no batch is in flight anymore
+
+    // Shortcuts for a single request
+    std::shared_ptr<FileIOBatch> WriteFile(const std::string& path, std::string data); // Does not wait
+    int ReadFile(const std::string& path, std::string& data); // Waits. 0, or -errno.
+
+private:
+    bool SetUpRing(unsigned numEntries);
+    void RingMain(); // Called in the ring thread, runs until the service is destroyed
+    void OnStepDone(FileIORequest* request, int stepResult); // Moves the request to its next step (or finishes it)
+    void QueueStep(FileIORequest* request); // Into the submission ring. Expects room in it.
+    void ArmWakePoll();
+
+    void FallbackMain(); // Called in every fallback thread
+    static void ExecuteBlocking(FileIORequest& request);
+
+    void OnRequestDone(FileIORequest* request);
+
+    // io_uring, when it could be set up
+    int                     m_ringFD = -1;
+    int                     m_wakeFD = -1; // eventfd the ring polls, so Submit() can wake the ring thread up
+    void*                   m_submissionRing = nullptr;
+    void*                   m_completionRing = nullptr; // Same mapping as the submission ring on recent kernels
+    size_t                  m_submissionRingSize = 0;
+    size_t                  m_completionRingSize = 0;
+    void*                   m_submissionEntries = nullptr;
+    size_t                  m_submissionEntriesSize = 0;
+    unsigned*               m_submissionTail = nullptr;
+    unsigned                m_submissionMask = 0;
+    unsigned*               m_submissionArray = nullptr;
+    unsigned*               m_completionHead = nullptr;
+    unsigned*               m_completionTail = nullptr;
+    unsigned                m_completionMask = 0;
+    void*                   m_completionEntries = nullptr;
+    unsigned                m_numEntries = 0;
+    unsigned                m_numStepsInFlight = 0; // Ring thread only
+    unsigned                m_numEntriesToSubmit = 0; // Ring thread only. Written in the ring, not handed to the kernel yet.
+    std::deque< FileIORequest* > m_stepsToQueue; // Ring thread only. Their next step waits for room in the ring.
+
+    std::vector<std::thread*>   m_threads; // The ring thread, or the fallback threads
+    std::deque< FileIORequest* > m_requestsSubmitted; // Not picked up by the ring (or a fallback thread) yet
+    std::unordered_map< FileIOBatch*, std::shared_ptr<FileIOBatch> > m_batchesInFlight; // Kept alive until done
+    bool                    m_isStopping = false;
+    std::mutex              m_serviceMutex;
+    std::condition_variable m_requestsSubmittedSignal; // Fallback threads only
+    std::condition_variable m_batchesDoneSignal;
+};
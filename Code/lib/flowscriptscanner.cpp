@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "flowscriptscanner.h"
+
+FlowScriptScanner::~FlowScriptScanner(){
+    if(m_mapping){
+        munmap(m_mapping, m_mappingSize);
+    }
+}
+
+bool FlowScriptScanner::ScanFile(const std::string& scriptPath){
+    int fileDescriptor = open(scriptPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0){
+        return false;
+    }
+
+    struct stat fileStatus;
+    if(fstat(fileDescriptor, &fileStatus) != 0 || (uint64_t)fileStatus.st_size > UINT32_MAX){
+        close(fileDescriptor);
+        return false; // Offsets are 32 bits
+    }
+
+    // An empty file cannot be mapped, but it scans just fine: it is only an EOF
+    if(fileStatus.st_size > 0){
+        void* mapping = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fileDescriptor, 0);
+        if(mapping == MAP_FAILED){
+            close(fileDescriptor);
+            return false;
+        }
+        madvise(mapping, fileStatus.st_size, MADV_SEQUENTIAL);
+        m_mapping = mapping;
+        m_mappingSize = fileStatus.st_size;
+    }
+    close(fileDescriptor); // The mapping stays valid
+
+    Scan((const char*)m_mapping, m_mappingSize);
+    return true;
+}
+
+// NOTE:    Same rules as Code/fs_interpreter/scanner.py, byte by byte. A token gets the line it ENDS on,
+//          like there (a string can span lines). The arrays are reserved from the size of the source:
+//          one token per 4 bytes covers any real script, so they rarely grow while scanning.
+void FlowScriptScanner::Scan(const char* source, size_t sourceSize){
+    m_source = source;
+    m_sourceSize = sourceSize;
+    m_types.clear();
+    m_offsets.clear();
+    m_lengths.clear();
+    m_lines.clear();
+    m_errors.clear();
+
+    size_t expectedNumTokens = sourceSize / 4 + 1;
+    m_types.reserve(expectedNumTokens);
+    m_offsets.reserve(expectedNumTokens);
+    m_lengths.reserve(expectedNumTokens);
+    m_lines.reserve(expectedNumTokens);
+
+    auto isDigit = [](char c){ return c >= '0' && c <= '9'; };
+    auto isAlpha = [](char c){ return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; };
+
+    uint32_t line = 1;
+    size_t current = 0;
+    while(current < sourceSize){
+        size_t start = current;
+        char c = source[current++];
+        char next = (current < sourceSize) ? source[current] : '\0';
+
+        switch(c){
+            case '[': AddToken(FS_TOKEN_LEFT_BRACK, start, current, line); break;
+            case ']': AddToken(FS_TOKEN_RIGHT_BRACK, start, current, line); break;
+            case '(': AddToken(FS_TOKEN_LEFT_PAREN, start, current, line); break;
+            case ')': AddToken(FS_TOKEN_RIGHT_PAREN, start, current, line); break;
+            case '{': AddToken(FS_TOKEN_LEFT_BRACE, start, current, line); break;
+            case '}': AddToken(FS_TOKEN_RIGHT_BRACE, start, current, line); break;
+            case ',': AddToken(FS_TOKEN_COMMA, start, current, line); break;
+            case '.': AddToken(FS_TOKEN_DOT, start, current, line); break;
+            case '+': AddToken(FS_TOKEN_PLUS, start, current, line); break;
+            case ';': AddToken(FS_TOKEN_SEMICOLON, start, current, line); break;
+            case '*': AddToken(FS_TOKEN_STAR, start, current, line); break;
+
+            // Lexemes that can be followed by another
+            case '-': current += (next == '>'); AddToken(next == '>' ? FS_TOKEN_ARROW : FS_TOKEN_MINUS, start, current, line); break;
+            case '!': current += (next == '='); AddToken(next == '=' ? FS_TOKEN_BANG_EQUAL : FS_TOKEN_BANG, start, current, line); break;
+            case '=': current += (next == '='); AddToken(next == '=' ? FS_TOKEN_EQUAL_EQUAL : FS_TOKEN_EQUAL, start, current, line); break;
+            case '<': current += (next == '='); AddToken(next == '=' ? FS_TOKEN_LESS_EQUAL : FS_TOKEN_LESS, start, current, line); break;
+            case '>': current += (next == '='); AddToken(next == '=' ? FS_TOKEN_GREATER_EQUAL : FS_TOKEN_GREATER, start, current, line); break;
+
+            case '/':
+                if(next == '/'){
+                    const char* endOfLine = (const char*)memchr(source + current, '\n', sourceSize - current);
+                    current = endOfLine ? (size_t)(endOfLine - source) : sourceSize; // A comment goes until the end of the line
+                } else {
+                    AddToken(FS_TOKEN_SLASH, start, current, line);
+                }
+                break;
+
+            case ' ':
+            case '\r':
+            case '\t':
+                break;
+
+            case '\n':
+                line++;
+                break;
+
+            case '"':
+                while(current < sourceSize && source[current] != '"'){
+                    if(source[current] == '\n'){
+                        line++;
+                    }
+                    if(source[current] == '\\' && current + 1 < sourceSize && source[current + 1] == '"'){
+                        current++; // Escaped quote
+                    }
+                    current++;
+                }
+
+                if(current >= sourceSize){
+                    m_errors.push_back({ line, "Unterminated string." });
+                    break;
+                }
+
+                current++; // The closing "
+                AddToken(FS_TOKEN_STRING, start, current, line); // Quotes included. The parser trims and unescapes the few it reads.
+                break;
+
+            default:
+                if(isDigit(c)){
+                    while(current < sourceSize && isDigit(source[current])){
+                        current++;
+                    }
+                    if(current + 1 < sourceSize && source[current] == '.' && isDigit(source[current + 1])){
+                        current++;
+                        while(current < sourceSize && isDigit(source[current])){
+                            current++;
+                        }
+                    }
+                    AddToken(FS_TOKEN_NUMBER, start, current, line);
+                } else if(isAlpha(c)){
+                    while(current < sourceSize && (isAlpha(source[current]) || isDigit(source[current]))){
+                        current++;
+                    }
+                    AddToken(IdentifierType(source + start, current - start), start, current, line);
+                } else {
+                    // One error per character, not per byte: skip the rest of a UTF-8 sequence
+                    unsigned char leadByte = (unsigned char)c;
+                    size_t sequenceLength = (leadByte >= 0xF0) ? 4 : (leadByte >= 0xE0) ? 3 : (leadByte >= 0xC0) ? 2 : 1;
+                    current = std::min(start + sequenceLength, sourceSize);
+                    m_errors.push_back({ line, "'" + std::string(source + start, current - start) + "' is an unexpected character." });
+                }
+                break;
+        }
+    }
+
+    AddToken(FS_TOKEN_EOF, sourceSize, sourceSize, line);
+}
+
+void FlowScriptScanner::AddToken(FlowScriptTokenType type, size_t start, size_t end, uint32_t line){
+    m_types.push_back(type);
+    m_offsets.push_back((uint32_t)start);
+    m_lengths.push_back((uint32_t)(end - start));
+    m_lines.push_back(line);
+}
+
+FlowScriptTokenType FlowScriptScanner::IdentifierType(const char* text, size_t length){
+    struct Keyword
+    {
+        const char*         m_text;
+        FlowScriptTokenType m_type;
+    };
+
+    static const Keyword s_keywords[] = {
+        { "graph", FS_TOKEN_GRAPH }, { "digraph", FS_TOKEN_DIGRAPH }, { "node", FS_TOKEN_NODE }, { "edge", FS_TOKEN_EDGE },
+        { "subgraph", FS_TOKEN_SUBGRAPH }, { "rankdir", FS_TOKEN_RANKDIR }, { "label", FS_TOKEN_LABEL }, { "shape", FS_TOKEN_SHAPE },
+        { "color", FS_TOKEN_COLOR }, { "style", FS_TOKEN_STYLE }, { "fontsize", FS_TOKEN_FONTSIZE }, { "FlowScript", FS_TOKEN_FLOWSCRIPT },
+        { "jobType", FS_TOKEN_JOB_TYPE }, { "circle", FS_TOKEN_CIRCLE }, { "input", FS_TOKEN_INPUT }, { "nil", FS_TOKEN_NIL },
+        { "test", FS_TOKEN_TEST }, { "if_true", FS_TOKEN_IF_TRUE }, { "else", FS_TOKEN_ELSE }, { "diamond", FS_TOKEN_DIAMOND },
+        { "priority", FS_TOKEN_PRIORITY }, { "foreach", FS_TOKEN_FOREACH }
+    };
+
+    // Identifiers are mostly job and variable names: the length alone rules out most keywords
+    if(length < 3 || length > 10){
+        return FS_TOKEN_IDENTIFIER;
+    }
+    for(const Keyword& keyword: s_keywords){
+        if(strlen(keyword.m_text) == length && memcmp(keyword.m_text, text, length) == 0){
+            return keyword.m_type;
+        }
+    }
+    return FS_TOKEN_IDENTIFIER;
+}
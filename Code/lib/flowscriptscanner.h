@@ -0,0 +1,70 @@
+// Tokenizes a FlowScript file in one pass, into flat arrays the Python parser reads in place
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// NOTE: Same values as TokenType in Code/fs_interpreter/tokentype.py (auto() starts at 1). Keep them in sync.
+enum FlowScriptTokenType : uint8_t
+{
+    FS_TOKEN_LEFT_BRACK = 1, FS_TOKEN_RIGHT_BRACK, FS_TOKEN_LEFT_PAREN, FS_TOKEN_RIGHT_PAREN, FS_TOKEN_LEFT_BRACE, FS_TOKEN_RIGHT_BRACE,
+    FS_TOKEN_COMMA, FS_TOKEN_DOT, FS_TOKEN_MINUS, FS_TOKEN_PLUS, FS_TOKEN_SEMICOLON, FS_TOKEN_SLASH, FS_TOKEN_STAR,
+
+    FS_TOKEN_BANG, FS_TOKEN_BANG_EQUAL, FS_TOKEN_EQUAL, FS_TOKEN_EQUAL_EQUAL, FS_TOKEN_GREATER, FS_TOKEN_GREATER_EQUAL,
+    FS_TOKEN_LESS, FS_TOKEN_LESS_EQUAL, FS_TOKEN_ARROW,
+
+    FS_TOKEN_IDENTIFIER, FS_TOKEN_STRING, FS_TOKEN_NUMBER,
+
+    FS_TOKEN_GRAPH, FS_TOKEN_DIGRAPH, FS_TOKEN_NODE, FS_TOKEN_EDGE, FS_TOKEN_SUBGRAPH, FS_TOKEN_RANKDIR, FS_TOKEN_LABEL,
+    FS_TOKEN_SHAPE, FS_TOKEN_COLOR, FS_TOKEN_STYLE, FS_TOKEN_FONTSIZE, FS_TOKEN_FLOWSCRIPT, FS_TOKEN_JOB_TYPE, FS_TOKEN_CIRCLE,
+    FS_TOKEN_INPUT, FS_TOKEN_NIL, FS_TOKEN_TEST, FS_TOKEN_IF_TRUE, FS_TOKEN_ELSE, FS_TOKEN_DIAMOND, FS_TOKEN_PRIORITY, FS_TOKEN_FOREACH,
+
+    FS_TOKEN_EOF
+};
+
+// NOTE:    The Python scanner built a Token object, and a copy of its lexeme, for every token. Here the
+//          file is memory-mapped, and a token is an entry in four arrays (struct of arrays): its type,
+//          the byte offset and length of its lexeme in the mapping, and its line. Nothing else is
+//          allocated per token. The parser checks types straight from the array, and only builds a
+//          Token (lexeme, literal) for the few it keeps. Errors are collected, in the order the
+//          Python scanner would have reported them, and the scan goes on like it did.
+class FlowScriptScanner
+{
+public:
+    FlowScriptScanner() {}
+    ~FlowScriptScanner();
+
+    bool ScanFile(const std::string& scriptPath); // False if the file cannot be mapped. Lexical errors are in GetErrors().
+    void Scan(const char* source, size_t sourceSize); // The source must outlive the scanner
+
+    const char* GetSource() const { return m_source; }
+    size_t GetSourceSize() const { return m_sourceSize; }
+
+    size_t GetNumTokens() const { return m_types.size(); } // The last one is EOF
+    const uint8_t* GetTypes() const { return m_types.data(); }
+    const uint32_t* GetOffsets() const { return m_offsets.data(); }
+    const uint32_t* GetLengths() const { return m_lengths.data(); }
+    const uint32_t* GetLines() const { return m_lines.data(); }
+
+    struct ScanError
+    {
+        uint32_t    m_line;
+        std::string m_message;
+    };
+    const std::vector<ScanError>& GetErrors() const { return m_errors; }
+
+private:
+    void AddToken(FlowScriptTokenType type, size_t start, size_t end, uint32_t line);
+    static FlowScriptTokenType IdentifierType(const char* text, size_t length); // A keyword, or FS_TOKEN_IDENTIFIER
+
+    const char*             m_source = nullptr;
+    size_t                  m_sourceSize = 0;
+    void*                   m_mapping = nullptr; // When scanning a file
+    size_t                  m_mappingSize = 0;
+
+    std::vector<uint8_t>    m_types;
+    std::vector<uint32_t>   m_offsets;
+    std::vector<uint32_t>   m_lengths;
+    std::vector<uint32_t>   m_lines;
+    std::vector<ScanError>  m_errors;
+};
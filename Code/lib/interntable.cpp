@@ -0,0 +1,115 @@
+#include <filesystem>
+#include <functional>
+
+#include "interntable.h"
+#include "fileioservice.h"
+
+namespace fs = std::filesystem;
+
+std::shared_ptr<const std::string> InternTable::InternString(std::string content){
+    size_t contentHash = std::hash<std::string>()(content);
+
+    std::lock_guard<std::mutex> lock(m_internTableMutex);
+    auto range = m_strings.equal_range(contentHash);
+    for(auto stringIter = range.first; stringIter != range.second; ++stringIter){
+        std::shared_ptr<const std::string> interned = stringIter->second.lock();
+        if(interned && *interned == content){
+            return interned;
+        }
+    }
+
+    SweepExpiredEntries();
+    std::shared_ptr<const std::string> interned = std::make_shared<const std::string>(std::move(content));
+    m_strings.insert({ contentHash, interned });
+    return interned;
+}
+
+std::shared_ptr<const json> InternTable::InternInput(std::string_view inputText){
+    size_t textHash = std::hash<std::string_view>()(inputText);
+
+    m_internTableMutex.lock();
+    auto range = m_inputs.equal_range(textHash);
+    for(auto inputIter = range.first; inputIter != range.second; ++inputIter){
+        if(inputIter->second.m_text == inputText){
+            std::shared_ptr<const json> parsed = inputIter->second.m_parsed.lock();
+            if(parsed){
+                m_internTableMutex.unlock();
+                return parsed;
+            }
+        }
+    }
+    m_internTableMutex.unlock();
+
+    // NOTE:    Parsed without the lock, it is the slow part. Two threads parsing the same text at once
+    //          both keep their own, the table remembers the last one. Jobs are created one by one anyway.
+    std::shared_ptr<const json> parsed = std::make_shared<const json>(json::parse(inputText));
+
+    std::lock_guard<std::mutex> lock(m_internTableMutex);
+    SweepExpiredEntries();
+    InternedInput internedInput;
+    internedInput.m_text = std::string(inputText);
+    internedInput.m_parsed = parsed;
+    m_inputs.insert({ textHash, std::move(internedInput) });
+    return parsed;
+}
+
+std::shared_ptr<const std::string> InternTable::InternFile(const std::string& filePath, FileIOService* fileIOService, int& result){
+    // A stat instead of a read, for every job but the first
+    std::error_code errorCode;
+    uintmax_t size = fs::file_size(filePath, errorCode);
+    int64_t modificationTime = errorCode ? 0 : (int64_t)fs::last_write_time(filePath, errorCode).time_since_epoch().count();
+    bool isCacheable = !errorCode;
+
+    if(isCacheable){
+        std::lock_guard<std::mutex> lock(m_internTableMutex);
+        auto fileIter = m_files.find(filePath);
+        if(fileIter != m_files.end() && fileIter->second.m_modificationTime == modificationTime && fileIter->second.m_size == size){
+            std::shared_ptr<const std::string> content = fileIter->second.m_content.lock();
+            if(content){
+                result = 0;
+                return content;
+            }
+        }
+    }
+
+    std::string fileContent;
+    result = fileIOService->ReadFile(filePath, fileContent);
+    if(result != 0){
+        return nullptr;
+    }
+
+    // Two paths with the same content share it too
+    std::shared_ptr<const std::string> content = InternString(std::move(fileContent));
+    if(isCacheable){
+        std::lock_guard<std::mutex> lock(m_internTableMutex);
+        InternedFile& internedFile = m_files[filePath];
+        internedFile.m_modificationTime = modificationTime;
+        internedFile.m_size = size;
+        internedFile.m_content = content;
+    }
+    return content;
+}
+
+size_t InternTable::GetNumEntries() const{
+    std::lock_guard<std::mutex> lock(m_internTableMutex);
+    return m_strings.size() + m_inputs.size() + m_files.size();
+}
+
+void InternTable::SweepExpiredEntries(){
+    size_t numEntries = m_strings.size() + m_inputs.size() + m_files.size();
+    if(numEntries < 2 * m_numEntriesAfterSweep + 64){
+        return;
+    }
+
+    for(auto stringIter = m_strings.begin(); stringIter != m_strings.end();){
+        stringIter = stringIter->second.expired() ? m_strings.erase(stringIter) : std::next(stringIter);
+    }
+    for(auto inputIter = m_inputs.begin(); inputIter != m_inputs.end();){
+        inputIter = inputIter->second.m_parsed.expired() ? m_inputs.erase(inputIter) : std::next(inputIter);
+    }
+    for(auto fileIter = m_files.begin(); fileIter != m_files.end();){
+        fileIter = fileIter->second.m_content.expired() ? m_files.erase(fileIter) : std::next(fileIter);
+    }
+
+    m_numEntriesAfterSweep = m_strings.size() + m_inputs.size() + m_files.size();
+}
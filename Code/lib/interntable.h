@@ -0,0 +1,56 @@
+// Immutable buffers shared by every job that needs the same bytes: their inputs, and the files they read
+#pragma once
+#include <mutex>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+class FileIOService;
+
+// NOTE:    A FlowScript variable used by 10k jobs used to be 10k copies of the same input, and a
+//          makefile they all point to was read from disk 10k times, once per compile job. Here, a
+//          buffer is looked up by its content (or, for a file, by its path, modification time and
+//          size) and handed out shared. The table only holds weak references: a buffer goes away
+//          with the last job holding it, and its entry is swept on a later insertion.
+class InternTable
+{
+public:
+    InternTable() {}
+
+    std::shared_ptr<const std::string> InternString(std::string content);
+
+    // Parsed once per distinct text. Throws json::parse_error, like json::parse().
+    std::shared_ptr<const json> InternInput(std::string_view inputText);
+
+    // Read again only if the file changed since. nullptr if it cannot be read (see "result": -errno).
+    std::shared_ptr<const std::string> InternFile(const std::string& filePath, FileIOService* fileIOService, int& result);
+
+    size_t GetNumEntries() const;
+
+private:
+    struct InternedInput
+    {
+        std::string                 m_text;
+        std::weak_ptr<const json>   m_parsed;
+    };
+
+    struct InternedFile
+    {
+        int64_t                             m_modificationTime = 0;
+        uintmax_t                           m_size = 0;
+        std::weak_ptr<const std::string>    m_content;
+    };
+
+    void SweepExpiredEntries(); // Expects the lock. Amortized: only once the tables doubled since the last sweep.
+
+    std::unordered_multimap<size_t, std::weak_ptr<const std::string> >  m_strings; // Hash of the content -> content
+    std::unordered_multimap<size_t, InternedInput>                     m_inputs; // Hash of the text -> text, parsed
+    std::unordered_map<std::string, InternedFile>                      m_files; // Path -> content, as of when it was read
+    size_t                                                             m_numEntriesAfterSweep = 0;
+    mutable std::mutex                                                 m_internTableMutex;
+};
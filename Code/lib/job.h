@@ -5,33 +5,57 @@
 #include <vector>
 #include <thread>
 #include <iostream>
+#include <atomic>
+#include <string>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <signal.h>
 #include "json.hpp"
+#include "jobresult.h"
 
 using json = nlohmann::json;
 
+constexpr int JOB_INTERRUPT_GRACE_MS = 2000; // How long an interrupted job's child process has to stop, see SetChildProcess
+
 class Job
 {
     friend class JobSystem;
     friend class JobWorkerThread;
+    friend class JobReactor;
 
 public:
-    Job(const char* jsonData = nullptr){
-
-        json jsonObject = json::parse(jsonData);
+    Job(const char* jsonData = nullptr): Job(json::parse(jsonData)) {}
 
+    // NOTE:    Takes the input already parsed, so inputs that arrive as json (or CBOR / MessagePack)
+    //          are not turned into text and parsed again, once by us and once more by the derived job.
+    Job(const json& jsonObject){
         m_jobChannels = jsonObject.value("jobChannels", 0xFFFFFFFF);
         m_jobType = jsonObject.value("jobType", -1);
-        
-        static int s_nextJobID = 0;
-        m_jobID = s_nextJobID++;
+        m_priority = jsonObject.value("priority", 0);
+        m_estimatedCost = jsonObject.value("estimatedCost", 1);
+        m_timeoutMs = jsonObject.value("timeoutMs", 0);
+        m_maxRetries = jsonObject.value("maxRetries", 0);
+        m_retryBackoffMs = jsonObject.value("retryBackoffMs", 100);
+
+        // Jobs of a lazy graph got their ID when the graph was queued (see JobSystem::CreateJob)
+        int& assignedJobID = AssignedJobID();
+        m_jobID = (assignedJobID >= 0) ? assignedJobID : NextJobID()++;
+        assignedJobID = -1;
     }
 
     virtual ~Job() {}
     virtual void Execute() = 0;
     virtual void JobCompleteCallback() = 0;
     int GetUniqueID() const { return m_jobID; } // const functions... cannot modify stuff in the class.
-    virtual void setOutputJson(const json& outputJson) = 0;
-    virtual json GetOutputJson() const = 0;
+    // NOTE:    Outputs are immutable once set, and shared. The job moves its output in, and the job
+    //          system, the history and every dependent that reads it hold the SAME json, never a copy.
+    virtual void setOutputJson(json outputJson) = 0;
+    virtual std::shared_ptr<const json> GetOutputJson() const = 0;
+
+    // Jobs that queue other jobs, or touch state of the job system while they execute, must run in its process
+    virtual bool CanRunInWorkerProcess() const { return true; }
 
     void AddDependency(int jobId){
         m_dependencies.push_back(jobId);
@@ -41,9 +65,189 @@ public:
         return m_dependencies;
     }
 
+    // Higher priority jobs are claimed first among the jobs that are ready to run
+    void SetPriority(int priority){
+        m_priority = priority;
+    }
+
+    int GetPriority() const { return m_priority; }
+
+    // NOTE:    How the job went, apart from what it produced. Set it next to the output. A job that does not
+    //          gets one from the "status" of its output when it completes (see JobSystem::OnJobCompleted).
+    void SetResult(JobResult result){
+        m_result = result;
+    }
+
+    JobResult GetResult() const { return m_result; }
+
+    // NOTE:    Conditional branches. A gated job is created and queued like any other, and depends on the
+    //          conditional job it is gated on. Once that one completed, the job runs if the condition came
+    //          out as "runIfConditionMet", and is skipped otherwise (as is everything depending on it).
+    void SetGate(int conditionalJobID, bool runIfConditionMet){
+        m_gateJobID = conditionalJobID;
+        m_runIfConditionMet = runIfConditionMet;
+        if(std::find(m_dependencies.begin(), m_dependencies.end(), conditionalJobID) == m_dependencies.end()){
+            m_dependencies.push_back(conditionalJobID);
+        }
+    }
+
+    int GetGateJobID() const { return m_gateJobID; } // -1 if the job is not gated
+
+    // NOTE:    A job still running "timeoutMs" after it was claimed is timed out by the job system's watchdog:
+    //          the child process it registered (see SetChildProcess) is killed, so the job completes, as a
+    //          failure. 0: no timeout. Also read from the input ("timeoutMs", "maxRetries", "retryBackoffMs").
+    void SetTimeout(int timeoutMs){
+        m_timeoutMs = timeoutMs;
+    }
+
+    // A job that fails (or times out) is run again, up to "maxRetries" times. The first retry waits
+    // "backoffMs", and every next one twice as long as the one before.
+    void SetRetries(int maxRetries, int backoffMs){
+        m_maxRetries = maxRetries;
+        m_retryBackoffMs = backoffMs;
+    }
+
+    int GetTimeout() const { return m_timeoutMs; }
+    int GetMaxRetries() const { return m_maxRetries; }
+    int GetNumFailedAttempts() const { return m_numFailedAttempts; } // Before this one
+
+    // NOTE:    Jobs that run something in another process register it here while it runs, so the watchdog
+    //          (or a cancellation) can stop it. With "isProcessGroup", the whole group gets the signal: make and
+    //          every compiler it started. If the job was interrupted before it got here, it is signaled right away.
+    //          A process still there JOB_INTERRUPT_GRACE_MS later gets "escalationSignal" (0: never) from the
+    //          watchdog. make needs that grace: on SIGTERM it reaps its compilers and gives their jobserver
+    //          tokens back, on SIGKILL the tokens are gone with it.
+    void SetChildProcess(pid_t processID, bool isProcessGroup, int signalNumber = SIGKILL, int escalationSignal = 0){
+        m_childProcessMutex.lock();
+        m_childProcessKillTarget = isProcessGroup ? -processID : processID;
+        m_childProcessSignal = signalNumber;
+        m_childProcessEscalationSignal = escalationSignal;
+        if(IsInterrupted()){
+            kill(m_childProcessKillTarget, m_childProcessSignal);
+        }
+        m_childProcessMutex.unlock();
+    }
+
+    void ClearChildProcess(){ // Before the process is reaped, so we never kill whoever gets its ID next
+        m_childProcessMutex.lock();
+        m_childProcessKillTarget = 0;
+        m_childProcessMutex.unlock();
+    }
+
+    bool HasTimedOut() const { return m_hasTimedOut; }
+    bool IsCancelled() const { return m_isCancelled; }
+    bool IsInterrupted() const { return m_hasTimedOut || m_isCancelled; } // Whatever it produces now, it failed
+
+    // Transient jobs are spawned by another job while it executes (and spawned again if it re-runs), so they are never journaled
+    void SetTransient(bool isTransient){
+        m_isTransient = isTransient;
+    }
+
+    // NOTE:    Async jobs. Instead of blocking its worker thread on a pipe (or on another job), Execute()
+    //          can call one of these and return: the job is suspended, and its worker moves on to other
+    //          jobs. The job system's reactor calls the continuation once the file descriptor is readable
+    //          (or hung up) / the other job is no longer queued or running. The continuation can suspend
+    //          the job again. The job completes once Execute() or a continuation returns without suspending.
+    //          Continuations run on the reactor thread, keep them short: read what is there, then wait again.
+    void AwaitReadable(int fileDescriptor, std::function<void()> continuation){
+        m_awaitedFD = fileDescriptor;
+        m_awaitedJobID = -1;
+        m_continuation = std::move(continuation);
+    }
+
+    void AwaitJob(int jobID, std::function<void()> continuation){
+        m_awaitedFD = -1;
+        m_awaitedJobID = jobID;
+        m_continuation = std::move(continuation);
+    }
+
+    bool IsSuspended() const { return (bool)m_continuation; }
+
+    // Makes sure new jobs never reuse an ID below "firstFreeJobID". Used when jobs are recovered from a journal.
+    static void ReserveJobIDs(int firstFreeJobID){
+        int nextJobID = NextJobID().load();
+        while(nextJobID < firstFreeJobID && !NextJobID().compare_exchange_weak(nextJobID, firstFreeJobID)) {}
+    }
+
+    // Consecutive IDs for jobs created later, all at once. Returns the first one.
+    static int ReserveJobIDRange(int numJobIDs){
+        return NextJobID().fetch_add(numJobIDs);
+    }
+
 private:
+    // Called by the job system, for a job that is running (or about to)
+    void Interrupt(bool isTimeout){
+        m_childProcessMutex.lock();
+        if(isTimeout){
+            m_hasTimedOut = true;
+        } else {
+            m_isCancelled = true;
+        }
+        m_interruptTime = std::chrono::steady_clock::now();
+        if(m_childProcessKillTarget != 0){
+            kill(m_childProcessKillTarget, m_childProcessSignal);
+        }
+        m_childProcessMutex.unlock();
+    }
+
+    // Called by the watchdog, for an interrupted job. True if its child process had to be killed for good.
+    bool EscalateInterrupt(std::chrono::steady_clock::time_point now){
+        m_childProcessMutex.lock();
+        bool isEscalating = IsInterrupted() && m_childProcessKillTarget != 0 && m_childProcessEscalationSignal != 0
+                            && now >= m_interruptTime + std::chrono::milliseconds(JOB_INTERRUPT_GRACE_MS);
+        if(isEscalating){
+            kill(m_childProcessKillTarget, m_childProcessEscalationSignal);
+            m_childProcessEscalationSignal = 0; // Once
+        }
+        m_childProcessMutex.unlock();
+        return isEscalating;
+    }
+
+    // NOTE: Was a plain static int. Jobs get created from worker threads too now (see incremental compile jobs)
+    static std::atomic<int>& NextJobID(){
+        static std::atomic<int> s_nextJobID(0);
+        return s_nextJobID;
+    }
+
+    // The ID the next job constructed by this thread takes, instead of a new one. -1: none.
+    static int& AssignedJobID(){
+        static thread_local int s_assignedJobID = -1;
+        return s_assignedJobID;
+    }
+
+
     int m_jobID = -1;
     int m_jobType = -1;
     unsigned long m_jobChannels = 0xFFFFFFFF;
     std::vector<int> m_dependencies; // The jobs who needs to complete BEFORE this one runs.
+
+    int m_priority = 0;
+    int m_estimatedCost = 1;            // Relative cost of the job, used when computing critical paths
+    long long m_criticalPathLength = 0; // Cost of the longest chain of jobs starting at this one (itself included)
+
+    std::string m_jobTypeIdentifier;    // What it was created as, and from what. Set by JobSystem::CreateJob, so the job can be re-created after a crash.
+    std::shared_ptr<const json> m_input; // Shared with every job created from the same input text (see InternTable)
+    bool m_isTransient = false;
+
+    JobResult m_result = JOB_RESULT_NONE;
+
+    int m_gateJobID = -1;
+    bool m_runIfConditionMet = true;
+
+    int m_timeoutMs = 0;
+    int m_maxRetries = 0;
+    int m_retryBackoffMs = 100;
+    int m_numFailedAttempts = 0;
+    std::chrono::steady_clock::time_point m_deadline; // When it times out. Set when it is claimed, if it has a timeout.
+    std::atomic<bool> m_hasTimedOut{false};
+    std::atomic<bool> m_isCancelled{false};
+    std::mutex m_childProcessMutex;
+    pid_t m_childProcessKillTarget = 0; // What kill() takes: negative for a process group, 0 for nothing
+    int m_childProcessSignal = SIGKILL;
+    int m_childProcessEscalationSignal = 0;
+    std::chrono::steady_clock::time_point m_interruptTime; // When it timed out, or was cancelled
+
+    std::function<void()> m_continuation; // Set while the job is suspended
+    int m_awaitedFD = -1;
+    int m_awaitedJobID = -1;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "jobdata.h"
+
+bool decodeJobData(const unsigned char* data, size_t dataSize, int dataFormat, json& decoded){
+    switch(dataFormat){
+        case JOB_DATA_FORMAT_JSON:      decoded = json::parse(data, data + dataSize, nullptr, false); break;
+        case JOB_DATA_FORMAT_CBOR:      decoded = json::from_cbor(data, data + dataSize, true, false); break;
+        case JOB_DATA_FORMAT_MSGPACK:   decoded = json::from_msgpack(data, data + dataSize, true, false); break;
+        default: return false;
+    }
+    return !decoded.is_discarded();
+}
+
+bool encodeJobData(const json& value, int dataFormat, std::vector<unsigned char>& encoded){
+    switch(dataFormat){
+        case JOB_DATA_FORMAT_JSON: {
+            std::string text = value.dump();
+            encoded.assign(text.begin(), text.end());
+            return true;
+        }
+        case JOB_DATA_FORMAT_CBOR:      json::to_cbor(value, encoded); return true;
+        case JOB_DATA_FORMAT_MSGPACK:   json::to_msgpack(value, encoded); return true;
+        default: return false;
+    }
+}
@@ -0,0 +1,19 @@
+// Encodings job inputs and outputs travel in: through the C API, to worker processes, over the rings and the daemon socket
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// CBOR and MessagePack skip text parsing and escaping
+enum JobDataFormat
+{
+    JOB_DATA_FORMAT_JSON,
+    JOB_DATA_FORMAT_CBOR,
+    JOB_DATA_FORMAT_MSGPACK,
+    NUM_JOB_DATA_FORMATS
+};
+
+bool decodeJobData(const unsigned char* data, size_t dataSize, int dataFormat, json& decoded);
+bool encodeJobData(const json& value, int dataFormat, std::vector<unsigned char>& encoded);
@@ -0,0 +1,255 @@
+#include <iostream>
+#include <filesystem>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "jobhistorystore.h"
+
+namespace fs = std::filesystem;
+
+static const char s_storeMagic[8] = "JOBHIST";
+static const uint64_t s_initialCapacity = 1024;
+
+JobHistoryStore::JobHistoryStore(const std::string& folderPath){
+    std::error_code errorCode;
+    fs::create_directories(folderPath, errorCode);
+
+    std::string recordsPath = (fs::path(folderPath) / "records.bin").string();
+    std::string outputsPath = (fs::path(folderPath) / "outputs.bin").string();
+
+    m_recordsFileDescriptor = open(recordsPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    m_outputsFileDescriptor = open(outputsPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(m_recordsFileDescriptor < 0 || m_outputsFileDescriptor < 0){
+        std::cerr << "Error: Unable to open the job history store in: " << folderPath << std::endl;
+        return;
+    }
+
+    struct stat recordsStat;
+    struct stat outputsStat;
+    fstat(m_recordsFileDescriptor, &recordsStat);
+    fstat(m_outputsFileDescriptor, &outputsStat);
+    m_outputsSize = (uint64_t)outputsStat.st_size;
+
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+
+    if(recordsStat.st_size < (off_t)sizeof(JobHistoryStoreHeader)){
+        // Brand new store
+        if(!MapRecords(s_initialCapacity)){
+            return;
+        }
+        memcpy(m_header->m_magic, s_storeMagic, sizeof(s_storeMagic));
+        m_header->m_version = JOB_HISTORY_STORE_VERSION;
+        m_header->m_recordSize = sizeof(JobHistoryRecord);
+        m_header->m_numRecords = 0;
+        m_header->m_capacity = s_initialCapacity;
+        return;
+    }
+
+    // Existing store, written by a previous run. Make sure it is one we understand before trusting its capacity.
+    JobHistoryStoreHeader header;
+    if(pread(m_recordsFileDescriptor, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || memcmp(header.m_magic, s_storeMagic, sizeof(s_storeMagic)) != 0
+        || header.m_version != JOB_HISTORY_STORE_VERSION
+        || header.m_recordSize != sizeof(JobHistoryRecord)
+        || recordsStat.st_size < (off_t)(sizeof(JobHistoryStoreHeader) + header.m_capacity * sizeof(JobHistoryRecord))){
+        std::cerr << "Error: Unrecognized job history store: " << recordsPath << std::endl;
+        close(m_recordsFileDescriptor);
+        m_recordsFileDescriptor = -1;
+        return;
+    }
+
+    MapRecords(header.m_capacity);
+}
+
+JobHistoryStore::~JobHistoryStore(){
+    if(m_header != nullptr){
+        munmap(m_header, m_recordsMappingSize);
+        m_header = nullptr;
+    }
+    if(m_outputsMapping != nullptr){
+        munmap((void*)m_outputsMapping, m_outputsMappingSize);
+        m_outputsMapping = nullptr;
+    }
+    if(m_recordsFileDescriptor >= 0){
+        close(m_recordsFileDescriptor);
+    }
+    if(m_outputsFileDescriptor >= 0){
+        close(m_outputsFileDescriptor);
+    }
+}
+
+bool JobHistoryStore::MapRecords(uint64_t capacity){
+    size_t mappingSize = sizeof(JobHistoryStoreHeader) + capacity * sizeof(JobHistoryRecord);
+
+    // New records come out of ftruncate() zeroed, which reads as NEVER_SEEN
+    struct stat recordsStat;
+    fstat(m_recordsFileDescriptor, &recordsStat);
+    if((size_t)recordsStat.st_size < mappingSize && ftruncate(m_recordsFileDescriptor, (off_t)mappingSize) != 0){
+        std::cerr << "Error: Unable to grow the job history store" << std::endl;
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_recordsFileDescriptor, 0);
+    if(mapping == MAP_FAILED){
+        std::cerr << "Error: Unable to map the job history store" << std::endl;
+        return false;
+    }
+
+    if(m_header != nullptr){
+        munmap(m_header, m_recordsMappingSize);
+    }
+    m_header = (JobHistoryStoreHeader*)mapping;
+    m_recordsMappingSize = mappingSize;
+    return true;
+}
+
+bool JobHistoryStore::MapOutputs(uint64_t minimumSize) const{
+    if(m_outputsMapping != nullptr && m_outputsMappingSize >= minimumSize){
+        return true;
+    }
+
+    struct stat outputsStat;
+    fstat(m_outputsFileDescriptor, &outputsStat);
+    size_t mappingSize = (size_t)outputsStat.st_size;
+    if(mappingSize < minimumSize || mappingSize == 0){
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, m_outputsFileDescriptor, 0);
+    if(mapping == MAP_FAILED){
+        return false;
+    }
+
+    if(m_outputsMapping != nullptr){
+        munmap((void*)m_outputsMapping, m_outputsMappingSize);
+    }
+    m_outputsMapping = (const char*)mapping;
+    m_outputsMappingSize = mappingSize;
+    return true;
+}
+
+JobHistoryRecord* JobHistoryStore::GetRecord(int jobID){
+    if(jobID < 0 || m_header == nullptr){
+        return nullptr;
+    }
+
+    if((uint64_t)jobID >= m_header->m_capacity){
+        uint64_t newCapacity = std::max<uint64_t>(m_header->m_capacity * 2, (uint64_t)jobID + 1);
+        if(!MapRecords(newCapacity)){
+            return nullptr;
+        }
+        m_header->m_capacity = newCapacity;
+    }
+
+    JobHistoryRecord* records = (JobHistoryRecord*)(m_header + 1);
+    if((uint64_t)jobID >= m_header->m_numRecords){
+        m_header->m_numRecords = (uint64_t)jobID + 1;
+    }
+    return &records[jobID];
+}
+
+int JobHistoryStore::GetNumRecords() const{
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    return (m_header != nullptr) ? (int)m_header->m_numRecords : 0;
+}
+
+void JobHistoryStore::WriteRecord(int jobID, int jobType, int jobStatus, int numaNode, bool clearOutput){
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+
+    JobHistoryRecord* record = GetRecord(jobID);
+    if(record == nullptr){
+        return;
+    }
+
+    if(clearOutput){
+        record->m_outputOffset = 0;
+        record->m_outputSize = 0;
+    }
+    record->m_jobID = jobID;
+    record->m_jobType = jobType;
+    record->m_numaNode = numaNode;
+    record->m_jobStatus = jobStatus; // Last, so an inspector never sees the new status with the old fields
+}
+
+void JobHistoryStore::WriteOutput(int jobID, const json& output){
+    if(!IsValid()){
+        return;
+    }
+
+    std::string serializedOutput = output.dump();
+
+    // Reserve our spot at the end of the file, then write it without holding the lock
+    m_storeMutex.lock();
+    uint64_t outputOffset = m_outputsSize;
+    m_outputsSize += serializedOutput.size();
+    m_storeMutex.unlock();
+
+    size_t numBytesWritten = 0;
+    while(numBytesWritten < serializedOutput.size()){
+        ssize_t result = pwrite(m_outputsFileDescriptor, serializedOutput.data() + numBytesWritten, serializedOutput.size() - numBytesWritten, (off_t)(outputOffset + numBytesWritten));
+        if(result < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            std::cerr << "Error: Unable to write the output of job # " << jobID << " to the job history store" << std::endl;
+            return;
+        }
+        numBytesWritten += (size_t)result;
+    }
+
+    // Only point the record at the output once it is all there
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    JobHistoryRecord* record = GetRecord(jobID);
+    if(record != nullptr){
+        record->m_outputOffset = outputOffset;
+        record->m_outputSize = serializedOutput.size();
+    }
+}
+
+bool JobHistoryStore::ReadRecord(int jobID, JobHistoryRecord& record) const{
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    if(m_header == nullptr || jobID < 0 || (uint64_t)jobID >= m_header->m_numRecords){
+        return false;
+    }
+
+    record = ((const JobHistoryRecord*)(m_header + 1))[jobID];
+    return true;
+}
+
+bool JobHistoryStore::ReadOutputText(int jobID, std::string& outputText) const{
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    if(m_header == nullptr || jobID < 0 || (uint64_t)jobID >= m_header->m_numRecords){
+        return false;
+    }
+
+    const JobHistoryRecord& record = ((const JobHistoryRecord*)(m_header + 1))[jobID];
+    if(record.m_outputSize == 0 || !MapOutputs(record.m_outputOffset + record.m_outputSize)){
+        return false;
+    }
+
+    outputText.assign(m_outputsMapping + record.m_outputOffset, record.m_outputSize);
+    return true;
+}
+
+json JobHistoryStore::ReadOutput(int jobID) const{
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    if(m_header == nullptr || jobID < 0 || (uint64_t)jobID >= m_header->m_numRecords){
+        return json();
+    }
+
+    const JobHistoryRecord& record = ((const JobHistoryRecord*)(m_header + 1))[jobID];
+    if(record.m_outputSize == 0 || !MapOutputs(record.m_outputOffset + record.m_outputSize)){
+        return json();
+    }
+
+    const char* outputStart = m_outputsMapping + record.m_outputOffset;
+    json output = json::parse(outputStart, outputStart + record.m_outputSize, nullptr, false);
+    if(output.is_discarded()){
+        return json(); // Corrupted
+    }
+    return output;
+}
@@ -0,0 +1,76 @@
+// On-disk job history: status records and outputs that outlive the process, and can be read by another one
+#pragma once
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// NOTE:    Two files in the store's folder:
+//          "records.bin"   A header, then one fixed-size record per job ID, memory-mapped. Looking up
+//                          a job is an offset computation. When it is full, the file doubles in size
+//                          and gets mapped again, so appending stays O(1) amortized.
+//          "outputs.bin"   The outputs (JSON text), one after the other. Never rewritten. A record
+//                          points to its output with an offset and a size, and outputs are parsed
+//                          straight from the mapping, without an intermediate copy.
+//          Both layouts are plain little-endian structs, see Code/tools/history_inspector.py.
+
+constexpr uint32_t JOB_HISTORY_STORE_VERSION = 1;
+
+struct JobHistoryStoreHeader
+{
+    char        m_magic[8];         // "JOBHIST"
+    uint32_t    m_version;
+    uint32_t    m_recordSize;
+    uint64_t    m_numRecords;       // Highest job ID recorded, plus one
+    uint64_t    m_capacity;         // Number of records the file has room for
+};
+
+struct JobHistoryRecord
+{
+    int32_t     m_jobID;
+    int32_t     m_jobType;
+    int32_t     m_jobStatus;        // JobStatus, 0 (NEVER_SEEN) for IDs that were never queued
+    int32_t     m_numaNode;
+    uint64_t    m_outputOffset;     // In "outputs.bin"
+    uint64_t    m_outputSize;       // 0 while the job has no output
+};
+
+static_assert(sizeof(JobHistoryStoreHeader) == 32, "The inspector expects a 32 byte header");
+static_assert(sizeof(JobHistoryRecord) == 32, "The inspector expects 32 byte records");
+
+class JobHistoryStore
+{
+public:
+    explicit JobHistoryStore(const std::string& folderPath); // Opens the store, or creates it
+    ~JobHistoryStore();
+
+    bool IsValid() const { return m_header != nullptr && m_outputsFileDescriptor >= 0; }
+    int GetNumRecords() const;
+
+    // Leaves the output of the job as it is, unless told otherwise (a job re-queued under an ID that already ran)
+    void WriteRecord(int jobID, int jobType, int jobStatus, int numaNode, bool clearOutput = false);
+    void WriteOutput(int jobID, const json& output);
+
+    bool ReadRecord(int jobID, JobHistoryRecord& record) const;
+    json ReadOutput(int jobID) const; // null if the job has no output (yet)
+    bool ReadOutputText(int jobID, std::string& outputText) const; // The output as stored (JSON text), without parsing it
+
+private:
+    JobHistoryRecord* GetRecord(int jobID); // Grows the file if needed. Expects "m_storeMutex" to be held.
+    bool MapRecords(uint64_t capacity); // Expects "m_storeMutex" to be held
+    bool MapOutputs(uint64_t minimumSize) const; // Expects "m_storeMutex" to be held
+
+    int                         m_recordsFileDescriptor = -1;
+    int                         m_outputsFileDescriptor = -1;
+
+    JobHistoryStoreHeader*      m_header = nullptr; // Start of the records mapping. The records follow it.
+    size_t                      m_recordsMappingSize = 0;
+
+    mutable const char*         m_outputsMapping = nullptr;
+    mutable size_t              m_outputsMappingSize = 0;
+    uint64_t                    m_outputsSize = 0; // Bytes reserved in "outputs.bin" so far
+
+    mutable std::mutex          m_storeMutex;
+};
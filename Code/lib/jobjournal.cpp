@@ -0,0 +1,130 @@
+#include <iostream>
+#include <fstream>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "jobjournal.h"
+
+JobJournal::JobJournal(const std::string& journalPath): m_journalPath(journalPath){
+    m_fileDescriptor = open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(m_fileDescriptor < 0){
+        std::cerr << "Error: Unable to open the job journal: " << journalPath << std::endl;
+        return;
+    }
+
+    m_flusherThread = new std::thread(&JobJournal::FlusherMain, this);
+}
+
+JobJournal::~JobJournal(){
+    m_journalMutex.lock();
+    m_isStopping = true;
+    m_journalMutex.unlock();
+    m_recordsAppended.notify_all();
+
+    if(m_flusherThread){
+        m_flusherThread->join(); // Writes the last records on its way out
+        delete m_flusherThread;
+        m_flusherThread = nullptr;
+    }
+
+    if(m_fileDescriptor >= 0){
+        close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+    }
+}
+
+void JobJournal::Append(const json& record){
+    if(!IsValid()){
+        return;
+    }
+
+    std::string line = record.dump() + "\n"; // Serialize outside of the lock
+
+    m_journalMutex.lock();
+    m_pendingRecords += line;
+    m_numRecordsAppended++;
+    m_journalMutex.unlock();
+
+    m_recordsAppended.notify_one();
+}
+
+void JobJournal::Sync(){
+    if(!IsValid()){
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_journalMutex);
+    uint64_t numRecordsToWaitFor = m_numRecordsAppended;
+    m_recordsAppended.notify_one();
+    m_recordsDurable.wait(lock, [&](){ return m_numRecordsDurable >= numRecordsToWaitFor || m_isStopping; });
+}
+
+void JobJournal::FlusherMain(){
+    const std::chrono::milliseconds commitDelay(2);
+
+    while(true){
+        std::unique_lock<std::mutex> lock(m_journalMutex);
+        m_recordsAppended.wait(lock, [&](){ return !m_pendingRecords.empty() || m_isStopping; });
+        if(m_pendingRecords.empty() && m_isStopping){
+            break;
+        }
+
+        // Give the other workers a chance to join this commit
+        if(!m_isStopping){
+            lock.unlock();
+            std::this_thread::sleep_for(commitDelay);
+            lock.lock();
+        }
+
+        std::string recordsToWrite;
+        recordsToWrite.swap(m_pendingRecords);
+        uint64_t numRecordsWritten = m_numRecordsAppended;
+        lock.unlock();
+
+        size_t numBytesWritten = 0;
+        while(numBytesWritten < recordsToWrite.size()){
+            ssize_t result = write(m_fileDescriptor, recordsToWrite.data() + numBytesWritten, recordsToWrite.size() - numBytesWritten);
+            if(result < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                std::cerr << "Error: Unable to write to the job journal: " << m_journalPath << std::endl;
+                break;
+            }
+            numBytesWritten += (size_t)result;
+        }
+        fdatasync(m_fileDescriptor);
+
+        lock.lock();
+        m_numRecordsDurable = numRecordsWritten;
+        lock.unlock();
+        m_recordsDurable.notify_all();
+    }
+}
+
+std::vector<json> JobJournal::ReadRecords(const std::string& journalPath){
+    std::vector<json> records;
+
+    std::ifstream file(journalPath);
+    if(!file.is_open()){
+        return records;
+    }
+
+    std::string line;
+    while(std::getline(file, line)){
+        if(line.empty()){
+            continue;
+        }
+
+        try {
+            records.push_back(json::parse(line));
+        } catch (const json::exception&) {
+            // Only the last record can be torn, and nothing after it was ever acknowledged
+            std::cerr << "Warning: Ignoring a torn record at the end of the job journal: " << journalPath << std::endl;
+            break;
+        }
+    }
+
+    return records;
+}
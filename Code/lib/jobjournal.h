@@ -0,0 +1,47 @@
+// Append-only log of what happened to every job, so a crashed job system can pick up where it left off
+#pragma once
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// NOTE:    One JSON record per line: "queued" (with the job type, input and dependencies),
+//          "running", "completed" (with the output) and "retired". Appending never blocks
+//          on the disk. A flusher thread waits a couple of milliseconds for more records to
+//          show up, writes them all at once and fdatasync()s them together (group commit),
+//          so a burst of status transitions costs one sync instead of one each.
+class JobJournal
+{
+public:
+    explicit JobJournal(const std::string& journalPath);
+    ~JobJournal(); // Flushes whatever is still pending
+
+    bool IsValid() const { return m_fileDescriptor >= 0; }
+    const std::string& GetPath() const { return m_journalPath; }
+
+    void Append(const json& record);
+    void Sync(); // Blocks until every record appended so far is on disk
+
+    // Records of an existing journal, in order. A torn last line (crash in the middle of a write) is dropped.
+    static std::vector<json> ReadRecords(const std::string& journalPath);
+
+private:
+    void FlusherMain(); // Called in the flusher thread, runs until the journal is destroyed
+
+    std::string                 m_journalPath;
+    int                         m_fileDescriptor = -1;
+
+    std::string                 m_pendingRecords; // Appended, not written yet
+    uint64_t                    m_numRecordsAppended = 0;
+    uint64_t                    m_numRecordsDurable = 0;
+    bool                        m_isStopping = false;
+    std::mutex                  m_journalMutex;
+    std::condition_variable     m_recordsAppended;
+    std::condition_variable     m_recordsDurable;
+    std::thread*                m_flusherThread = nullptr;
+};
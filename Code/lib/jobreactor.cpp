@@ -0,0 +1,183 @@
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "jobreactor.h"
+#include "jobsystem.h"
+#include "job.h"
+
+JobReactor::JobReactor(JobSystem* jobSystem): m_jobSystem(jobSystem){
+    m_epollFD = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(!IsValid()){
+        std::cerr << "Error: Unable to create the job reactor (" << strerror(errno) << "). Async jobs will block their worker." << std::endl;
+        return;
+    }
+
+    epoll_event wakeEvent;
+    memset(&wakeEvent, 0, sizeof(wakeEvent));
+    wakeEvent.events = EPOLLIN;
+    wakeEvent.data.ptr = nullptr; // Every other registration points to its job
+    epoll_ctl(m_epollFD, EPOLL_CTL_ADD, m_wakeFD, &wakeEvent);
+
+    m_thread = new std::thread(&JobReactor::ReactorMain, this);
+}
+
+JobReactor::~JobReactor(){
+    m_isStopping = true;
+    if(m_thread){
+        Wake();
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if(m_epollFD >= 0){
+        close(m_epollFD);
+    }
+    if(m_wakeFD >= 0){
+        close(m_wakeFD);
+    }
+}
+
+void JobReactor::Suspend(Job* job){
+    m_jobsMutex.lock();
+    m_numSuspendedJobs++;
+    m_jobsMutex.unlock();
+
+    // NOTE: From here on, the job may be resumed (and even completed) by the reactor thread. Do not touch it.
+    if(job->m_awaitedFD >= 0){
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = job;
+        if(epoll_ctl(m_epollFD, EPOLL_CTL_ADD, job->m_awaitedFD, &event) != 0){
+            // Regular files (EPERM) are always ready to read. Anything else, let the continuation find out.
+            m_jobsMutex.lock();
+            m_jobsReady.push_back(job);
+            m_jobsMutex.unlock();
+            Wake();
+        }
+        return;
+    }
+
+    // NOTE:    Registered BEFORE the status is checked. If it completes in between, OnJobCompleted() finds
+    //          us. If it had already completed, we find it. Whoever takes the job out of the map resumes it.
+    int awaitedJobID = job->m_awaitedJobID;
+    m_jobsMutex.lock();
+    m_jobsAwaitingJob[awaitedJobID].push_back(job);
+    m_jobsMutex.unlock();
+
+    JobStatus awaitedJobStatus = m_jobSystem->GetJobStatus(awaitedJobID);
+    if(awaitedJobStatus != JOB_STATUS_QUEUED && awaitedJobStatus != JOB_STATUS_RUNNING){
+        OnJobCompleted(awaitedJobID);
+    }
+}
+
+void JobReactor::OnJobCompleted(int jobID){
+    m_jobsMutex.lock();
+    auto awaitingIter = m_jobsAwaitingJob.find(jobID);
+    if(awaitingIter == m_jobsAwaitingJob.end()){
+        m_jobsMutex.unlock();
+        return;
+    }
+
+    for(Job* job: awaitingIter->second){
+        m_jobsReady.push_back(job);
+    }
+    m_jobsAwaitingJob.erase(awaitingIter);
+    m_jobsMutex.unlock();
+
+    Wake();
+}
+
+int JobReactor::GetNumSuspendedJobs() const{
+    m_jobsMutex.lock();
+    int numSuspendedJobs = m_numSuspendedJobs;
+    m_jobsMutex.unlock();
+
+    return numSuspendedJobs;
+}
+
+void JobReactor::Wake(){
+    uint64_t one = 1;
+    while(write(m_wakeFD, &one, sizeof(one)) < 0 && errno == EINTR) {}
+}
+
+void JobReactor::ReactorMain(){
+    epoll_event events[64];
+    while(!m_isStopping){
+        int numEvents = epoll_wait(m_epollFD, events, 64, -1);
+        if(numEvents < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            std::cerr << "Error: The job reactor stopped waiting (" << strerror(errno) << ")" << std::endl;
+            break;
+        }
+
+        for(int i = 0; i < numEvents && !m_isStopping; i++){
+            Job* job = (Job*)events[i].data.ptr;
+            if(job == nullptr){
+                uint64_t numWakes;
+                while(read(m_wakeFD, &numWakes, sizeof(numWakes)) < 0 && errno == EINTR) {}
+                continue;
+            }
+
+            // One shot: the continuation decides whether (and on what) it waits again
+            epoll_ctl(m_epollFD, EPOLL_CTL_DEL, job->m_awaitedFD, nullptr);
+            Resume(job);
+        }
+
+        m_jobsMutex.lock();
+        std::deque<Job*> jobsReady;
+        jobsReady.swap(m_jobsReady);
+        m_jobsMutex.unlock();
+
+        for(Job* job: jobsReady){
+            if(m_isStopping){
+                break;
+            }
+            Resume(job);
+        }
+    }
+}
+
+void JobReactor::Resume(Job* job){
+    m_jobsMutex.lock();
+    m_numSuspendedJobs--;
+    m_jobsMutex.unlock();
+
+    std::function<void()> continuation = std::move(job->m_continuation);
+    job->m_continuation = nullptr;
+    job->m_awaitedFD = -1;
+    job->m_awaitedJobID = -1;
+    continuation();
+
+    if(job->IsSuspended()){
+        Suspend(job);
+    } else {
+        m_jobSystem->OnJobCompleted(job);
+    }
+}
+
+void JobReactor::ResumeInline(Job* job, JobSystem* jobSystem){
+    while(job->IsSuspended()){
+        if(job->m_awaitedFD >= 0){
+            pollfd pollFD = { job->m_awaitedFD, POLLIN, 0 };
+            while(poll(&pollFD, 1, -1) < 0 && errno == EINTR) {}
+        } else {
+            jobSystem->WaitForJob(job->m_awaitedJobID);
+        }
+
+        std::function<void()> continuation = std::move(job->m_continuation);
+        job->m_continuation = nullptr;
+        job->m_awaitedFD = -1;
+        job->m_awaitedJobID = -1;
+        continuation();
+    }
+}
@@ -0,0 +1,49 @@
+// Resumes suspended (async) jobs when what they wait for is ready, so they do not hold a worker thread while they wait
+#pragma once
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Job;
+class JobSystem;
+
+// NOTE:    One thread, blocked in epoll_wait(). Jobs waiting on a file descriptor are registered with
+//          EPOLLONESHOT, so each wake-up resumes its job exactly once. Jobs waiting on another job are
+//          kept by the ID they wait for, and woken through an eventfd when the job system tells us
+//          that job completed. A job that suspends again goes straight back in; the others complete.
+//          A few worker threads can then drive hundreds of compile processes: each only costs a pipe.
+class JobReactor
+{
+public:
+    explicit JobReactor(JobSystem* jobSystem);
+    ~JobReactor(); // Suspended jobs are abandoned, like the jobs still running when the job system is destroyed
+
+    bool IsValid() const { return m_epollFD >= 0 && m_wakeFD >= 0; }
+
+    void Suspend(Job* job); // The job just returned with a continuation. Takes it until it completes.
+    void OnJobCompleted(int jobID); // Wakes the jobs waiting on it
+    int GetNumSuspendedJobs() const;
+
+    // Without a reactor (in a "jobworker" process, for instance): waits for what the job waits for, in this
+    // thread, and resumes it, until it completes. Same result as a regular, blocking job.
+    static void ResumeInline(Job* job, JobSystem* jobSystem);
+
+private:
+    void ReactorMain(); // Called in the reactor thread, until the reactor is destroyed
+    void Resume(Job* job); // Runs its continuation, then suspends it again or completes it
+    void Wake();
+
+    JobSystem*                          m_jobSystem;
+    int                                 m_epollFD = -1;
+    int                                 m_wakeFD = -1; // eventfd, readable when "m_jobsReady" has something
+    std::thread*                        m_thread = nullptr;
+    std::atomic<bool>                   m_isStopping{false};
+
+    std::map< int, std::vector<Job*> >  m_jobsAwaitingJob; // Awaited job ID -> jobs waiting on it
+    std::deque< Job* >                  m_jobsReady; // What they waited for is done, resume them
+    int                                 m_numSuspendedJobs = 0;
+    mutable std::mutex                  m_jobsMutex;
+};
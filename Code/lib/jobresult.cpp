@@ -0,0 +1,77 @@
+#include "jobresult.h"
+
+JobResult jobResultFromOutput(const json& output){
+    if(!output.is_object()){
+        return JOB_RESULT_NONE;
+    }
+
+    auto statusIter = output.find("status");
+    if(statusIter == output.end() || !statusIter->is_string()){
+        return JOB_RESULT_NONE;
+    }
+
+    const std::string& status = statusIter->get_ref<const std::string&>();
+    if(status == "success"){
+        return JOB_RESULT_SUCCESS;
+    }
+    if(status == "failure" || status == "error"){
+        return JOB_RESULT_FAILURE;
+    }
+    return JOB_RESULT_NONE;
+}
+
+const char* jobResultName(JobResult result){
+    switch(result){
+        case JOB_RESULT_SUCCESS: return "SUCCESS";
+        case JOB_RESULT_FAILURE: return "FAILURE";
+        default:                 return "NONE";
+    }
+}
+
+JobResultTable::JobResultTable(){
+    for(std::atomic< std::atomic<uint8_t>* >& chunk: m_chunks){
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+JobResultTable::~JobResultTable(){
+    for(std::atomic< std::atomic<uint8_t>* >& chunk: m_chunks){
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+void JobResultTable::Set(int jobID, JobResult result){
+    if(jobID < 0 || (jobID >> CHUNK_BITS) >= MAX_CHUNKS){
+        return;
+    }
+
+    std::atomic< std::atomic<uint8_t>* >& chunkSlot = m_chunks[jobID >> CHUNK_BITS];
+    std::atomic<uint8_t>* chunk = chunkSlot.load(std::memory_order_acquire);
+    if(chunk == nullptr){
+        std::atomic<uint8_t>* newChunk = new std::atomic<uint8_t>[CHUNK_SIZE];
+        for(int i = 0; i < CHUNK_SIZE; i++){
+            newChunk[i].store(JOB_RESULT_NONE, std::memory_order_relaxed);
+        }
+
+        // Someone else may have beaten us to it: then theirs is the one
+        if(chunkSlot.compare_exchange_strong(chunk, newChunk, std::memory_order_acq_rel)){
+            chunk = newChunk;
+        } else {
+            delete[] newChunk;
+        }
+    }
+
+    chunk[jobID & (CHUNK_SIZE - 1)].store(result, std::memory_order_release);
+}
+
+JobResult JobResultTable::Get(int jobID) const{
+    if(jobID < 0 || (jobID >> CHUNK_BITS) >= MAX_CHUNKS){
+        return JOB_RESULT_NONE;
+    }
+
+    const std::atomic<uint8_t>* chunk = m_chunks[jobID >> CHUNK_BITS].load(std::memory_order_acquire);
+    if(chunk == nullptr){
+        return JOB_RESULT_NONE;
+    }
+    return (JobResult)chunk[jobID & (CHUNK_SIZE - 1)].load(std::memory_order_acquire);
+}
@@ -0,0 +1,40 @@
+// Typed outcome of a job, kept apart from its (JSON) output, and a table to read it without taking any lock
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+enum JobResult : uint8_t
+{
+    JOB_RESULT_NONE,    // Not completed (yet), skipped, or the job never said
+    JOB_RESULT_SUCCESS,
+    JOB_RESULT_FAILURE,
+    NUM_JOB_RESULTS
+};
+
+// For jobs that only set "status" in their output: "success", or "failure" / "error"
+JobResult jobResultFromOutput(const json& output);
+const char* jobResultName(JobResult result);
+
+// NOTE:    One byte per job ID, in chunks that are allocated on first use and never move, so reading
+//          is an index computation and two atomic loads. Writers race for a chunk with a CAS, nobody
+//          ever waits. The result of a job is stored before it is marked completed: whoever sees it
+//          completed (through the job system's status) sees its result too.
+class JobResultTable
+{
+public:
+    JobResultTable();
+    ~JobResultTable();
+
+    void Set(int jobID, JobResult result);
+    JobResult Get(int jobID) const; // JOB_RESULT_NONE for IDs never set (or out of range)
+
+private:
+    static constexpr int CHUNK_BITS = 12;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_BITS;
+    static constexpr int MAX_CHUNKS = 8192; // 32M job IDs
+
+    std::atomic< std::atomic<uint8_t>* > m_chunks[MAX_CHUNKS];
+};
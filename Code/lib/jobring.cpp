@@ -0,0 +1,347 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "jobring.h"
+#include "jobsystem.h"
+#include "job.h"
+
+static const char s_ringMagic[8] = "JOBRING";
+static const uint32_t s_wrapMarker = 0xFFFFFFFF; // "Nothing more until the end of the ring, start over at 0"
+
+struct JobRingRegionHeader
+{
+    char        m_magic[8];
+    uint32_t    m_version;
+    uint32_t    m_padding;
+    uint64_t    m_capacity; // Of each ring
+};
+
+// NOTE:    Region layout: the header, the indices of the submission ring, those of the completion
+//          ring, then the bytes of the submission ring, then those of the completion ring.
+static const size_t s_submissionIndicesOffset = 64;
+static const size_t s_completionIndicesOffset = s_submissionIndicesOffset + sizeof(JobRingIndices);
+static const size_t s_ringsOffset = s_completionIndicesOffset + sizeof(JobRingIndices);
+
+static_assert(sizeof(JobRingRegionHeader) <= s_submissionIndicesOffset, "The header must fit before the indices");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The indices are shared with another process, they must be lock free");
+
+static uint64_t alignRecord(uint64_t recordSize){
+    return (recordSize + 7) & ~(uint64_t)7;
+}
+
+static std::string normalizeRingName(const std::string& name){
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+bool SpscByteRing::TryWrite(const unsigned char* record, uint32_t recordSize){
+    if(recordSize > GetMaxRecordSize()){
+        return false; // Would never fit
+    }
+
+    uint64_t neededSize = alignRecord(sizeof(uint64_t) + recordSize);
+    uint64_t writePosition = m_indices->m_writePosition.load(std::memory_order_relaxed);
+    uint64_t readPosition = m_indices->m_readPosition.load(std::memory_order_acquire);
+
+    // Records never wrap around: when it does not fit before the end, skip to the start
+    uint64_t offset = writePosition & (m_capacity - 1);
+    uint64_t sizeUntilEnd = m_capacity - offset;
+    uint64_t skippedSize = (sizeUntilEnd < neededSize) ? sizeUntilEnd : 0;
+    if(writePosition + skippedSize + neededSize - readPosition > m_capacity){
+        return false;
+    }
+
+    if(skippedSize > 0){
+        memcpy(m_data + offset, &s_wrapMarker, sizeof(s_wrapMarker));
+        writePosition += skippedSize;
+        offset = 0;
+    }
+
+    memcpy(m_data + offset, &recordSize, sizeof(recordSize));
+    memcpy(m_data + offset + sizeof(uint64_t), record, recordSize);
+
+    // Publishes the record: the consumer sees it once it sees the new write position
+    m_indices->m_writePosition.store(writePosition + neededSize, std::memory_order_release);
+    return true;
+}
+
+bool SpscByteRing::Peek(const unsigned char*& record, uint32_t& recordSize){
+    uint64_t readPosition = m_indices->m_readPosition.load(std::memory_order_relaxed);
+    uint64_t writePosition = m_indices->m_writePosition.load(std::memory_order_acquire);
+
+    while(readPosition != writePosition){
+        uint64_t offset = readPosition & (m_capacity - 1);
+        uint32_t size;
+        memcpy(&size, m_data + offset, sizeof(size));
+
+        if(size == s_wrapMarker){
+            readPosition += m_capacity - offset;
+            m_indices->m_readPosition.store(readPosition, std::memory_order_release);
+            continue;
+        }
+
+        record = m_data + offset + sizeof(uint64_t);
+        recordSize = size;
+        m_peekedEnd = readPosition + alignRecord(sizeof(uint64_t) + size);
+        return true;
+    }
+
+    return false;
+}
+
+void SpscByteRing::Consume(){
+    // Gives the room back to the producer. The record must not be touched after this.
+    m_indices->m_readPosition.store(m_peekedEnd, std::memory_order_release);
+}
+
+JobRing::JobRing(const std::string& name, void* mapping, size_t mappingSize, bool isOwner):
+    m_name(name),
+    m_mapping(mapping),
+    m_mappingSize(mappingSize),
+    m_isOwner(isOwner),
+    m_submissions((JobRingIndices*)((char*)mapping + s_submissionIndicesOffset), (unsigned char*)mapping + s_ringsOffset, ((JobRingRegionHeader*)mapping)->m_capacity),
+    m_completions((JobRingIndices*)((char*)mapping + s_completionIndicesOffset), (unsigned char*)mapping + s_ringsOffset + ((JobRingRegionHeader*)mapping)->m_capacity, ((JobRingRegionHeader*)mapping)->m_capacity) {}
+
+JobRing::~JobRing(){
+    munmap(m_mapping, m_mappingSize);
+    if(m_isOwner){
+        shm_unlink(m_name.c_str());
+    }
+}
+
+JobRing* JobRing::Create(const std::string& name, uint64_t capacity){
+    std::string ringName = normalizeRingName(name);
+
+    uint64_t ringCapacity = 4096;
+    while(ringCapacity < capacity){
+        ringCapacity *= 2;
+    }
+
+    // A ring left behind by a job system that crashed is of no use to anyone
+    shm_unlink(ringName.c_str());
+    int fileDescriptor = shm_open(ringName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if(fileDescriptor < 0){
+        std::cerr << "Error: Unable to create the job ring: " << ringName << " (" << strerror(errno) << ")" << std::endl;
+        return nullptr;
+    }
+
+    size_t mappingSize = s_ringsOffset + 2 * ringCapacity;
+    void* mapping = MAP_FAILED;
+    if(ftruncate(fileDescriptor, (off_t)mappingSize) == 0){
+        mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    }
+    close(fileDescriptor); // The mapping keeps the memory alive
+    if(mapping == MAP_FAILED){
+        std::cerr << "Error: Unable to map the job ring: " << ringName << std::endl;
+        shm_unlink(ringName.c_str());
+        return nullptr;
+    }
+
+    JobRingRegionHeader* header = (JobRingRegionHeader*)mapping;
+    header->m_version = JOB_RING_VERSION;
+    header->m_capacity = ringCapacity;
+    new ((char*)mapping + s_submissionIndicesOffset) JobRingIndices{};
+    new ((char*)mapping + s_completionIndicesOffset) JobRingIndices{};
+
+    // Last: clients do not touch a region until it has its magic
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->m_magic, s_ringMagic, sizeof(s_ringMagic));
+
+    return new JobRing(ringName, mapping, mappingSize, true);
+}
+
+JobRing* JobRing::Open(const std::string& name){
+    std::string ringName = normalizeRingName(name);
+
+    int fileDescriptor = shm_open(ringName.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if(fileDescriptor < 0){
+        std::cerr << "Error: No job ring named: " << ringName << std::endl;
+        return nullptr;
+    }
+
+    struct stat ringStat;
+    fstat(fileDescriptor, &ringStat);
+    size_t mappingSize = (size_t)ringStat.st_size;
+    void* mapping = (mappingSize >= s_ringsOffset) ? mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0) : MAP_FAILED;
+    close(fileDescriptor);
+    if(mapping == MAP_FAILED){
+        std::cerr << "Error: Unable to map the job ring: " << ringName << std::endl;
+        return nullptr;
+    }
+
+    const JobRingRegionHeader* header = (const JobRingRegionHeader*)mapping;
+    if(memcmp(header->m_magic, s_ringMagic, sizeof(s_ringMagic)) != 0 || header->m_version != JOB_RING_VERSION
+        || s_ringsOffset + 2 * header->m_capacity != mappingSize){
+        std::cerr << "Error: Unrecognized job ring: " << ringName << std::endl;
+        munmap(mapping, mappingSize);
+        return nullptr;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return new JobRing(ringName, mapping, mappingSize, false);
+}
+
+JobRingServer::JobRingServer(JobSystem* jobSystem, JobRing* ring): m_jobSystem(jobSystem), m_ring(ring){
+    m_thread = new std::thread(&JobRingServer::ServerMain, this);
+}
+
+JobRingServer::~JobRingServer(){
+    m_isStopping = true;
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+
+    delete m_ring;
+    m_ring = nullptr;
+}
+
+// NOTE:    While there is work, the server goes around again right away. Once it has been idle for a
+//          while it yields, then sleeps, so an unused ring does not keep a core busy. A client that
+//          submits after a long pause pays for one sleep, the next ones are picked up in microseconds.
+void JobRingServer::ServerMain(){
+    const int maxSubmissionsPerBatch = 256;
+    const int numSpinningLoops = 1024;
+    int numIdleLoops = 0;
+
+    while(!m_isStopping){
+        int numRecordsHandled = DrainSubmissions(maxSubmissionsPerBatch);
+        if(!m_outstandingJobs.empty()){
+            numRecordsHandled += PublishCompletions();
+        }
+
+        if(numRecordsHandled > 0){
+            numIdleLoops = 0;
+        } else if(++numIdleLoops < numSpinningLoops){
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+int JobRingServer::DrainSubmissions(int maxSubmissions){
+    SpscByteRing& submissions = m_ring->GetSubmissions();
+    std::vector<unsigned char> noOutput;
+
+    int numSubmissions = 0;
+    const unsigned char* record = nullptr;
+    uint32_t recordSize = 0;
+    while(numSubmissions < maxSubmissions && submissions.Peek(record, recordSize)){
+        JobRingSubmission submission;
+        memset(&submission, 0, sizeof(submission));
+        memcpy(&submission, record, std::min<size_t>(recordSize, sizeof(submission)));
+
+        const unsigned char* typeStart = record + sizeof(JobRingSubmission);
+        const unsigned char* dependenciesStart = typeStart + alignRecord(submission.m_typeLength);
+        const unsigned char* inputStart = dependenciesStart + (uint64_t)submission.m_numDependencies * sizeof(uint64_t);
+        bool isValid = recordSize >= sizeof(JobRingSubmission) && (uint64_t)(inputStart - record) + submission.m_inputSize == recordSize;
+
+        // Turn it into a job, or reject it
+        json input;
+        Job* job = nullptr;
+        if(isValid && decodeJobData(inputStart, submission.m_inputSize, submission.m_inputFormat, input)){
+            job = m_jobSystem->CreateJob(std::string((const char*)typeStart, submission.m_typeLength), input);
+        }
+
+        for(uint32_t i = 0; job != nullptr && i < submission.m_numDependencies; i++){
+            uint64_t dependencyTag;
+            memcpy(&dependencyTag, dependenciesStart + i * sizeof(uint64_t), sizeof(dependencyTag));
+
+            auto dependencyIter = m_jobIDsByTag.find(dependencyTag);
+            if(dependencyIter == m_jobIDsByTag.end()){
+                std::cout << "Error: Job ring submission " << submission.m_tag << " depends on unknown tag " << dependencyTag << " (or on a job that completed too long ago)" << std::endl;
+                delete job;
+                job = nullptr;
+            } else {
+                job->AddDependency(dependencyIter->second);
+            }
+        }
+
+        if(job == nullptr){
+            if(!PublishCompletion(submission.m_tag, -1, JOB_RING_REJECTED, submission.m_inputFormat, noOutput)){
+                break; // Completion ring is full: leave the submission where it is, and tell the client next time
+            }
+        } else {
+            job->SetPriority(submission.m_priority);
+            m_jobIDsByTag[submission.m_tag] = job->GetUniqueID();
+            m_outstandingJobs.push_back({ submission.m_tag, job->GetUniqueID(), submission.m_inputFormat });
+            m_jobSystem->QueueJob(job);
+        }
+
+        submissions.Consume();
+        numSubmissions++;
+    }
+
+    return numSubmissions;
+}
+
+int JobRingServer::PublishCompletions(){
+    std::vector<unsigned char> output;
+    int numCompletions = 0;
+
+    size_t i = 0;
+    while(i < m_outstandingJobs.size()){
+        OutstandingJob outstandingJob = m_outstandingJobs[i];
+        JobStatus jobStatus = m_jobSystem->GetJobStatus(outstandingJob.m_jobID);
+        if(jobStatus != JOB_STATUS_COMPLETED && jobStatus != JOB_STATUS_RETIRED && jobStatus != JOB_STATUS_SKIPPED && jobStatus != JOB_STATUS_CANCELLED){
+            i++;
+            continue;
+        }
+
+        // Skipped (and cancelled) jobs never ran: no output
+        std::shared_ptr<const json> jobOutput = m_jobSystem->GetJobOutputByID(outstandingJob.m_jobID);
+        encodeJobData(jobOutput ? *jobOutput : json(), outstandingJob.m_outputFormat, output);
+        int completionStatus = (jobStatus == JOB_STATUS_SKIPPED || jobStatus == JOB_STATUS_CANCELLED) ? jobStatus : JOB_STATUS_COMPLETED;
+        if(!PublishCompletion(outstandingJob.m_tag, outstandingJob.m_jobID, completionStatus, outstandingJob.m_outputFormat, output)){
+            break; // Full, the client has to catch up first
+        }
+
+        // The client has the output now: retire the job, so it does not wait for someone to call FinishCompletedJobs().
+        // Unless they beat us to it.
+        if(jobStatus == JOB_STATUS_COMPLETED){
+            m_jobSystem->FinishJobIfCompleted(outstandingJob.m_jobID);
+        }
+
+        // Later submissions can still depend on it for a while, then its tag is forgotten
+        m_publishedTags.push_back(outstandingJob.m_tag);
+        if(m_publishedTags.size() > JOB_RING_NUM_PUBLISHED_TAGS_KEPT){
+            m_jobIDsByTag.erase(m_publishedTags.front());
+            m_publishedTags.pop_front();
+        }
+
+        m_outstandingJobs[i] = m_outstandingJobs.back();
+        m_outstandingJobs.pop_back();
+        numCompletions++;
+    }
+
+    return numCompletions;
+}
+
+bool JobRingServer::PublishCompletion(uint64_t tag, int jobID, int jobStatus, int outputFormat, const std::vector<unsigned char>& output){
+    JobRingCompletion completion;
+    memset(&completion, 0, sizeof(completion));
+    completion.m_tag = tag;
+    completion.m_jobID = jobID;
+    completion.m_jobStatus = jobStatus;
+    completion.m_outputSize = (uint32_t)output.size();
+    completion.m_outputFormat = (uint8_t)outputFormat;
+
+    m_completionBuffer.resize(sizeof(completion) + output.size());
+    memcpy(m_completionBuffer.data(), &completion, sizeof(completion));
+    if(!output.empty()){
+        memcpy(m_completionBuffer.data() + sizeof(completion), output.data(), output.size());
+    }
+
+    if(m_completionBuffer.size() > m_ring->GetCompletions().GetMaxRecordSize()){
+        std::cout << "Error: The output of job # " << jobID << " does not fit in the job ring, it is left out" << std::endl;
+        m_completionBuffer.resize(sizeof(completion));
+        ((JobRingCompletion*)m_completionBuffer.data())->m_outputSize = 0;
+    }
+
+    return m_ring->GetCompletions().TryWrite(m_completionBuffer.data(), (uint32_t)m_completionBuffer.size());
+}
@@ -0,0 +1,134 @@
+// Shared-memory front door of the job system: another process submits jobs, and gets their outputs back, without a syscall per job
+#pragma once
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+// NOTE:    One region (shm_open) holds two single-producer single-consumer rings of variable-size
+//          records. The client writes submissions, the job system drains them in batches and writes
+//          one completion per job. Each side only ever writes its own index, and publishes records
+//          with a release store that the other side reads with an acquire load: no locks, no syscalls.
+//          A ring has ONE client. Clients that need their own rings are given one each.
+//
+//          Submission: JobRingSubmission, then the job type identifier (m_typeLength chars, padded
+//                      to 8), the tags of its dependencies (uint64_t each), then the input, encoded in
+//                      m_inputFormat (a JobDataFormat). Dependencies are tags of jobs submitted earlier
+//                      on the same ring: the client picks tags, the job system picks job IDs. A tag is
+//                      forgotten once JOB_RING_NUM_PUBLISHED_TAGS_KEPT completions were published after its own.
+//          Completion: JobRingCompletion, then the output, in the format the job was submitted in.
+
+constexpr uint32_t JOB_RING_VERSION = 1;
+constexpr int JOB_RING_REJECTED = -1; // Completion status of a submission that could not become a job
+constexpr size_t JOB_RING_NUM_PUBLISHED_TAGS_KEPT = 1 << 16; // Completed jobs that later submissions can still depend on
+
+struct JobRingSubmission
+{
+    uint64_t    m_tag;
+    uint32_t    m_typeLength;
+    uint32_t    m_numDependencies;
+    uint32_t    m_inputSize;
+    int32_t     m_priority;
+    uint8_t     m_inputFormat;
+    uint8_t     m_padding[7];
+};
+
+struct JobRingCompletion
+{
+    uint64_t    m_tag;
+    int32_t     m_jobID;            // -1 if it was rejected
+    int32_t     m_jobStatus;        // JOB_STATUS_COMPLETED, JOB_STATUS_SKIPPED, JOB_STATUS_CANCELLED, or JOB_RING_REJECTED
+    uint32_t    m_outputSize;
+    uint8_t     m_outputFormat;
+    uint8_t     m_padding[3];
+};
+
+static_assert(sizeof(JobRingSubmission) == 32, "Clients in other languages rely on this layout");
+static_assert(sizeof(JobRingCompletion) == 24, "Clients in other languages rely on this layout");
+
+// Read and write positions of one ring, on their own cache lines so the two sides do not fight over them
+struct JobRingIndices
+{
+    alignas(64) std::atomic<uint64_t> m_writePosition;
+    alignas(64) std::atomic<uint64_t> m_readPosition;
+};
+
+class SpscByteRing
+{
+public:
+    SpscByteRing(JobRingIndices* indices, unsigned char* data, uint64_t capacity): m_indices(indices), m_data(data), m_capacity(capacity) {}
+
+    // Producer side. False when the ring is too full for the record, nothing is written then.
+    bool TryWrite(const unsigned char* record, uint32_t recordSize);
+
+    // Consumer side. Peek points at the next record, in the ring itself, until Consume() gives its room back.
+    bool Peek(const unsigned char*& record, uint32_t& recordSize);
+    void Consume();
+
+    uint64_t GetMaxRecordSize() const { return m_capacity / 2 - sizeof(uint64_t); }
+
+private:
+    JobRingIndices*     m_indices;
+    unsigned char*      m_data;
+    uint64_t            m_capacity;
+    uint64_t            m_peekedEnd = 0; // Read position once the peeked record is consumed
+};
+
+// The shared region itself. The job system creates it, clients open it by name.
+class JobRing
+{
+public:
+    static JobRing* Create(const std::string& name, uint64_t capacity); // "capacity" bytes per ring, rounded up to a power of 2
+    static JobRing* Open(const std::string& name);
+    ~JobRing(); // The creator also removes the name
+
+    SpscByteRing& GetSubmissions() { return m_submissions; }
+    SpscByteRing& GetCompletions() { return m_completions; }
+    const std::string& GetName() const { return m_name; }
+
+private:
+    JobRing(const std::string& name, void* mapping, size_t mappingSize, bool isOwner);
+
+    std::string     m_name;
+    void*           m_mapping = nullptr;
+    size_t          m_mappingSize = 0;
+    bool            m_isOwner = false;
+    SpscByteRing    m_submissions;
+    SpscByteRing    m_completions;
+};
+
+class JobSystem;
+
+// Job system side of a ring: a thread that turns submissions into queued jobs, and completed jobs into completions
+class JobRingServer
+{
+public:
+    JobRingServer(JobSystem* jobSystem, JobRing* ring); // Takes ownership of the ring
+    ~JobRingServer();
+
+private:
+    struct OutstandingJob
+    {
+        uint64_t    m_tag;
+        int         m_jobID;
+        uint8_t     m_outputFormat;
+    };
+
+    void ServerMain(); // Called in the server thread, runs until the server is destroyed
+    int DrainSubmissions(int maxSubmissions); // Returns how many it took
+    int PublishCompletions(); // Returns how many it published
+    bool PublishCompletion(uint64_t tag, int jobID, int jobStatus, int outputFormat, const std::vector<unsigned char>& output);
+
+    JobSystem*                  m_jobSystem;
+    JobRing*                    m_ring;
+    std::vector<OutstandingJob> m_outstandingJobs;  // Submitted, completion not published yet. Only touched by the server thread.
+    std::unordered_map<uint64_t, int> m_jobIDsByTag; // Jobs submitted on the ring, so later submissions can depend on them
+    std::deque<uint64_t>        m_publishedTags; // Oldest first: the tags of completed jobs that are still in "m_jobIDsByTag"
+    std::vector<unsigned char>  m_completionBuffer;
+    std::atomic<bool>           m_isStopping{false};
+    std::thread*                m_thread = nullptr;
+};
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+
+#include "jobserver.h"
+
+JobServer::JobServer(int numTokens){
+    int pipeFDs[2];
+
+    // NOTE: No O_CLOEXEC on purpose, the "make" processes we spawn must inherit both ends
+    if(pipe(pipeFDs) != 0){
+        std::cerr << "Error: Unable to create the jobserver pipe. Compile jobs will not be throttled." << std::endl;
+        return;
+    }
+
+    m_readFD = pipeFDs[0];
+    m_writeFD = pipeFDs[1];
+    SetNumTokens(numTokens);
+}
+
+JobServer::JobServer(int readFD, int writeFD): m_readFD(readFD), m_writeFD(writeFD), m_isJoined(true) {}
+
+JobServer* JobServer::JoinFromAuth(const std::string& auth){
+    int readFD = -1;
+    int writeFD = -1;
+    if(sscanf(auth.c_str(), "%d,%d", &readFD, &writeFD) != 2){
+        return nullptr;
+    }
+
+    // Both ends must have been inherited for real
+    if(fcntl(readFD, F_GETFD) < 0 || fcntl(writeFD, F_GETFD) < 0){
+        return nullptr;
+    }
+
+    return new JobServer(readFD, writeFD);
+}
+
+JobServer::~JobServer(){
+    if(m_readFD >= 0){
+        close(m_readFD);
+    }
+    if(m_writeFD >= 0){
+        close(m_writeFD);
+    }
+}
+
+bool JobServer::AcquireToken(){
+    if(!IsValid()){
+        return false;
+    }
+
+    // NOTE:    The pipe is shared with the "make" processes we spawn, and recent versions of make
+    //          switch it to non-blocking. When no token is left, read() then fails with EAGAIN
+    //          instead of waiting, so we wait for one with poll() ourselves.
+    char token;
+    while(read(m_readFD, &token, 1) != 1){
+        if(errno == EAGAIN || errno == EWOULDBLOCK){
+            struct pollfd pollFD = { m_readFD, POLLIN, 0 };
+            poll(&pollFD, 1, -1);
+        } else if(errno != EINTR){
+            std::cerr << "Error: Unable to read a token from the jobserver" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void JobServer::ReleaseToken(){
+    if(!IsValid()){
+        return;
+    }
+
+    const char token = '+'; // Same token GNU make uses
+    while(write(m_writeFD, &token, 1) != 1){
+        if(errno != EINTR){
+            std::cerr << "Error: Unable to give a token back to the jobserver" << std::endl;
+            return;
+        }
+    }
+}
+
+int JobServer::RefillTokens(){
+    if(m_isJoined || !IsValid()){
+        return 0; // Only the process that owns the pool knows how big it is
+    }
+
+    int numFreeTokens = 0;
+    if(ioctl(m_readFD, FIONREAD, &numFreeTokens) != 0){
+        return 0;
+    }
+
+    m_numTokensMutex.lock();
+    int numLostTokens = m_numTokens - numFreeTokens;
+    m_numTokensMutex.unlock();
+
+    for(int i = 0; i < numLostTokens; i++){
+        ReleaseToken();
+    }
+    return numLostTokens > 0 ? numLostTokens : 0;
+}
+
+void JobServer::SetNumTokens(int numTokens){
+    if(m_isJoined){
+        return; // Only the process that owns the pool sizes it
+    }
+
+    if(numTokens < 1){
+        numTokens = 1;
+    }
+
+    m_numTokensMutex.lock();
+    int numTokensDelta = numTokens - m_numTokens;
+    m_numTokens = numTokens;
+    m_numTokensMutex.unlock();
+
+    for(; numTokensDelta > 0; numTokensDelta--){
+        ReleaseToken();
+    }
+    for(; numTokensDelta < 0; numTokensDelta++){
+        AcquireToken(); // Swallow it for good
+    }
+}
+
+int JobServer::GetNumTokens() const{
+    m_numTokensMutex.lock();
+    int numTokens = m_numTokens;
+    m_numTokensMutex.unlock();
+
+    return numTokens;
+}
+
+std::string JobServer::GetMakeFlags() const{
+    if(!IsValid()){
+        return "";
+    }
+
+    return " -j --jobserver-auth=" + GetAuth();
+}
+
+std::string JobServer::GetAuth() const{
+    return std::to_string(m_readFD) + "," + std::to_string(m_writeFD);
+}
@@ -0,0 +1,41 @@
+// Machine-wide pool of compile tokens, speaking the GNU make jobserver protocol
+#pragma once
+#include <mutex>
+#include <string>
+
+// NOTE:    A jobserver is just a pipe pre-filled with one byte per token. Whoever wants to run a
+//          process reads a byte first, and writes it back when the process is done. Every "make"
+//          we spawn is told about the pipe through MAKEFLAGS, so its own parallel children draw
+//          from the SAME pool. That way, the total number of compile processes across all the
+//          CompileJobs never goes above the number of tokens.
+class JobServer
+{
+public:
+    explicit JobServer(int numTokens);
+    JobServer(int readFD, int writeFD); // Joins a pool another process owns (and sized), through inherited file descriptors
+    ~JobServer();
+
+    static JobServer* JoinFromAuth(const std::string& auth); // "R,W" as returned by GetAuth(). nullptr if it is not usable.
+
+    bool IsValid() const { return m_readFD >= 0 && m_writeFD >= 0; }
+
+    bool AcquireToken(); // Blocks until a token is available. False if none could be taken: do not give one back then.
+    void ReleaseToken();
+
+    // Puts back the tokens that are neither in the pipe nor held: those of a "make" that was killed with them.
+    // Only call it when nothing holds a token. Returns how many were put back.
+    int RefillTokens();
+
+    void SetNumTokens(int numTokens); // Growing is immediate. Shrinking waits for the extra tokens to come back.
+    int GetNumTokens() const;
+
+    std::string GetMakeFlags() const; // Value of MAKEFLAGS that makes a child "make" join the pool
+    std::string GetAuth() const; // The two file descriptors of the pipe, "R,W"
+
+private:
+    int m_readFD = -1;
+    int m_writeFD = -1;
+    int m_numTokens = 0;
+    bool m_isJoined = false; // The pool belongs to another process, we do not resize it
+    mutable std::mutex m_numTokensMutex;
+};
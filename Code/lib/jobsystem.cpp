@@ -2,6 +2,12 @@
 #include <cstdlib>
 #include <ctime>
 #include <iomanip>
+#include <algorithm>
+#include <set>
+#include <filesystem>
+#include <fstream>
+#include <dlfcn.h>
+#include <glob.h>
 
 #include "jobsystem.h"
 #include "jobworkerthread.h"
@@ -10,106 +16,1244 @@
 #include "../Jobs/parsingjob.h"
 #include "../Jobs/jsonjob.h"
 #include "../Jobs/conditionaljob.h"
+#include "../Jobs/compileunitjob.h"
 
 // static variable are initialized in the cpp
 JobSystem* JobSystem::s_jobSystem = nullptr;
 
 typedef void (*JobCallBack)(Job* completedJob); // JobCallBack is a type describing a ptr func that point to a function accepting a job, and that returns a void
 
+
 JobSystem::JobSystem(){
     m_jobHistory.reserve( 256 * 1024 ); // Reserves a big chunk of memory. Why? Talk to Dr. Clorey. But it gives us much higher runtime performance.
 }
 
-JobSystem::~JobSystem(){
-    m_workerThreadsMutex.lock();
-    int numWorkerThreads = (int)m_workerThreads.size();
+JobSystem::~JobSystem(){
+    // No more jobs from other processes
+    m_ringServersMutex.lock();
+    for(JobRingServer* ringServer: m_ringServers){
+        delete ringServer;
+    }
+    m_ringServers.clear();
+    m_ringServersMutex.unlock();
+
+    // The controller must not start new workers while we tear them down
+    StopWorkerPoolController();
+
+    // Jobs waiting for their retry are dropped. They stay in the journal, as queued.
+    m_watchdogMutex.lock();
+    bool hasJobsAwaitingRetry = !m_jobsAwaitingRetry.empty();
+    m_watchdogMutex.unlock();
+    StopWatchdog();
+
+    m_workerThreadsMutex.lock();
+    int numWorkerThreads = (int)m_workerThreads.size();
+
+    // First, tell each work thread worker to stop picking up jobs
+    for(int i = 0; i < numWorkerThreads; i++){
+        m_workerThreads[i]->ShutDown();
+    }
+
+    while( !m_workerThreads.empty() ){ // As long as the vector is not empty
+        delete m_workerThreads.back(); // Deallocate the last worker thread in the vector
+        m_workerThreads.pop_back(); // Decrease the vector. If the above step was not, performed... memory leak.
+    }
+    for(JobWorkerThread* retiredWorker: m_retiredWorkerThreads){
+        delete retiredWorker; // Stopping already, if not gone
+    }
+    m_retiredWorkerThreads.clear();
+    m_workerThreadsMutex.unlock();
+
+    // Deleting the journal flushes it. If every job made it to the end, there is nothing left to recover.
+    if(m_journal){
+        std::string journalPath = m_journal->GetPath();
+        delete m_journal;
+        m_journal = nullptr;
+
+        if(jobqueued == 0 && jobrunning == 0 && jobcompleted == 0 && !hasJobsAwaitingRetry){
+            std::remove(journalPath.c_str());
+        }
+    }
+
+    delete m_historyStore; // Everything it holds is already in the page cache, the kernel writes it back
+    m_historyStore = nullptr;
+
+    // No worker left to complete the jobs it resumes. Jobs still suspended are abandoned, like the running ones.
+    m_jobReactorMutex.lock();
+    delete m_jobReactor;
+    m_jobReactor = nullptr;
+    m_jobReactorMutex.unlock();
+
+    // Writes whatever output files are still pending
+    m_fileIOServiceMutex.lock();
+    delete m_fileIOService;
+    m_fileIOService = nullptr;
+    m_fileIOServiceMutex.unlock();
+
+    // Only once the workers are gone, no compile job can be holding a token anymore
+    delete m_jobServer;
+    m_jobServer = nullptr;
+
+    if(m_buildManifest){
+        m_buildManifest->Save();
+        delete m_buildManifest;
+        m_buildManifest = nullptr;
+    }
+}
+
+JobSystem* JobSystem::CreateOrGet(){
+    if( !s_jobSystem ){
+        s_jobSystem = new JobSystem();
+    }
+
+    return s_jobSystem;
+}
+
+void JobSystem::Destroy(){
+    if(s_jobSystem){
+        delete s_jobSystem;
+        s_jobSystem = nullptr;
+    }
+}
+
+void JobSystem::CreateWorkerThread(const char* uniqueName, unsigned long workerJobChannels){
+    JobWorkerThread* newWorker = new JobWorkerThread( uniqueName, workerJobChannels, this);
+
+    m_workerThreadsMutex.lock();
+    auto placementIter = m_workerPlacementConfigs.find(workerJobChannels);
+    if(placementIter != m_workerPlacementConfigs.end()){
+        newWorker->SetCpuAffinity(m_workerPlacement.AssignCpus(placementIter->second));
+    }
+    auto workerProcessIter = m_workerProcessPaths.find(workerJobChannels);
+    if(workerProcessIter != m_workerProcessPaths.end()){
+        newWorker->SetWorkerProcess(NewWorkerProcess(workerProcessIter->second));
+    }
+    m_workerThreads.push_back(newWorker);
+    m_workerThreadsMutex.unlock();
+
+    newWorker->StartUp();
+}
+
+void JobSystem::SetWorkerPlacement(unsigned long workerJobChannels, WorkerPlacementPolicy policy, const std::vector<int>& cpuSet){
+    WorkerPlacementConfig config;
+    config.m_policy = policy;
+    config.m_cpuSet = cpuSet;
+
+    m_workerThreadsMutex.lock();
+    m_workerPlacementConfigs[workerJobChannels] = config;
+
+    for(JobWorkerThread* worker: m_workerThreads){
+        if(worker->GetWorkerJobChannels() == workerJobChannels){
+            worker->SetCpuAffinity(m_workerPlacement.AssignCpus(config));
+        }
+    }
+    m_workerThreadsMutex.unlock();
+}
+
+// NOTE:    The library knows where it was loaded from, and "jobworker.out" gets built one folder up
+//          from it (see the makefile), so neither Python nor C callers have to know where it is.
+static std::string getDefaultJobWorkerPath(){
+    Dl_info libraryInfo;
+    if(dladdr((void*)&GetJobSystemInstance, &libraryInfo) == 0 || libraryInfo.dli_fname == nullptr){
+        return "./Code/jobworker.out";
+    }
+
+    std::filesystem::path libraryPath = std::filesystem::absolute(libraryInfo.dli_fname);
+    return (libraryPath.parent_path().parent_path() / "jobworker.out").lexically_normal().string();
+}
+
+void JobSystem::SetWorkerProcesses(unsigned long workerJobChannels, const std::string& executablePath){
+    std::string workerProcessPath = executablePath.empty() ? getDefaultJobWorkerPath() : executablePath;
+
+    m_workerThreadsMutex.lock();
+    m_workerProcessPaths[workerJobChannels] = workerProcessPath;
+
+    for(JobWorkerThread* worker: m_workerThreads){
+        if(worker->GetWorkerJobChannels() == workerJobChannels){
+            worker->SetWorkerProcess(NewWorkerProcess(workerProcessPath));
+        }
+    }
+    m_workerThreadsMutex.unlock();
+}
+
+// NOTE:    Processes do not start until their worker gets a job. The environment lets the compile
+//          jobs they run draw from OUR jobserver (the pipe is inherited), so adding processes never
+//          adds compile parallelism on top of what SetCompileParallelism() allows.
+WorkerProcess* JobSystem::NewWorkerProcess(const std::string& executablePath){
+    std::vector<std::string> environment;
+    JobServer* jobServer = GetJobServer();
+    if(jobServer->IsValid()){
+        environment.push_back("JOBSYSTEM_JOBSERVER_AUTH=" + jobServer->GetAuth());
+    }
+
+    return new WorkerProcess(executablePath, environment);
+}
+
+bool JobSystem::ExecuteInWorkerProcess(Job* job, WorkerProcess* workerProcess){
+    // Jobs created without a registered type (directly in C++) cannot be re-created on the other side
+    if(!job->CanRunInWorkerProcess() || job->m_jobTypeIdentifier.empty()){
+        return false;
+    }
+
+    json dependencyOutputs = json::array();
+    for(int dependencyID: job->GetDependencies()){
+        std::shared_ptr<const json> dependencyOutput = GetJobOutputByID(dependencyID);
+        if(dependencyOutput){
+            dependencyOutputs.push_back({ dependencyID, *dependencyOutput });
+        }
+    }
+
+    json request = {
+        {"id", job->m_jobID},
+        {"jobTypeIdentifier", job->m_jobTypeIdentifier},
+        {"input", *job->m_input},
+        {"dependencies", job->m_dependencies},
+        {"dependencyOutputs", std::move(dependencyOutputs)}
+    };
+
+    // NOTE:    Timing the job out (or cancelling it) does not kill the process: it would take the jobserver
+    //          token of the command it runs with it. It is signaled instead, and kills that command itself.
+    json reply;
+    if(workerProcess->Start()){
+        job->SetChildProcess(workerProcess->GetPid(), false, WorkerProcess::INTERRUPT_SIGNAL);
+    }
+    bool hasReplied = workerProcess->Call(request, reply);
+    job->ClearChildProcess();
+    if(hasReplied && reply.contains("output")){
+        job->SetResult((JobResult)reply.value("result", (int)JOB_RESULT_NONE));
+        job->setOutputJson(std::move(reply["output"]));
+    } else {
+        job->SetResult(JOB_RESULT_FAILURE);
+        // The job still completes, with an output that says what happened, so its dependents are not stuck forever
+        job->setOutputJson(json{
+            {"status", "error"},
+            {"error", "The worker process running the job crashed"},
+            {"jobType", job->m_jobType},
+            {"jobChannels", job->m_jobChannels}
+        });
+    }
+    return true;
+}
+
+// NOTE:    Runs in the "jobworker" process. Its job system has no workers, and no history besides the
+//          dependency outputs of the job at hand, which are forgotten as soon as it is done.
+json JobSystem::ExecuteJobRequest(const json& request){
+    int jobID = request.value("id", -1);
+    const json& dependencyOutputs = request.contains("dependencyOutputs") ? request["dependencyOutputs"] : json::array();
+
+    m_jobHistoryMutex.lock();
+    for(const json& dependencyOutput: dependencyOutputs){
+        int dependencyID = dependencyOutput.at(0).get<int>();
+        JobHistoryEntry& historyEntry = GetHistoryEntry(dependencyID);
+        historyEntry = JobHistoryEntry(dependencyID, -1, JOB_STATUS_COMPLETED);
+        historyEntry.m_jobOutput = std::make_shared<const json>(dependencyOutput.at(1));
+        m_jobResults.Set(dependencyID, jobResultFromOutput(dependencyOutput.at(1)));
+    }
+    m_jobHistoryMutex.unlock();
+
+    json reply = { {"id", jobID} };
+    Job* job = CreateJob(request.value("jobTypeIdentifier", ""), request.contains("input") ? request["input"] : json::object());
+    if(job){
+        job->m_jobID = jobID;
+        job->m_dependencies = request.value("dependencies", std::vector<int>());
+        m_jobRequestMutex.lock();
+        m_jobRequestJob = job;
+        m_jobRequestMutex.unlock();
+
+        job->Execute();
+        JobReactor::ResumeInline(job, this); // No reactor here, an async job waits right in this process
+
+        m_jobRequestMutex.lock();
+        m_jobRequestJob = nullptr;
+        m_jobRequestMutex.unlock();
+
+        std::shared_ptr<const json> jobOutput = job->GetOutputJson();
+        reply["output"] = jobOutput ? *jobOutput : json::object();
+        reply["result"] = job->GetResult();
+        delete job;
+    } else {
+        reply["output"] = { {"status", "error"}, {"error", "Job type '" + request.value("jobTypeIdentifier", "") + "' is not registered in the worker process"} };
+        reply["result"] = JOB_RESULT_FAILURE;
+    }
+
+    m_jobHistoryMutex.lock();
+    for(const json& dependencyOutput: dependencyOutputs){
+        int dependencyID = dependencyOutput.at(0).get<int>();
+        GetHistoryEntry(dependencyID) = JobHistoryEntry(dependencyID, -1, JOB_STATUS_NEVER_SEEN);
+        m_jobResults.Set(dependencyID, JOB_RESULT_NONE);
+    }
+    m_jobHistoryMutex.unlock();
+
+    return reply;
+}
+
+void JobSystem::InterruptJobRequest(){
+    m_jobRequestMutex.lock();
+    if(m_jobRequestJob){
+        m_jobRequestJob->Interrupt(false);
+    }
+    m_jobRequestMutex.unlock();
+    StartWatchdog(); // Kills its child process if it does not stop
+}
+
+void JobSystem::DestroyWorkerThread(const char* uniqueName){
+    m_workerThreadsMutex.lock();
+    JobWorkerThread* doomedWorker = nullptr;
+    std::vector<JobWorkerThread*>::iterator it = m_workerThreads.begin();
+
+    for(; it != m_workerThreads.end(); ++it){
+        if (strcmp( (*it)->m_uniqueName, uniqueName) == 0){
+            doomedWorker = *it;
+            break;
+        }
+    }
+
+    m_workerThreadsMutex.unlock();
+
+    if(doomedWorker){
+        DestroyWorkerThread(doomedWorker);
+    }
+}
+
+void JobSystem::DestroyWorkerThread(JobWorkerThread* doomedWorker){
+    m_workerThreadsMutex.lock();
+    std::vector<JobWorkerThread*>::iterator it = std::find(m_workerThreads.begin(), m_workerThreads.end(), doomedWorker);
+    bool wasFound = (it != m_workerThreads.end());
+    if(wasFound){
+        m_workerThreads.erase(it);
+    }
+    m_workerThreadsMutex.unlock();
+
+    if(wasFound){
+        doomedWorker->ShutDown();
+        delete doomedWorker; // Blocks until the worker is done with its current job, if any
+    }
+}
+
+// NOTE:    Not DestroyWorkerThread(): it joins the worker, from the pool controller's thread. The worker is
+//          only asked to stop (if it is still idle, see TryRetire), and deleted once it exited on its own.
+void JobSystem::RetireIdleWorkerThread(unsigned long workerJobChannels, std::chrono::milliseconds idleDuration){
+    m_workerThreadsMutex.lock();
+    for(auto it = m_workerThreads.begin(); it != m_workerThreads.end(); ++it){
+        JobWorkerThread* worker = *it;
+        if(worker->GetWorkerJobChannels() == workerJobChannels && worker->TryRetire(idleDuration)){
+            m_workerThreads.erase(it);
+            m_retiredWorkerThreads.push_back(worker);
+            break; // One at a time
+        }
+    }
+    m_workerThreadsMutex.unlock();
+}
+
+void JobSystem::ReapRetiredWorkerThreads(){
+    std::vector<JobWorkerThread*> exitedWorkers;
+    m_workerThreadsMutex.lock();
+    for(auto it = m_retiredWorkerThreads.begin(); it != m_retiredWorkerThreads.end();){
+        if((*it)->HasExited()){
+            exitedWorkers.push_back(*it);
+            it = m_retiredWorkerThreads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_workerThreadsMutex.unlock();
+
+    for(JobWorkerThread* exitedWorker: exitedWorkers){
+        delete exitedWorker; // Its thread is done, the join returns right away
+    }
+}
+
+void JobSystem::SetWorkerPoolLimits(unsigned long workerJobChannels, int minWorkers, int maxWorkers){
+    minWorkers = std::max(minWorkers, 0);
+    maxWorkers = std::max(maxWorkers, minWorkers);
+
+    m_workerThreadsMutex.lock();
+    int numWorkers = 0;
+    for(JobWorkerThread* worker: m_workerThreads){
+        if(worker->GetWorkerJobChannels() == workerJobChannels){
+            numWorkers++;
+        }
+    }
+
+    bool configFound = false;
+    for(WorkerPoolChannelConfig& config: m_workerPoolConfigs){
+        if(config.m_jobChannels == workerJobChannels){
+            config.m_minWorkers = minWorkers;
+            config.m_maxWorkers = maxWorkers;
+            configFound = true;
+            break;
+        }
+    }
+    if(!configFound){
+        m_workerPoolConfigs.emplace_back(workerJobChannels, minWorkers, maxWorkers);
+    }
+    m_workerThreadsMutex.unlock();
+
+    // The channel must always be able to make progress, even before the controller gets to it
+    for(; numWorkers < minWorkers; numWorkers++){
+        CreateWorkerThread(generateRandomThreadWorkerName(), workerJobChannels);
+    }
+}
+
+void JobSystem::CreateDefaultWorkerPool(){
+    int numHardwareThreads = (int)std::thread::hardware_concurrency();
+    if(numHardwareThreads <= 0){
+        numHardwareThreads = 4; // The standard allows "unknown", assume a small machine
+    }
+
+    // NOTE:    Compile jobs are the long ones, so they get to scale up to the whole machine.
+    //          Parsing and JSON jobs are short, half the machine is plenty for them.
+    SetWorkerPoolLimits(JOB_CHANNEL_COMPILE, 2, std::max(2, numHardwareThreads));
+    SetWorkerPoolLimits(JOB_CHANNEL_PARSING, 1, std::max(1, numHardwareThreads / 2));
+    SetWorkerPoolLimits(JOB_CHANNEL_JSON,    1, std::max(1, numHardwareThreads / 2));
+    SetWorkerPoolLimits(JOB_CHANNEL_OTHER,   1, 2);
+}
+
+void JobSystem::StartWorkerPoolController(){
+    m_poolControllerMutex.lock();
+    if(m_poolControllerThread == nullptr){
+        m_isPoolControllerStopping = false;
+        m_poolControllerThread = new std::thread(&JobSystem::WorkerPoolControllerMain, this);
+    }
+    m_poolControllerMutex.unlock();
+}
+
+void JobSystem::StopWorkerPoolController(){
+    m_poolControllerMutex.lock();
+    std::thread* controllerThread = m_poolControllerThread;
+    m_poolControllerThread = nullptr;
+    m_isPoolControllerStopping = true;
+    m_poolControllerMutex.unlock();
+
+    if(controllerThread){
+        controllerThread->join();
+        delete controllerThread;
+    }
+}
+
+void JobSystem::StartWatchdog(){
+    m_watchdogMutex.lock();
+    if(m_watchdogThread == nullptr){
+        m_isWatchdogStopping = false;
+        m_watchdogThread = new std::thread(&JobSystem::WatchdogMain, this);
+    }
+    m_watchdogMutex.unlock();
+}
+
+void JobSystem::StopWatchdog(){
+    m_watchdogMutex.lock();
+    std::thread* watchdogThread = m_watchdogThread;
+    m_watchdogThread = nullptr;
+    m_isWatchdogStopping = true;
+    m_watchdogMutex.unlock();
+    m_watchdogSignal.notify_one();
+
+    if(watchdogThread){
+        watchdogThread->join();
+        delete watchdogThread;
+    }
+
+    m_watchdogMutex.lock();
+    for(auto& entry: m_jobsAwaitingRetry){
+        delete entry.second;
+    }
+    m_jobsAwaitingRetry.clear();
+    m_watchdogMutex.unlock();
+}
+
+// NOTE:    Checks the running jobs every few milliseconds: a timeout is not worth more precision than that.
+//          A job that runs in this process without a child process (parsing a huge file, for instance)
+//          cannot be stopped from the outside. It is only marked as timed out, and fails once it returns.
+void JobSystem::WatchdogMain(){
+    const std::chrono::milliseconds watchdogPeriod(10);
+
+    std::unique_lock<std::mutex> watchdogLock(m_watchdogMutex);
+    while(!m_isWatchdogStopping){
+        m_watchdogSignal.wait_for(watchdogLock, watchdogPeriod);
+        if(m_isWatchdogStopping){
+            break;
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::vector<Job*> jobsToRetry;
+        while(!m_jobsAwaitingRetry.empty() && m_jobsAwaitingRetry.begin()->first <= now){
+            jobsToRetry.push_back(m_jobsAwaitingRetry.begin()->second);
+            m_jobsAwaitingRetry.erase(m_jobsAwaitingRetry.begin());
+        }
+        watchdogLock.unlock();
+
+        for(Job* job: jobsToRetry){
+            QueueJob(job);
+        }
+
+        m_jobsRunningMutex.lock();
+        for(Job* job: m_jobsRunning){
+            if(job->IsInterrupted()){
+                if(job->EscalateInterrupt(now)){
+                    std::cout << "Job # " << job->m_jobID << " was still running " << JOB_INTERRUPT_GRACE_MS << " ms after it was interrupted: killed" << std::endl;
+                }
+                continue;
+            }
+            if(job->m_timeoutMs <= 0 || now < job->m_deadline){
+                continue;
+            }
+
+            job->Interrupt(true);
+            std::cout << "Job # " << job->m_jobID << " timed out after " << job->m_timeoutMs << " ms" << std::endl;
+        }
+        m_jobsRunningMutex.unlock();
+
+        // In a "jobworker" process, the job it runs for another job system is not in "m_jobsRunning"
+        m_jobRequestMutex.lock();
+        if(m_jobRequestJob && m_jobRequestJob->IsInterrupted()){
+            m_jobRequestJob->EscalateInterrupt(now);
+        }
+        m_jobRequestMutex.unlock();
+
+        watchdogLock.lock();
+    }
+}
+
+int JobSystem::CountReadyJobs(unsigned long workerJobChannels) const{
+    int numReadyJobs = 0;
+
+    m_jobsQueuedMutex.lock();
+    for(Job* queuedJob: m_jobsQueued){
+        if((queuedJob->m_jobChannels & workerJobChannels) == 0 || queuedJob->m_isCancelled){
+            continue;
+        }
+
+        bool dependenciesCompleted = true;
+        for(int dependencyId: queuedJob->GetDependencies()){
+            if(!IsDependencySatisfied(dependencyId)){
+                dependenciesCompleted = false;
+                break;
+            }
+        }
+
+        if(dependenciesCompleted){
+            numReadyJobs++;
+        }
+    }
+    m_jobsQueuedMutex.unlock();
+
+    return numReadyJobs;
+}
+
+// NOTE:    Workers are started as soon as ready jobs outnumber the idle workers of their channel,
+//          but only retired one at a time, after they have been idle for a while. Starting a thread
+//          is cheap compared to a compile job, so we'd rather keep a few around than thrash.
+void JobSystem::WorkerPoolControllerMain(){
+    const std::chrono::milliseconds controllerPeriod(20);
+    const std::chrono::milliseconds retireAfterIdle(2000);
+
+    while(true){
+        m_poolControllerMutex.lock();
+        bool isStopping = m_isPoolControllerStopping;
+        m_poolControllerMutex.unlock();
+        if(isStopping){
+            break;
+        }
+
+        m_workerThreadsMutex.lock();
+        std::vector<WorkerPoolChannelConfig> configs = m_workerPoolConfigs;
+        m_workerThreadsMutex.unlock();
+
+        for(const WorkerPoolChannelConfig& config: configs){
+            int numWorkers = 0;
+            int numIdleWorkers = 0;
+
+            m_workerThreadsMutex.lock();
+            for(JobWorkerThread* worker: m_workerThreads){
+                if(worker->GetWorkerJobChannels() != config.m_jobChannels){
+                    continue;
+                }
+                numWorkers++;
+                if(worker->isIdleFor(std::chrono::milliseconds(0))){
+                    numIdleWorkers++;
+                }
+            }
+            m_workerThreadsMutex.unlock();
+
+            int numReadyJobs = CountReadyJobs(config.m_jobChannels);
+
+            if(numReadyJobs > numIdleWorkers && numWorkers < config.m_maxWorkers){
+                int numNewWorkers = std::min(numReadyJobs - numIdleWorkers, config.m_maxWorkers - numWorkers);
+                for(int i = 0; i < numNewWorkers; i++){
+                    CreateWorkerThread(generateRandomThreadWorkerName(), config.m_jobChannels);
+                }
+            }
+            else if(numReadyJobs == 0 && numWorkers > config.m_minWorkers){
+                RetireIdleWorkerThread(config.m_jobChannels, retireAfterIdle);
+            }
+        }
+
+        ReapRetiredWorkerThreads();
+
+        std::this_thread::sleep_for(controllerPeriod);
+    }
+}
+
+void JobSystem::QueueJob(Job* job){
+    QueueJob(job, false);
+}
+
+bool JobSystem::QueueLazyJob(Job* job){
+    return QueueJob(job, true);
+}
+
+bool JobSystem::QueueJob(Job* job, bool unlessCancelled){
+    // Everything needed to create the job again, should we crash before it completes
+    json queuedRecord;
+    bool isJournaled = (m_journal != nullptr && !job->m_isTransient);
+    if(isJournaled){
+        queuedRecord["record"] = "queued";
+        queuedRecord["id"] = job->GetUniqueID();
+        queuedRecord["jobTypeIdentifier"] = job->m_jobTypeIdentifier;
+        queuedRecord["input"] = *job->m_input;
+        queuedRecord["dependencies"] = job->GetDependencies();
+        queuedRecord["priority"] = job->m_priority;
+        if(job->m_gateJobID >= 0){
+            queuedRecord["gate"] = job->m_gateJobID;
+            queuedRecord["runIfConditionMet"] = job->m_runIfConditionMet;
+        }
+        if(job->m_timeoutMs > 0 || job->m_maxRetries > 0){
+            queuedRecord["timeoutMs"] = job->m_timeoutMs;
+            queuedRecord["maxRetries"] = job->m_maxRetries;
+            queuedRecord["retryBackoffMs"] = job->m_retryBackoffMs;
+        }
+    }
+
+    if(job->m_timeoutMs > 0 || job->m_maxRetries > 0){
+        StartWatchdog();
+    }
+
+    m_jobsQueuedMutex.lock();
+
+    m_jobHistoryMutex.lock();
+    JobHistoryEntry& historyEntry = GetHistoryEntry(job->GetUniqueID());
+    // NOTE: CancelJob() marks it under the queue lock too: it is either cancelled before this, or finds it queued
+    if(unlessCancelled && historyEntry.m_jobStatus == JOB_STATUS_CANCELLED){
+        m_jobHistoryMutex.unlock();
+        m_jobsQueuedMutex.unlock();
+        return false;
+    }
+    historyEntry = JobHistoryEntry(job->GetUniqueID(), job->m_jobType, JOB_STATUS_QUEUED);
+    StoreHistoryEntry(historyEntry, true);
+    m_jobResults.Set(job->GetUniqueID(), JOB_RESULT_NONE); // Queued again (after a crash): its old result no longer holds
+    //increase job queued
+    jobqueued++;
+
+    // NOTE:    Remember the edges, so the job can be found from its dependencies (to cancel it with them, or to lengthen
+    //          their critical paths). Not from those already done: nobody erases their list anymore once they completed.
+    for(int dependencyID: job->GetDependencies()){
+        int dependencyStatus = (dependencyID >= 0 && dependencyID < (int)m_jobHistory.size()) ? m_jobHistory[dependencyID].m_jobStatus : JOB_STATUS_NEVER_SEEN;
+        if(dependencyStatus == JOB_STATUS_NEVER_SEEN || dependencyStatus == JOB_STATUS_QUEUED || dependencyStatus == JOB_STATUS_RUNNING){
+            m_queuedDependents[dependencyID].push_back(job->GetUniqueID());
+        }
+    }
+    
+    m_jobHistoryMutex.unlock();
+
+    // Journaled before any worker can see it, so its "running" record always comes after
+    if(isJournaled){
+        m_journal->Append(queuedRecord);
+    }
+
+    m_jobsQueued.push_back(job);
+    m_jobsQueuedByID[job->m_jobID] = job;
+
+    if(m_schedulingMode == JOB_SCHEDULING_CRITICAL_PATH){
+        UpdateCriticalPaths(job);
+    }
+    m_jobsQueuedMutex.unlock();
+    return true;
+}
+
+// NOTE:    The longest remaining path of a job is its own cost plus the longest path of the
+//          jobs waiting on it. Jobs can be queued in any order, so when a job arrives we first
+//          pick up the dependents that were queued before it, then walk UP its dependencies and
+//          lengthen their paths if going through this job makes them longer. A job's path only
+//          ever grows, so each walk stops as soon as nothing changes.
+void JobSystem::UpdateCriticalPaths(Job* queuedJob){
+    long long longestDependentPath = 0;
+    auto dependentsIter = m_queuedDependents.find(queuedJob->m_jobID);
+    if(dependentsIter != m_queuedDependents.end()){
+        for(int dependentID: dependentsIter->second){
+            auto dependentIter = m_jobsQueuedByID.find(dependentID);
+            if(dependentIter != m_jobsQueuedByID.end()){
+                longestDependentPath = std::max(longestDependentPath, dependentIter->second->m_criticalPathLength);
+            }
+        }
+    }
+    queuedJob->m_criticalPathLength = std::max(queuedJob->m_criticalPathLength, queuedJob->m_estimatedCost + longestDependentPath); // Lazy jobs come with theirs
+
+    std::vector<Job*> jobsToVisit = { queuedJob };
+    while(!jobsToVisit.empty()){
+        Job* job = jobsToVisit.back();
+        jobsToVisit.pop_back();
+
+        for(int dependencyID: job->GetDependencies()){
+            auto dependencyIter = m_jobsQueuedByID.find(dependencyID);
+            if(dependencyIter == m_jobsQueuedByID.end()){
+                continue; // Not queued yet (it will pick us up when it is), or already claimed
+            }
+
+            Job* dependency = dependencyIter->second;
+            long long pathThroughJob = dependency->m_estimatedCost + job->m_criticalPathLength;
+            if(pathThroughJob > dependency->m_criticalPathLength){
+                dependency->m_criticalPathLength = pathThroughJob;
+                jobsToVisit.push_back(dependency);
+            }
+        }
+    }
+}
+
+int JobSystem::QueueLazyJobGraph(std::shared_ptr<LazyJobGraph> graph){
+    if(m_journal){
+        std::cout << "Error: Lazy job graphs are not journaled. Queue their jobs one by one to survive a crash." << std::endl;
+        return -1;
+    }
+    for(const std::string& jobTypeIdentifier: graph->GetJobTypes()){
+        if(!IsJobTypeRegistered(jobTypeIdentifier)){
+            std::cout << "Error: Job type with identifier: '" << jobTypeIdentifier << "' - not registered." << std::endl;
+            return -1;
+        }
+    }
+
+    int numNodes = graph->GetNumNodes();
+    if(numNodes == 0){
+        return -1;
+    }
+    int firstJobID = Job::ReserveJobIDRange(numNodes);
+    if(!graph->Seal(firstJobID)){
+        std::cout << "Error: The lazy job graph has a dependency cycle. Its jobs would wait on each other forever, nothing was queued." << std::endl;
+        return -1;
+    }
+    std::cout << "Lazy job graph: " << numNodes << " jobs (# " << firstJobID << " to # " << firstJobID + numNodes - 1 << "), "
+              << (graph->GetMemoryUsage() + 1023) / 1024 << " KB until they are created" << std::endl;
+
+    // NOTE:    Every node reads as QUEUED from now on, long before its job exists. The history grows by one
+    //          small entry per node: that is all a node costs the job system until its job is created.
+    m_jobHistoryMutex.lock();
+    GetHistoryEntry(firstJobID + numNodes - 1);
+    for(int jobID = firstJobID; jobID < firstJobID + numNodes; jobID++){
+        m_jobHistory[jobID] = JobHistoryEntry(jobID, -1, JOB_STATUS_QUEUED);
+        StoreHistoryEntry(m_jobHistory[jobID], true);
+    }
+    joblazy += numNodes;
+    m_jobHistoryMutex.unlock();
+
+    m_lazyJobGraphsMutex.lock();
+    m_lazyJobGraphs[firstJobID] = graph;
+    m_lazyJobGraphsMutex.unlock();
+
+    CreateLazyJobs(graph, graph->GetRootNodes(), false);
+    return firstJobID;
+}
+
+std::shared_ptr<LazyJobGraph> JobSystem::FindLazyJobGraph(int jobID) const{
+    std::shared_ptr<LazyJobGraph> graph;
+    m_lazyJobGraphsMutex.lock();
+    auto graphIter = m_lazyJobGraphs.upper_bound(jobID); // The first graph starting after it
+    if(graphIter != m_lazyJobGraphs.begin() && std::prev(graphIter)->second->Contains(jobID)){
+        graph = std::prev(graphIter)->second;
+    }
+    m_lazyJobGraphsMutex.unlock();
+    return graph;
+}
+
+void JobSystem::OnLazyJobDone(int jobID){
+    std::shared_ptr<LazyJobGraph> graph = FindLazyJobGraph(jobID);
+    if(!graph){
+        return;
+    }
+
+    std::vector<int> readyNodes;
+    bool isGraphDone = graph->OnNodeDone(graph->GetNode(jobID), readyNodes);
+    CreateLazyJobs(graph, std::move(readyNodes), isGraphDone);
+}
+
+// NOTE:    Every dependency of these nodes is done, so their jobs are ready the moment they are queued. A node
+//          cancelled before it got here is done right away instead, which can make more nodes ready.
+void JobSystem::CreateLazyJobs(const std::shared_ptr<LazyJobGraph>& graph, std::vector<int> readyNodes, bool isGraphDone){
+    for(size_t i = 0; i < readyNodes.size(); i++){ // Grows while we walk it
+        int node = readyNodes[i];
+        if(!graph->TryCreateNode(node)){
+            isGraphDone = graph->OnNodeDone(node, readyNodes) || isGraphDone;
+            continue;
+        }
+
+        const char* input = graph->GetInput(node);
+        Job* job = CreateJob(graph->GetJobType(node), m_internTable.InternInput(std::string_view(input, graph->GetInputSize(node))), graph->GetJobID(node));
+        m_jobHistoryMutex.lock();
+        joblazy--;
+        if(job == nullptr && m_jobHistory[graph->GetJobID(node)].m_jobStatus != JOB_STATUS_CANCELLED){
+            // The factory refused the input. Its dependents get skipped, as if it was cancelled.
+            m_jobHistory[graph->GetJobID(node)].m_jobStatus = JOB_STATUS_CANCELLED;
+            StoreHistoryEntry(m_jobHistory[graph->GetJobID(node)]);
+            jobcancelled++;
+        }
+        m_jobHistoryMutex.unlock();
+        if(job == nullptr){
+            isGraphDone = graph->OnNodeDone(node, readyNodes) || isGraphDone;
+            continue;
+        }
+
+        job->m_dependencies = graph->GetDependencyJobIDs(node);
+        if(graph->GetPriority(node) != LAZY_JOB_INPUT_PRIORITY){
+            job->m_priority = graph->GetPriority(node);
+        }
+        int conditionalJobID = -1;
+        bool runIfConditionMet = true;
+        if(graph->GetGate(node, conditionalJobID, runIfConditionMet)){
+            job->m_gateJobID = conditionalJobID;
+            job->m_runIfConditionMet = runIfConditionMet;
+        }
+        job->m_criticalPathLength = (long long)graph->GetChainLength(node) * job->m_estimatedCost; // Its dependents are not queued, QueueJob() cannot see them
+        if(!QueueLazyJob(job)){
+            delete job; // Cancelled while we were creating it
+            isGraphDone = graph->OnNodeDone(node, readyNodes) || isGraphDone;
+        }
+    }
+
+    if(isGraphDone){
+        m_lazyJobGraphsMutex.lock();
+        m_lazyJobGraphs.erase(graph->GetFirstJobID());
+        m_lazyJobGraphsMutex.unlock();
+    }
+}
+
+JobServer* JobSystem::GetJobServer(){
+    m_jobServerMutex.lock();
+    // In a "jobworker" process: join the pool of the job system that started us
+    const char* jobServerAuth = getenv("JOBSYSTEM_JOBSERVER_AUTH");
+    if(m_jobServer == nullptr && jobServerAuth != nullptr){
+        m_jobServer = JobServer::JoinFromAuth(jobServerAuth);
+    }
+    if(m_jobServer == nullptr){
+        int numHardwareThreads = (int)std::thread::hardware_concurrency();
+        m_jobServer = new JobServer(numHardwareThreads > 0 ? numHardwareThreads : 4);
+    }
+    JobServer* jobServer = m_jobServer;
+    m_jobServerMutex.unlock();
+
+    return jobServer;
+}
+
+void JobSystem::SetCompileParallelism(int numTokens){
+    GetJobServer()->SetNumTokens(numTokens);
+}
+
+FileIOService* JobSystem::GetFileIOService(){
+    m_fileIOServiceMutex.lock();
+    if(m_fileIOService == nullptr){
+        m_fileIOService = new FileIOService();
+    }
+    FileIOService* fileIOService = m_fileIOService;
+    m_fileIOServiceMutex.unlock();
+
+    return fileIOService;
+}
+
+JobReactor* JobSystem::GetJobReactor(){
+    m_jobReactorMutex.lock();
+    if(m_jobReactor == nullptr){
+        m_jobReactor = new JobReactor(this);
+    }
+    JobReactor* jobReactor = m_jobReactor;
+    m_jobReactorMutex.unlock();
+
+    return jobReactor;
+}
+
+BuildManifest* JobSystem::GetBuildManifest(){
+    m_buildManifestMutex.lock();
+    if(m_buildManifest == nullptr){
+        std::error_code errorCode;
+        std::filesystem::create_directories("./Data/", errorCode);
+        m_buildManifest = new BuildManifest("./Data/build_manifest.json");
+    }
+    BuildManifest* buildManifest = m_buildManifest;
+    m_buildManifestMutex.unlock();
+
+    return buildManifest;
+}
+
+void JobSystem::SetSchedulingMode(JobSchedulingMode schedulingMode){
+    m_jobsQueuedMutex.lock();
+    m_schedulingMode = schedulingMode;
+    m_jobsQueuedMutex.unlock();
+}
+
+JobSchedulingMode JobSystem::GetSchedulingMode() const{
+    m_jobsQueuedMutex.lock();
+    JobSchedulingMode schedulingMode = m_schedulingMode;
+    m_jobsQueuedMutex.unlock();
+
+    return schedulingMode;
+}
+
+bool JobSystem::EnableJournal(const std::string& journalPath){
+    if(m_journal != nullptr){
+        std::cout << "Error: The job journal is already enabled: " << m_journal->GetPath() << std::endl;
+        return false;
+    }
+
+    JobJournal* journal = new JobJournal(journalPath);
+    if(!journal->IsValid()){
+        delete journal;
+        return false;
+    }
+
+    m_journal = journal;
+    return true;
+}
+
+// NOTE:    Replaying keeps the furthest status each job reached. Jobs that completed come back
+//          RETIRED, with their output, so their dependents can read it. The others (queued, or
+//          running when we crashed) are created again from their type and input, under the SAME
+//          ID, and re-queued. Before journaling resumes, the journal is rewritten with only what
+//          is still needed, so it does not grow forever across restarts.
+int JobSystem::RecoverFromJournal(const std::string& journalPath){
+    std::error_code errorCode;
+    if(!std::filesystem::exists(journalPath, errorCode)){
+        EnableJournal(journalPath);
+        return -1;
+    }
+
+    struct RecoveredJob
+    {
+        json m_queuedRecord;
+        int m_jobStatus = JOB_STATUS_NEVER_SEEN;
+        json m_jobOutput;
+    };
+    std::map<int, RecoveredJob> recoveredJobs;
+
+    for(const json& record: JobJournal::ReadRecords(journalPath)){
+        int jobID = record.value("id", -1);
+        std::string recordType = record.value("record", "");
+        if(jobID < 0){
+            continue;
+        }
+
+        RecoveredJob& recoveredJob = recoveredJobs[jobID];
+        if(recordType == "queued"){
+            recoveredJob.m_queuedRecord = record;
+            recoveredJob.m_jobStatus = std::max(recoveredJob.m_jobStatus, (int)JOB_STATUS_QUEUED);
+        } else if(recordType == "running"){
+            recoveredJob.m_jobStatus = std::max(recoveredJob.m_jobStatus, (int)JOB_STATUS_RUNNING);
+        } else if(recordType == "completed"){
+            recoveredJob.m_jobStatus = std::max(recoveredJob.m_jobStatus, (int)JOB_STATUS_COMPLETED);
+            recoveredJob.m_jobOutput = record.value("output", json{});
+        } else if(recordType == "retired"){
+            recoveredJob.m_jobStatus = std::max(recoveredJob.m_jobStatus, (int)JOB_STATUS_RETIRED);
+        } else if(recordType == "skipped"){
+            recoveredJob.m_jobStatus = JOB_STATUS_SKIPPED;
+        } else if(recordType == "cancelled"){
+            recoveredJob.m_jobStatus = JOB_STATUS_CANCELLED;
+        }
+    }
+
+    // Compact: one "queued" record per job, plus a "completed" one for the jobs that are done
+    std::string compactedPath = journalPath + ".tmp";
+    std::ofstream compactedFile(compactedPath, std::ios::trunc);
+    int numRecoveredJobs = 0;
+    for(const auto& entry: recoveredJobs){
+        const RecoveredJob& recoveredJob = entry.second;
+        if(recoveredJob.m_queuedRecord.is_null()){
+            continue; // Lost with the torn tail
+        }
+
+        numRecoveredJobs++;
+        if(recoveredJob.m_jobStatus == JOB_STATUS_SKIPPED || recoveredJob.m_jobStatus == JOB_STATUS_CANCELLED){
+            compactedFile << recoveredJob.m_queuedRecord.dump() << "\n";
+            compactedFile << json{ {"record", recoveredJob.m_jobStatus == JOB_STATUS_SKIPPED ? "skipped" : "cancelled"}, {"id", entry.first} }.dump() << "\n";
+        } else if(recoveredJob.m_jobStatus >= JOB_STATUS_COMPLETED){
+            compactedFile << recoveredJob.m_queuedRecord.dump() << "\n";
+            compactedFile << json{ {"record", "completed"}, {"id", entry.first}, {"output", recoveredJob.m_jobOutput} }.dump() << "\n";
+        }
+    }
+    compactedFile.close();
+    std::filesystem::rename(compactedPath, journalPath, errorCode);
+    if(errorCode){
+        std::cout << "Error: Unable to compact the job journal: " << journalPath << std::endl;
+        return -1;
+    }
+
+    EnableJournal(journalPath);
+
+    if(!recoveredJobs.empty()){
+        Job::ReserveJobIDs(recoveredJobs.rbegin()->first + 1);
+    }
+
+    // The completed (and skipped, and cancelled) jobs first, so the re-queued ones find their dependencies satisfied right away
+    m_jobHistoryMutex.lock();
+    for(const auto& entry: recoveredJobs){
+        const RecoveredJob& recoveredJob = entry.second;
+        if(recoveredJob.m_queuedRecord.is_null() || recoveredJob.m_jobStatus < JOB_STATUS_COMPLETED){
+            continue;
+        }
+
+        int jobType = recoveredJob.m_queuedRecord["input"].value("jobType", -1);
+        JobHistoryEntry& historyEntry = GetHistoryEntry(entry.first);
+        if(recoveredJob.m_jobStatus == JOB_STATUS_SKIPPED || recoveredJob.m_jobStatus == JOB_STATUS_CANCELLED){
+            historyEntry = JobHistoryEntry(entry.first, jobType, (JobStatus)recoveredJob.m_jobStatus);
+            StoreHistoryEntry(historyEntry, true);
+            if(recoveredJob.m_jobStatus == JOB_STATUS_SKIPPED){
+                jobskipped++;
+            } else {
+                jobcancelled++;
+            }
+            continue;
+        }
+        historyEntry = JobHistoryEntry(entry.first, jobType, JOB_STATUS_RETIRED);
+        historyEntry.m_jobResult = jobResultFromOutput(recoveredJob.m_jobOutput); // The journal only has the output
+        m_jobResults.Set(entry.first, historyEntry.m_jobResult);
+        if(m_historyStore){
+            m_historyStore->WriteOutput(entry.first, recoveredJob.m_jobOutput);
+        } else {
+            historyEntry.m_jobOutput = std::make_shared<const json>(recoveredJob.m_jobOutput);
+        }
+        StoreHistoryEntry(historyEntry);
+        jobretired++;
+    }
+    m_jobHistoryMutex.unlock();
+
+    for(const auto& entry: recoveredJobs){
+        const RecoveredJob& recoveredJob = entry.second;
+        if(recoveredJob.m_queuedRecord.is_null() || recoveredJob.m_jobStatus >= JOB_STATUS_COMPLETED){
+            continue;
+        }
+
+        const json& queuedRecord = recoveredJob.m_queuedRecord;
+        Job* job = CreateJob(queuedRecord.value("jobTypeIdentifier", ""), queuedRecord["input"]);
+        if(job == nullptr){
+            std::cout << "Error: Unable to recover job # " << entry.first << " from the journal" << std::endl;
+            continue;
+        }
+
+        job->m_jobID = entry.first;
+        job->SetPriority(queuedRecord.value("priority", 0));
+        for(int dependencyID: queuedRecord.value("dependencies", std::vector<int>())){
+            job->AddDependency(dependencyID);
+        }
+        if(queuedRecord.contains("gate")){
+            job->SetGate(queuedRecord["gate"].get<int>(), queuedRecord.value("runIfConditionMet", true));
+        }
+        if(queuedRecord.contains("timeoutMs")){
+            job->SetTimeout(queuedRecord["timeoutMs"].get<int>());
+            job->SetRetries(queuedRecord.value("maxRetries", 0), queuedRecord.value("retryBackoffMs", 100));
+        }
+        QueueJob(job);
+    }
+
+    return numRecoveredJobs;
+}
+
+bool JobSystem::EnableSubmissionRing(const std::string& ringName, uint64_t capacity){
+    JobRing* ring = JobRing::Create(ringName, capacity);
+    if(ring == nullptr){
+        return false;
+    }
 
-    // First, tell each work thread worker to stop picking up jobs
-    for(int i = 0; i < numWorkerThreads; i++){
-        m_workerThreads[i]->ShutDown();
+    m_ringServersMutex.lock();
+    m_ringServers.push_back(new JobRingServer(this, ring));
+    m_ringServersMutex.unlock();
+    return true;
+}
+
+bool JobSystem::EnableHistoryStore(const std::string& folderPath){
+    if(m_historyStore != nullptr){
+        std::cout << "Error: The job history store is already enabled" << std::endl;
+        return false;
     }
 
-    while( !m_workerThreads.empty() ){ // As long as the vector is not empty
-        delete m_workerThreads.back(); // Deallocate the last worker thread in the vector
-        m_workerThreads.pop_back(); // Decrease the vector. If the above step was not, performed... memory leak.
+    JobHistoryStore* historyStore = new JobHistoryStore(folderPath);
+    if(!historyStore->IsValid()){
+        delete historyStore;
+        return false;
     }
-    m_workerThreadsMutex.unlock();
+
+    // The IDs in the store belong to previous runs now
+    Job::ReserveJobIDs(historyStore->GetNumRecords());
+    m_historyStore = historyStore;
+    return true;
 }
 
-JobSystem* JobSystem::CreateOrGet(){
-    if( !s_jobSystem ){
-        s_jobSystem = new JobSystem();
+int JobSystem::RecordReusedJob(int jobType, JobResult jobResult, const json& jobOutput){
+    int jobID = Job::ReserveJobIDRange(1);
+
+    m_jobHistoryMutex.lock();
+    JobHistoryEntry& historyEntry = GetHistoryEntry(jobID);
+    historyEntry = JobHistoryEntry(jobID, jobType, JOB_STATUS_RETIRED);
+    historyEntry.m_jobResult = jobResult;
+    m_jobResults.Set(jobID, jobResult);
+    if(m_historyStore){
+        m_historyStore->WriteOutput(jobID, jobOutput);
+    } else {
+        historyEntry.m_jobOutput = std::make_shared<const json>(jobOutput);
     }
+    StoreHistoryEntry(historyEntry);
+    jobreused++;
+    m_jobHistoryMutex.unlock();
 
-    return s_jobSystem;
+    return jobID;
 }
 
-void JobSystem::Destroy(){
-    if(s_jobSystem){
-        delete s_jobSystem;
-        s_jobSystem = nullptr;
+void JobSystem::SyncJournal(){
+    if(m_journal){
+        m_journal->Sync();
     }
 }
 
-void JobSystem::CreateWorkerThread(const char* uniqueName, unsigned long workerJobChannels){
-    JobWorkerThread* newWorker = new JobWorkerThread( uniqueName, workerJobChannels, this);
+JobStatus JobSystem::GetJobStatus(int jobID) const{
+    m_jobHistoryMutex.lock();
 
-    m_workerThreadsMutex.lock();
-    m_workerThreads.push_back(newWorker);
-    m_workerThreadsMutex.unlock();
+    JobStatus jobStatus = JOB_STATUS_NEVER_SEEN;
+    if (jobID >= 0 && jobID < (int) m_jobHistory.size()){
+        jobStatus = (JobStatus)(m_jobHistory[jobID].m_jobStatus);
+    }
+
+    m_jobHistoryMutex.unlock();
+    return jobStatus;
+}
 
-    m_workerThreads.back()->StartUp();
+bool JobSystem::isJobComplete(int jobID) const{
+    return (GetJobStatus(jobID)) == (JOB_STATUS_COMPLETED);
 }
 
-void JobSystem::DestroyWorkerThread(const char* uniqueName){
-    m_workerThreadsMutex.lock();
-    JobWorkerThread* doomedWorker = nullptr;
-    std::vector<JobWorkerThread*>::iterator it = m_workerThreads.begin();
+JobResult JobSystem::GetJobResult(int jobID) const{
+    return m_jobResults.Get(jobID);
+}
 
-    for(; it != m_workerThreads.end(); ++it){
-        if (strcmp( (*it)->m_uniqueName, uniqueName) == 0){
-            doomedWorker = *it;
-            m_workerThreads.erase(it);
-            break;
+// NOTE:    Dependents used to wait for a COMPLETED dependency only. If the user finished (retired)
+//          it before they got claimed, they waited forever. Jobs recovered from a journal are retired too.
+//          A skipped (or cancelled) dependency does not hold its dependents back either: they get skipped (see IsJobSkipped).
+bool JobSystem::IsDependencySatisfied(int jobID) const{
+    JobStatus jobStatus = GetJobStatus(jobID);
+    return jobStatus == JOB_STATUS_COMPLETED || jobStatus == JOB_STATUS_RETIRED || jobStatus == JOB_STATUS_SKIPPED || jobStatus == JOB_STATUS_CANCELLED;
+}
+
+// NOTE:    The conditional job only decides. Its output says whether the condition was met, and both of
+//          its branches were queued with it, gated on it. Nothing is created or parsed when it decides.
+bool JobSystem::IsJobSkipped(const Job* job) const{
+    for(int dependencyId: job->GetDependencies()){
+        JobStatus dependencyStatus = GetJobStatus(dependencyId);
+        if(dependencyStatus == JOB_STATUS_SKIPPED || dependencyStatus == JOB_STATUS_CANCELLED){
+            return true;
         }
     }
 
-    m_workerThreadsMutex.unlock();
-
-    if(doomedWorker){
-        doomedWorker->ShutDown();
-        delete doomedWorker;
+    JobStatus gateStatus = (job->m_gateJobID >= 0) ? GetJobStatus(job->m_gateJobID) : JOB_STATUS_NEVER_SEEN;
+    if(gateStatus != JOB_STATUS_COMPLETED && gateStatus != JOB_STATUS_RETIRED){
+        return false; // Not gated, or not decided yet
     }
+
+    std::shared_ptr<const json> gateOutput = GetJobOutputByID(job->m_gateJobID);
+    bool conditionMet = gateOutput && gateOutput->is_object() && gateOutput->value("conditionMet", false);
+    return conditionMet != job->m_runIfConditionMet;
 }
 
-void JobSystem::QueueJob(Job* job){
+// NOTE:    Only the jobs waiting on the conditional job can be gated on it, so we start from them rather than
+//          sweeping the whole queue. Everything still queued downstream of a job skipped here is skipped with it.
+void JobSystem::SkipJobsNotTaken(const std::vector<int>& gatedJobIDs){
+    std::vector<Job*> skippedJobs;
+
     m_jobsQueuedMutex.lock();
+    for(int gatedJobID: gatedJobIDs){
+        auto gatedIter = m_jobsQueuedByID.find(gatedJobID);
+        if(gatedIter == m_jobsQueuedByID.end() || gatedIter->second->m_isCancelled || !IsJobSkipped(gatedIter->second)){
+            continue; // Claimed or cancelled already, or on the branch that was taken
+        }
 
-    m_jobHistoryMutex.lock();
-    m_jobHistory.emplace_back(JobHistoryEntry(job->GetUniqueID(), job->m_jobType, JOB_STATUS_QUEUED));
-    //increase job queued
-    jobqueued++;
-    
-    m_jobHistoryMutex.unlock();
+        std::vector<int> jobsToVisit = { gatedJobID };
+        while(!jobsToVisit.empty()){
+            int visitedID = jobsToVisit.back();
+            jobsToVisit.pop_back();
 
-    m_jobsQueued.push_back(job);
+            auto queuedIter = m_jobsQueuedByID.find(visitedID);
+            if(queuedIter == m_jobsQueuedByID.end() || queuedIter->second->m_isCancelled){
+                continue; // Skipped already (reached twice), claimed, or cancelled
+            }
+            skippedJobs.push_back(queuedIter->second);
+            m_jobsQueuedByID.erase(queuedIter);
+
+            auto dependentsIter = m_queuedDependents.find(visitedID);
+            if(dependentsIter != m_queuedDependents.end()){
+                jobsToVisit.insert(jobsToVisit.end(), dependentsIter->second.begin(), dependentsIter->second.end());
+            }
+        }
+    }
+    SkipQueuedJobs(skippedJobs);
     m_jobsQueuedMutex.unlock();
+
+    RetireSkippedJobs(skippedJobs);
 }
 
-JobStatus JobSystem::GetJobStatus(int jobID) const{
-    m_jobHistoryMutex.lock();
+void JobSystem::SkipQueuedJobs(const std::vector<Job*>& jobsToSkip){
+    if(jobsToSkip.empty()){
+        return;
+    }
 
-    JobStatus jobStatus = JOB_STATUS_NEVER_SEEN;
-    if (jobID < (int) m_jobHistory.size()){
-        jobStatus = (JobStatus)(m_jobHistory[jobID].m_jobStatus);
+    for(Job* job: jobsToSkip){
+        m_jobsQueuedByID.erase(job->m_jobID);
+        m_queuedDependents.erase(job->m_jobID);
+
+        m_jobHistoryMutex.lock();
+        m_jobHistory[job->m_jobID].m_jobStatus = JOB_STATUS_SKIPPED;
+        StoreHistoryEntry(m_jobHistory[job->m_jobID]);
+        // decrease "jobqueued", increase "jobskipped"
+        jobqueued--;
+        jobskipped++;
+        m_jobHistoryMutex.unlock();
     }
 
-    m_jobHistoryMutex.unlock();
-    return jobStatus;
+    // One pass over the queue, however many jobs were skipped
+    std::set<const Job*> skippedJobs(jobsToSkip.begin(), jobsToSkip.end());
+    m_jobsQueued.erase(std::remove_if(m_jobsQueued.begin(), m_jobsQueued.end(), [&skippedJobs](const Job* job){ return skippedJobs.count(job) > 0; }), m_jobsQueued.end());
 }
 
-bool JobSystem::isJobComplete(int jobID) const{
-    return (GetJobStatus(jobID)) == (JOB_STATUS_COMPLETED);
+void JobSystem::RetireSkippedJobs(const std::vector<Job*>& skippedJobs){
+    m_jobReactorMutex.lock();
+    JobReactor* jobReactor = m_jobReactor;
+    m_jobReactorMutex.unlock();
+
+    for(Job* job: skippedJobs){
+        int jobID = job->m_jobID;
+        if(m_journal && !job->m_isTransient){
+            m_journal->Append({ {"record", "skipped"}, {"id", jobID} });
+        }
+        if(jobReactor){
+            jobReactor->OnJobCompleted(jobID); // Async jobs waiting on it can resume, and find it skipped
+        }
+        delete job; // Never ran, so there is nothing to finish
+        OnLazyJobDone(jobID); // The jobs depending on it get created, and skipped in turn
+    }
+}
+
+JobHistoryEntry& JobSystem::GetHistoryEntry(int jobID){
+    // Jobs are not always queued in the order they were created. Keep "m_jobHistory[jobID]" valid anyway.
+    while((int)m_jobHistory.size() <= jobID){
+        int placeholderID = (int)m_jobHistory.size();
+        m_jobHistory.emplace_back(JobHistoryEntry(placeholderID, -1, JOB_STATUS_NEVER_SEEN));
+    }
+    return m_jobHistory[jobID];
+}
+
+void JobSystem::StoreHistoryEntry(const JobHistoryEntry& entry, bool clearOutput){
+    if(m_historyStore){
+        m_historyStore->WriteRecord(entry.m_jobID, entry.m_jobType, entry.m_jobStatus, entry.m_numaNode, clearOutput);
+    }
+}
+
+JobStatus JobSystem::WaitForJob(int jobID) const{
+    JobStatus jobStatus = GetJobStatus(jobID);
+    while(jobStatus == JOB_STATUS_QUEUED || jobStatus == JOB_STATUS_RUNNING){
+        std::this_thread::sleep_for( std::chrono::milliseconds(1) ); // Unlike FinishJob, don't burn a core while waiting
+        jobStatus = GetJobStatus(jobID);
+    }
+    return jobStatus;
 }
 
 // NOTE:    The content of "m_jobsCompleted" is copied into the
@@ -131,17 +1275,14 @@ void JobSystem::FinishCompletedJobs(){
     m_jobsCompletedMutex.unlock();
 
     for(Job* job: jobsCompleted){
-        job->JobCompleteCallback();
-        m_jobHistoryMutex.lock();
-        m_jobHistory[job->m_jobID].m_jobStatus = JOB_STATUS_RETIRED; 
-        // increase "jobretired" and decrease "jobcompleted"
-        jobretired++;
-        jobcompleted--;
-        
-        m_jobHistoryMutex.unlock();
-        delete job;
+        RetireCompletedJob(job);
     }
 
+    // NOTE:    Their callbacks (JobCompleteCallback) do not write their output files, they only hand them to the
+    //          I/O service (WriteFile). Written together, in one batch, and on disk by the time we return.
+    if(!jobsCompleted.empty()){
+        GetFileIOService()->Flush();
+    }
 }
 
 void JobSystem::FinishJob(int jobID){
@@ -159,38 +1300,114 @@ void JobSystem::FinishJob(int jobID){
             std::cout << "Error: Waiting for job (# " << jobID << ") - no such job in JobSystem" << std::endl;
             return; 
         }
+        if(jobStatus == JOB_STATUS_SKIPPED || jobStatus == JOB_STATUS_CANCELLED){
+            std::cout << "Job # " << jobID << " was " << (jobStatus == JOB_STATUS_SKIPPED ? "skipped" : "cancelled") << ": it never ran, there is nothing to finish" << std::endl;
+            return;
+        }
+    }
+
+    // NOTE: Someone else (FinishCompletedJobs, a job ring, a daemon client) may have finished it since we looked
+    Job* thisCompletedJob = TakeCompletedJob(jobID);
+    if(thisCompletedJob == nullptr){
+        std::cout << "ERROR: Job # " << jobID << " was status completed but not found" << std::endl;
+        return;
+    }
+
+    RetireCompletedJob(thisCompletedJob);
+    GetFileIOService()->Flush(); // Its output file is on disk by the time we return
+}
+
+bool JobSystem::FinishJobIfCompleted(int jobID){
+    Job* completedJob = TakeCompletedJob(jobID);
+    if(completedJob == nullptr){
+        return false;
     }
 
+    RetireCompletedJob(completedJob);
+    GetFileIOService()->Flush();
+    return true;
+}
+
+Job* JobSystem::TakeCompletedJob(int jobID){
+    Job* completedJob = nullptr;
     m_jobsCompletedMutex.lock();
-    Job* thisCompletedJob = nullptr;
     for(auto jcIter = m_jobsCompleted.begin(); jcIter != m_jobsCompleted.end(); ++jcIter){
-        Job* someCompletedJob = *jcIter;
-        if(someCompletedJob->m_jobID == jobID){
-            thisCompletedJob = someCompletedJob;
+        if((*jcIter)->m_jobID == jobID){
+            completedJob = *jcIter;
             m_jobsCompleted.erase(jcIter);
             break;
         }
     }
     m_jobsCompletedMutex.unlock();
+    return completedJob;
+}
 
-    if(thisCompletedJob == nullptr){
-        std::cout << "ERROR: Job # " << jobID << " was status completed but not found" << std::endl;
-    }
-
-    thisCompletedJob->JobCompleteCallback();
+void JobSystem::RetireCompletedJob(Job* completedJob){
+    completedJob->JobCompleteCallback();
 
     m_jobHistoryMutex.lock();
-    m_jobHistory[thisCompletedJob->m_jobID].m_jobStatus = JOB_STATUS_RETIRED;
+    m_jobHistory[completedJob->m_jobID].m_jobStatus = JOB_STATUS_RETIRED;
+    StoreHistoryEntry(m_jobHistory[completedJob->m_jobID]);
     // increase "jobretired", decrease "jobcompleted"
     jobretired++;
     jobcompleted--;
-
     m_jobHistoryMutex.unlock();
 
-    delete thisCompletedJob;
+    if(m_journal && !completedJob->m_isTransient){
+        m_journal->Append({ {"record", "retired"}, {"id", completedJob->m_jobID} });
+    }
+
+    delete completedJob;
 }
 
 void JobSystem::OnJobCompleted(Job* jobJustExecuted){
+    // Read everything we need from the job now. Once it is in "m_jobsCompleted", it can be finished (deleted) at any time.
+    int jobID = jobJustExecuted->m_jobID;
+    bool isJournaled = (m_journal != nullptr && !jobJustExecuted->m_isTransient);
+    std::shared_ptr<const json> jobOutput = jobJustExecuted->GetOutputJson();
+    if(!jobOutput){
+        jobOutput = std::make_shared<const json>(); // The job never set one (conditional jobs, for instance)
+    }
+    JobResult jobResult = jobJustExecuted->GetResult();
+    if(jobResult == JOB_RESULT_NONE){
+        jobResult = jobResultFromOutput(*jobOutput); // Jobs that only say it in their output
+    }
+
+    // Timed out or cancelled: whatever it produced, it failed. Its output says why.
+    if(jobJustExecuted->IsInterrupted()){
+        json interruptedOutput = jobOutput->is_object() ? *jobOutput : json::object();
+        interruptedOutput["status"] = "failure";
+        if(jobJustExecuted->IsCancelled()){
+            interruptedOutput["cancelled"] = true;
+            interruptedOutput["error"] = "Cancelled";
+        } else {
+            interruptedOutput["timedOut"] = true;
+            interruptedOutput["error"] = "Timed out after " + std::to_string(jobJustExecuted->m_timeoutMs) + " ms";
+        }
+        jobOutput = std::make_shared<const json>(std::move(interruptedOutput));
+        jobResult = JOB_RESULT_FAILURE;
+    }
+
+    // NOTE: A failed attempt with retries left is not completed: it is queued again. Dependents keep waiting.
+    bool canRetry = !jobJustExecuted->IsCancelled() && jobJustExecuted->m_numFailedAttempts < jobJustExecuted->m_maxRetries;
+    if(jobResult == JOB_RESULT_FAILURE && canRetry && RetryJob(jobJustExecuted)){
+        return;
+    }
+
+    // NOTE: Before it is marked COMPLETED too. Whoever sees it completed can read its result without the history lock.
+    m_jobResults.Set(jobID, jobResult);
+
+    // Written before the job is marked COMPLETED, so its dependents always find it
+    if(m_historyStore){
+        m_historyStore->WriteOutput(jobID, *jobOutput);
+    }
+
+    // NOTE:    Journaled before it goes into "m_jobsCompleted": from there, it can be finished right away, and
+    //          its "retired" record must not beat this one (recovery would restore it retired, without output)
+    if(isJournaled){
+        m_journal->Append({ {"record", "completed"}, {"id", jobID}, {"output", *jobOutput} });
+    }
+
     totalJobs++;
     m_jobsCompletedMutex.lock();
     m_jobsRunningMutex.lock();
@@ -202,8 +1419,12 @@ void JobSystem::OnJobCompleted(Job* jobJustExecuted){
             m_jobsRunning.erase(runningJobItr);
             m_jobsCompleted.push_back(jobJustExecuted);
             m_jobHistory[jobJustExecuted->m_jobID].m_jobStatus = JOB_STATUS_COMPLETED;
-            // Save the ouptut of the job in the job history as well
-            m_jobHistory[jobJustExecuted->m_jobID].m_jobOutput = jobJustExecuted->GetOutputJson();
+            m_jobHistory[jobJustExecuted->m_jobID].m_jobResult = jobResult;
+            // Save the ouptut of the job in the job history as well. Unless the history store already has it.
+            if(!m_historyStore){
+                m_jobHistory[jobJustExecuted->m_jobID].m_jobOutput = jobOutput;
+            }
+            StoreHistoryEntry(m_jobHistory[jobJustExecuted->m_jobID]);
             //decrease "jobrunning" and increase "jobcompleted"
             jobrunning--;
             jobcompleted++;
@@ -211,53 +1432,368 @@ void JobSystem::OnJobCompleted(Job* jobJustExecuted){
             break;
         }
     }
+
+    // NOTE:    A make killed before it could give its jobserver tokens back took them with it. Once nothing
+    //          runs, nothing holds a token either: whatever is missing from the pool then is lost, put it back.
+    //          (Claiming a job takes "m_jobsRunningMutex", so nothing starts meanwhile.)
+    if(jobJustExecuted->IsInterrupted()){
+        m_mayHaveLostJobServerTokens = true;
+    }
+    if(m_jobsRunning.empty() && m_mayHaveLostJobServerTokens){
+        m_mayHaveLostJobServerTokens = false;
+        m_jobServerMutex.lock();
+        JobServer* jobServer = m_jobServer;
+        m_jobServerMutex.unlock();
+        int numRefilledTokens = jobServer ? jobServer->RefillTokens() : 0;
+        if(numRefilledTokens > 0){
+            std::cout << numRefilledTokens << " jobserver token(s) lost with interrupted compile jobs were put back" << std::endl;
+        }
+    }
     m_jobsRunningMutex.unlock();
     m_jobsCompletedMutex.unlock();
+
+    // Nothing to cancel downstream of it anymore
+    std::vector<int> dependentIDs;
+    m_jobsQueuedMutex.lock();
+    auto dependentsIter = m_queuedDependents.find(jobID);
+    if(dependentsIter != m_queuedDependents.end()){
+        dependentIDs = std::move(dependentsIter->second);
+        m_queuedDependents.erase(dependentsIter);
+    }
+    m_jobsQueuedMutex.unlock();
+
+    // Async jobs waiting on this one can resume
+    m_jobReactorMutex.lock();
+    JobReactor* jobReactor = m_jobReactor;
+    m_jobReactorMutex.unlock();
+    if(jobReactor){
+        jobReactor->OnJobCompleted(jobID);
+    }
+
+    // A conditional job decided: the branch it did not take is skipped now, rather than when a worker stumbles on it
+    if(jobOutput->is_object() && jobOutput->contains("conditionMet")){
+        SkipJobsNotTaken(dependentIDs);
+    }
+
+    // NOTE:    Jobs of a lazy graph do not wait in "m_jobsCompleted" to be finished: they would pile up there,
+    //          and the whole point is to only keep the jobs that can run. Their output stays in the history.
+    if(FindLazyJobGraph(jobID)){
+        m_jobsCompletedMutex.lock();
+        auto completedIter = std::find(m_jobsCompleted.rbegin(), m_jobsCompleted.rend(), jobJustExecuted);
+        bool isStillCompleted = (completedIter != m_jobsCompleted.rend());
+        if(isStillCompleted){
+            m_jobsCompleted.erase(std::next(completedIter).base());
+        }
+        m_jobsCompletedMutex.unlock();
+
+        if(isStillCompleted){ // Unless someone finished it already
+            RetireCompletedJob(jobJustExecuted);
+        }
+        OnLazyJobDone(jobID);
+    }
+}
+
+void JobSystem::SuspendJob(Job* jobJustExecuted){
+    JobReactor* jobReactor = GetJobReactor();
+    if(jobReactor->IsValid()){
+        jobReactor->Suspend(jobJustExecuted);
+        return;
+    }
+
+    // No epoll? Then the job blocks its worker, as if it was not async at all
+    JobReactor::ResumeInline(jobJustExecuted, this);
+    OnJobCompleted(jobJustExecuted);
+}
+
+// NOTE:    Jobs keep state once they ran (a compile job appends to its output), so the next attempt is a
+//          fresh job, created again like after a crash, under the same ID. It is "QUEUED" while it waits.
+bool JobSystem::RetryJob(Job* failedJob){
+    Job* retryJob = failedJob->m_jobTypeIdentifier.empty() ? nullptr : CreateJob(failedJob->m_jobTypeIdentifier, failedJob->m_input, failedJob->m_jobID);
+    if(retryJob == nullptr){
+        return false; // Created directly in C++: there is nothing to create it again from
+    }
+
+    retryJob->m_dependencies = failedJob->m_dependencies;
+    retryJob->m_priority = failedJob->m_priority;
+    retryJob->m_isTransient = failedJob->m_isTransient;
+    retryJob->m_gateJobID = failedJob->m_gateJobID;
+    retryJob->m_runIfConditionMet = failedJob->m_runIfConditionMet;
+    retryJob->m_timeoutMs = failedJob->m_timeoutMs;
+    retryJob->m_maxRetries = failedJob->m_maxRetries;
+    retryJob->m_retryBackoffMs = failedJob->m_retryBackoffMs;
+    retryJob->m_numFailedAttempts = failedJob->m_numFailedAttempts + 1;
+
+    m_jobsRunningMutex.lock();
+    m_jobsRunning.erase(std::find(m_jobsRunning.begin(), m_jobsRunning.end(), failedJob));
+    m_jobHistoryMutex.lock();
+    m_jobHistory[failedJob->m_jobID].m_jobStatus = JOB_STATUS_QUEUED;
+    StoreHistoryEntry(m_jobHistory[failedJob->m_jobID], true);
+    // decrease "jobrunning", increase "jobretried". QueueJob() counts it as queued again.
+    jobrunning--;
+    jobretried++;
+    m_jobHistoryMutex.unlock();
+    m_jobsRunningMutex.unlock();
+
+    long long backoffMs = (long long)failedJob->m_retryBackoffMs << std::min(failedJob->m_numFailedAttempts, 20);
+    backoffMs = std::min(backoffMs, 60000LL);
+    std::cout << "Job # " << failedJob->m_jobID << " failed, retrying in " << backoffMs << " ms (retry " << retryJob->m_numFailedAttempts << " of " << retryJob->m_maxRetries << ")" << std::endl;
+
+    m_watchdogMutex.lock();
+    m_jobsAwaitingRetry.insert({ std::chrono::steady_clock::now() + std::chrono::milliseconds(backoffMs), retryJob });
+    m_watchdogMutex.unlock();
+    m_watchdogSignal.notify_one();
+
+    delete failedJob;
+    return true;
+}
+
+int JobSystem::CancelJob(int jobID, bool recursive){
+    // NOTE:    Journaled (and the jobs waiting on them resumed) once the locks are released. By IDs: a worker
+    //          may delete a cancelled job as soon as we release the queue, when it drops it from there.
+    std::vector< std::pair<int, bool> > cancelledJobs; // ID, is it journaled?
+    std::vector<Job*> jobsToDelete; // Those that were waiting for a retry. The queued ones are dropped by the next claim.
+    std::vector<int> lazyJobsDone; // Created jobs of lazy graphs: the jobs depending on them can be created now
+    int numInterruptedJobs = 0;
+
+    m_jobsQueuedMutex.lock();
+    m_jobsRunningMutex.lock();
+    m_watchdogMutex.lock();
+
+    std::vector<int> jobsToVisit = { jobID };
+    while(!jobsToVisit.empty()){
+        int visitedID = jobsToVisit.back();
+        jobsToVisit.pop_back();
+
+        std::shared_ptr<LazyJobGraph> lazyJobGraph = FindLazyJobGraph(visitedID);
+        Job* job = nullptr;
+        auto queuedIter = m_jobsQueuedByID.find(visitedID);
+        if(queuedIter != m_jobsQueuedByID.end()){
+            job = queuedIter->second;
+            m_jobsQueuedByID.erase(queuedIter);
+
+            m_jobHistoryMutex.lock();
+            jobqueued--;
+            m_jobHistoryMutex.unlock();
+        } else {
+            auto retryIter = std::find_if(m_jobsAwaitingRetry.begin(), m_jobsAwaitingRetry.end(), [visitedID](const auto& entry){ return entry.second->m_jobID == visitedID; });
+            if(retryIter != m_jobsAwaitingRetry.end()){
+                job = retryIter->second;
+                m_jobsAwaitingRetry.erase(retryIter);
+                jobsToDelete.push_back(job);
+            }
+        }
+
+        if(job){
+            job->m_isCancelled = true;
+            cancelledJobs.push_back({ visitedID, m_journal && !job->m_isTransient });
+            if(lazyJobGraph){
+                lazyJobsDone.push_back(visitedID);
+            }
+
+            m_jobHistoryMutex.lock();
+            m_jobHistory[visitedID].m_jobStatus = JOB_STATUS_CANCELLED;
+            StoreHistoryEntry(m_jobHistory[visitedID]);
+            jobcancelled++;
+            m_jobHistoryMutex.unlock();
+        } else if(lazyJobGraph && lazyJobGraph->TryCancelNode(lazyJobGraph->GetNode(visitedID))){
+            // Its job was not created yet, and now never will be. Done once its own dependencies are (see CreateLazyJobs).
+            cancelledJobs.push_back({ visitedID, false });
+
+            m_jobHistoryMutex.lock();
+            m_jobHistory[visitedID].m_jobStatus = JOB_STATUS_CANCELLED;
+            StoreHistoryEntry(m_jobHistory[visitedID]);
+            joblazy--;
+            jobcancelled++;
+            m_jobHistoryMutex.unlock();
+        } else if(lazyJobGraph && lazyJobGraph->IsNodeCreated(lazyJobGraph->GetNode(visitedID)) && GetJobStatus(visitedID) == JOB_STATUS_QUEUED){
+            // NOTE:    Its job is being created (see CreateLazyJobs): claimed, but not queued yet. Marked cancelled now,
+            //          under the queue lock, it never will be. CreateLazyJobs() drops it, and its node is done then.
+            cancelledJobs.push_back({ visitedID, false });
+
+            m_jobHistoryMutex.lock();
+            m_jobHistory[visitedID].m_jobStatus = JOB_STATUS_CANCELLED;
+            StoreHistoryEntry(m_jobHistory[visitedID]);
+            jobcancelled++;
+            m_jobHistoryMutex.unlock();
+        } else {
+            // Running: it completes, as a failure, once its child process is gone. Anything else is done already.
+            auto runningIter = std::find_if(m_jobsRunning.begin(), m_jobsRunning.end(), [visitedID](const Job* runningJob){ return runningJob->m_jobID == visitedID; });
+            if(runningIter == m_jobsRunning.end() || (*runningIter)->IsCancelled()){
+                continue;
+            }
+            (*runningIter)->Interrupt(false);
+            numInterruptedJobs++;
+        }
+
+        auto dependentsIter = m_queuedDependents.find(visitedID);
+        if(recursive && dependentsIter != m_queuedDependents.end()){
+            jobsToVisit.insert(jobsToVisit.end(), dependentsIter->second.begin(), dependentsIter->second.end());
+        }
+        if(recursive && lazyJobGraph){ // Its dependents in the graph were not created yet: they are not in "m_queuedDependents"
+            auto dependents = lazyJobGraph->GetDependents(lazyJobGraph->GetNode(visitedID));
+            for(const uint32_t* dependent = dependents.first; dependent != dependents.second; ++dependent){
+                jobsToVisit.push_back(lazyJobGraph->GetJobID((int)*dependent));
+            }
+        }
+        if(job && dependentsIter != m_queuedDependents.end()){
+            m_queuedDependents.erase(dependentsIter);
+        }
+    }
+
+    m_watchdogMutex.unlock();
+    m_jobsRunningMutex.unlock();
+    m_jobsQueuedMutex.unlock();
+
+    if(numInterruptedJobs > 0){
+        StartWatchdog(); // Kills their child processes if they do not stop
+    }
+
+    m_jobReactorMutex.lock();
+    JobReactor* jobReactor = m_jobReactor;
+    m_jobReactorMutex.unlock();
+
+    for(const auto& [cancelledJobID, isJournaled]: cancelledJobs){
+        if(isJournaled){
+            m_journal->Append({ {"record", "cancelled"}, {"id", cancelledJobID} });
+        }
+        if(jobReactor){
+            jobReactor->OnJobCompleted(cancelledJobID); // Async jobs waiting on it can resume, and find it cancelled
+        }
+    }
+    for(int lazyJobID: lazyJobsDone){
+        OnLazyJobDone(lazyJobID);
+    }
+    for(Job* job: jobsToDelete){
+        delete job;
+    }
+
+    return (int)cancelledJobs.size() + numInterruptedJobs;
 }
 
-Job* JobSystem::ClaimAJob(unsigned long workerJobChannels){
+// NOTE:    Jobs used to be claimed in FIFO order. Now, every ready job is considered and the one
+//          with the highest priority wins. In critical path mode, ties are broken by the length of
+//          the longest chain of jobs waiting on it. Then, a pinned worker prefers jobs whose input
+//          was produced on its own NUMA node. Remaining ties go to the oldest job (FIFO).
+Job* JobSystem::ClaimAJob(unsigned long workerJobChannels, int workerNumaNode){
     m_jobsQueuedMutex.lock();
     m_jobsRunningMutex.lock();
 
+    bool useCriticalPath = (m_schedulingMode == JOB_SCHEDULING_CRITICAL_PATH);
+    std::vector<Job*> jobsToSkip; // Their branch was not taken. Found on the way, so skipped on the way.
+    std::vector<Job*> cancelledJobs; // Already marked as such by CancelJob(), only still in the queue
     Job* claimedJob = nullptr;
+    bool claimedJobIsLocal = false;
+    std::deque<Job*>::iterator claimedJobIter = m_jobsQueued.end();
     std::deque<Job*>::iterator queuedJobIter = m_jobsQueued.begin();
     for(; queuedJobIter != m_jobsQueued.end(); ++queuedJobIter){
         Job* queuedJob = *queuedJobIter;
+        if(queuedJob->m_isCancelled){
+            cancelledJobs.push_back(queuedJob);
+            continue;
+        }
 
         if( (queuedJob->m_jobChannels & workerJobChannels) != 0){ // There was a match
+            bool isLocal = false;
+
+            // Only bother checking the dependencies of jobs that would beat the current pick
+            if(claimedJob != nullptr){
+                if(queuedJob->m_priority < claimedJob->m_priority){
+                    continue;
+                }
+                if(queuedJob->m_priority == claimedJob->m_priority){
+                    if(useCriticalPath && queuedJob->m_criticalPathLength < claimedJob->m_criticalPathLength){
+                        continue;
+                    }
+                    if(!useCriticalPath || queuedJob->m_criticalPathLength == claimedJob->m_criticalPathLength){
+                        if(workerNumaNode < 0 || claimedJobIsLocal){
+                            continue;
+                        }
+                        isLocal = IsJobInputOnNumaNode(queuedJob, workerNumaNode);
+                        if(!isLocal){
+                            continue;
+                        }
+                    }
+                }
+            }
+
             bool dependenciesCompleted = true;
             
             // Make sure the dependencies of the job TO BE claimed are ALL in "COMPLETE STATUS"
             for(int dependencyId: queuedJob->GetDependencies()){
-                JobStatus dependencyStatus = GetJobStatus(dependencyId);
-                if (dependencyStatus != JOB_STATUS_COMPLETED) {
+                if (!IsDependencySatisfied(dependencyId)) {
                     dependenciesCompleted = false;
                     break;
                 }
             }
 
+            if (dependenciesCompleted && IsJobSkipped(queuedJob)) {
+                jobsToSkip.push_back(queuedJob);
+                continue;
+            }
+
             if (dependenciesCompleted) {
+                if(claimedJob == nullptr && workerNumaNode >= 0){
+                    isLocal = IsJobInputOnNumaNode(queuedJob, workerNumaNode);
+                }
                 claimedJob = queuedJob;
+                claimedJobIter = queuedJobIter;
+                claimedJobIsLocal = isLocal;
+            }
+        }
+    }
 
-                m_jobHistoryMutex.lock();
-                m_jobsQueued.erase(queuedJobIter);
-                m_jobsRunning.push_back(claimedJob);
-                m_jobHistory[claimedJob->m_jobID].m_jobStatus = JOB_STATUS_RUNNING;
-                // increase "jobrunning" decrease "jobqueued"
-                jobrunning++;
-                jobqueued--;
+    if (claimedJob) {
+        m_jobHistoryMutex.lock();
+        m_jobsQueued.erase(claimedJobIter);
+        m_jobsRunning.push_back(claimedJob);
+        m_jobHistory[claimedJob->m_jobID].m_jobStatus = JOB_STATUS_RUNNING;
+        m_jobHistory[claimedJob->m_jobID].m_numaNode = workerNumaNode;
+        StoreHistoryEntry(m_jobHistory[claimedJob->m_jobID]);
+        // increase "jobrunning" decrease "jobqueued"
+        jobrunning++;
+        jobqueued--;
+
+        // FORGOT TO UNLOCK... SO DEADLOCK HAPPENED HERE
+        m_jobHistoryMutex.unlock();
 
-                // FORGOT TO UNLOCK... SO DEADLOCK HAPPENED HERE
-                m_jobHistoryMutex.unlock();
-                break;
-            }
+        m_jobsQueuedByID.erase(claimedJob->m_jobID); // Its dependents stay in "m_queuedDependents": it can still be cancelled with them
+        if(claimedJob->m_timeoutMs > 0){
+            claimedJob->m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(claimedJob->m_timeoutMs);
         }
     }
 
-    m_jobsRunningMutex.unlock();
-    m_jobsQueuedMutex.unlock();
+    SkipQueuedJobs(jobsToSkip); // After the claimed job was erased: that invalidates "claimedJobIter"
+    if(!cancelledJobs.empty()){
+        m_jobsQueued.erase(std::remove_if(m_jobsQueued.begin(), m_jobsQueued.end(), [](const Job* job){ return job->m_isCancelled.load(); }), m_jobsQueued.end());
+    }
+
+    m_jobsRunningMutex.unlock();
+    m_jobsQueuedMutex.unlock();
+
+    RetireSkippedJobs(jobsToSkip);
+    for(Job* job: cancelledJobs){
+        delete job; // Journaled, and its status set, when it was cancelled
+    }
+
+    if(claimedJob && m_journal && !claimedJob->m_isTransient){
+        m_journal->Append({ {"record", "running"}, {"id", claimedJob->m_jobID} });
+    }
+
+    return claimedJob;
+}
+
+// NOTE: Jobs read the output of their FIRST dependency (see ParsingJob and JsonJob), so that's the one that matters
+bool JobSystem::IsJobInputOnNumaNode(const Job* job, int numaNode) const{
+    if(job->GetDependencies().empty()){
+        return false;
+    }
+
+    int dependencyID = job->GetDependencies().front();
+    m_jobHistoryMutex.lock();
+    bool isLocal = (dependencyID >= 0 && dependencyID < (int)m_jobHistory.size() && m_jobHistory[dependencyID].m_numaNode == numaNode);
+    m_jobHistoryMutex.unlock();
 
-    return claimedJob;
+    return isLocal;
 }
 
 const char* JobSystem::generateRandomThreadWorkerName(int length){
@@ -284,6 +1820,11 @@ void JobSystem::GetJobDetails() const{
     std::cout << "Job completed: " << jobcompleted << std::endl;
     std::cout << "Job running: " << jobrunning << std::endl;
     std::cout << "Job retired: " << jobretired << std::endl;
+    std::cout << "Job skipped: " << jobskipped << std::endl;
+    std::cout << "Job cancelled: " << jobcancelled << std::endl;
+    std::cout << "Job retries: " << jobretried << std::endl;
+    std::cout << "Job not created yet (lazy): " << joblazy << std::endl;
+    std::cout << "Job reused from a previous run: " << jobreused << std::endl;
 
     std::cout << "\nDETAILED SUMMARY" << std::endl;
     std::cout << "===========\n" << std::endl;
@@ -292,65 +1833,278 @@ void JobSystem::GetJobDetails() const{
     const int idWidth = 5;
     const int statusWidth = 15;
     const int typeWidth = 10;
+    const int resultWidth = 8;
 
     // Display the top horizontal line
     std::cout   << "+" << std::string(idWidth + 2, '-') << "+"
                 << std::string(statusWidth + 2, '-') << "+"
-                << std::string(typeWidth + 2, '-') << "+" << std::endl;
+                << std::string(typeWidth + 2, '-') << "+"
+                << std::string(resultWidth + 2, '-') << "+" << std::endl;
 
     // Display a table header with vertical lines
     std::cout   << "| " << std::left << std::setw(idWidth) << "ID" << " | "
                 << std::left << std::setw(statusWidth) << "Status" << " | "
-                << std::left << std::setw(typeWidth) << "Type" << " |" << std::endl;
+                << std::left << std::setw(typeWidth) << "Type" << " | "
+                << std::left << std::setw(resultWidth) << "Result" << " |" << std::endl;
 
     // Display the middle horizontal line
     std::cout   << "+" << std::string(idWidth + 2, '-') << "+"
                 << std::string(statusWidth + 2, '-') << "+"
-                << std::string(typeWidth + 2, '-') << "+" << std::endl;
+                << std::string(typeWidth + 2, '-') << "+"
+                << std::string(resultWidth + 2, '-') << "+" << std::endl;
 
     // Iterate through the vector and display each struct as a row in the table
     for(const auto& record: m_jobHistory){
+        if(record.m_jobStatus == JOB_STATUS_NEVER_SEEN){
+            continue; // Created, but never queued
+        }
+
         std::cout   << "| " << std::left << std::setw(idWidth) << record.m_jobID << " | "
                     << std::left << std::setw(statusWidth) << record.m_jobStatus << " | "
-                    << std::left << std::setw(typeWidth) << record.m_jobType << " |" << std::endl;
+                    << std::left << std::setw(typeWidth) << record.m_jobType << " | "
+                    << std::left << std::setw(resultWidth) << jobResultName(record.m_jobResult) << " |" << std::endl;
         
         // Display a horizontal line between rows
         std::cout   << "+" << std::string(idWidth + 2, '-') << "+"
                     << std::string(statusWidth + 2, '-') << "+"
-                    << std::string(typeWidth + 2, '-') << "+" << std::endl;
+                    << std::string(typeWidth + 2, '-') << "+"
+                << std::string(resultWidth + 2, '-') << "+" << std::endl;
     }
 
     std::cout << std::endl;
 }
 
 json JobSystem::GetJsonJobOutputByID(int jobID) const{
+    std::shared_ptr<const json> jobOutput = GetJobOutputByID(jobID);
+    return jobOutput ? *jobOutput : json();
+}
+
+// NOTE:    Outputs never change once a job completed, so the text is cached next to the output. A caller
+//          that asks for the size, then for the output, (or polls it) only pays for serialization once.
+std::shared_ptr<const std::string> JobSystem::GetSerializedJobOutputByID(int jobID) const{
+    m_jobHistoryMutex.lock();
+    std::shared_ptr<const std::string> serializedOutput;
+    if(jobID >= 0 && jobID < (int)m_jobHistory.size()){
+        serializedOutput = m_jobHistory[jobID].m_serializedOutput;
+    }
+    m_jobHistoryMutex.unlock();
+
+    if(serializedOutput){
+        return serializedOutput;
+    }
+
+    // The history store already has it as text
+    JobHistoryRecord record;
+    std::string outputText;
+    if(m_historyStore && m_historyStore->ReadRecord(jobID, record) && (record.m_jobStatus == JOB_STATUS_COMPLETED || record.m_jobStatus == JOB_STATUS_RETIRED)
+        && m_historyStore->ReadOutputText(jobID, outputText)){
+        return std::make_shared<const std::string>(std::move(outputText));
+    }
+
+    std::shared_ptr<const json> jobOutput = GetJobOutputByID(jobID);
+    if(!jobOutput){
+        return nullptr;
+    }
+    serializedOutput = std::make_shared<const std::string>(jobOutput->dump()); // Outside of the lock, outputs can be big
+
+    m_jobHistoryMutex.lock();
+    if(jobID < (int)m_jobHistory.size()){
+        m_jobHistory[jobID].m_serializedOutput = serializedOutput;
+    }
+    m_jobHistoryMutex.unlock();
+
+    return serializedOutput;
+}
+
+// NOTE:    Used to copy the whole output under "m_jobHistoryMutex". Now, only a reference count changes hands.
+std::shared_ptr<const json> JobSystem::GetJobOutputByID(int jobID) const{
     m_jobHistoryMutex.lock();
-    json jobOutput;
+    std::shared_ptr<const json> jobOutput;
 
-    // Go through the history, find the job, and if COMPLETED OR RETIRED, return its output
-    for (const JobHistoryEntry& entry : m_jobHistory){
-        if(entry.m_jobID == jobID && (entry.m_jobStatus == JOB_STATUS_COMPLETED || entry.m_jobStatus == JOB_STATUS_RETIRED)){
+    // Find the job in the history, and if COMPLETED OR RETIRED, return its output
+    if(jobID >= 0 && jobID < (int)m_jobHistory.size()){
+        const JobHistoryEntry& entry = m_jobHistory[jobID];
+        if(entry.m_jobStatus == JOB_STATUS_COMPLETED || entry.m_jobStatus == JOB_STATUS_RETIRED){
             jobOutput = entry.m_jobOutput;
-            break;
         }
-    }    
+    }
     
     m_jobHistoryMutex.unlock();
 
+    // With the history store, outputs (of this run, or of previous ones) are read back from disk
+    JobHistoryRecord record;
+    if(m_historyStore && !jobOutput && m_historyStore->ReadRecord(jobID, record)){
+        if(record.m_jobStatus == JOB_STATUS_COMPLETED || record.m_jobStatus == JOB_STATUS_RETIRED){
+            jobOutput = std::make_shared<const json>(m_historyStore->ReadOutput(jobID));
+        }
+    }
+
     return jobOutput;
 }
 
 Job* JobSystem::CreateJob(const std::string jobTypeIdentifier, const json& jsonData){
+    return CreateJob(jobTypeIdentifier, std::make_shared<const json>(jsonData));
+}
+
+Job* JobSystem::CreateJob(const std::string jobTypeIdentifier, std::shared_ptr<const json> jsonData){
     auto it = m_jobTypeFactories.find(jobTypeIdentifier);
     if(it != m_jobTypeFactories.end()){
         auto& factoryFunction = it->second;
-        return factoryFunction(jsonData.dump().c_str());
+
+        // NOTE:    Constructors read their input with value() and at(), which throw when it is not an object, or
+        //          lacks a field. The input may come from another process (ring, daemon), or from a worker thread
+        //          creating lazy jobs: a bad one used to terminate the job system. It is refused like a bad type.
+        Job* job = nullptr;
+        try{
+            job = factoryFunction(*jsonData);
+        } catch(const json::exception& exception){
+            std::cout << "Error: Unable to create a '" << jobTypeIdentifier << "' job from its input: " << exception.what() << std::endl;
+            return nullptr;
+        }
+        if(job){
+            job->m_jobTypeIdentifier = jobTypeIdentifier;
+            job->m_input = std::move(jsonData);
+        }
+        return job;
     } else {
         std::cout << "Error: Job type with identifier: '" << jobTypeIdentifier << "' - not registered." << std::endl;
         return nullptr;
     }
 }
 
+Job* JobSystem::CreateJob(const std::string& jobTypeIdentifier, std::shared_ptr<const json> jsonData, int jobID){
+    Job::AssignedJobID() = jobID; // Taken by the job's constructor. A new ID per attempt used to leave gaps in the history.
+    Job* job = CreateJob(jobTypeIdentifier, std::move(jsonData));
+    Job::AssignedJobID() = -1; // In case the factory did not construct a job
+    return job;
+}
+
+void JobSystem::RegisterBuiltInJobTypes(){
+    // NOTE: They take the input already parsed. It used to be serialized, then parsed twice (by Job, then by the job itself)
+    std::function<Job* (const json&)> compileJobFactory = [](const json& jsonData) -> Job* {
+        return new CompileJob(jsonData);
+    };
+
+    std::function<Job* (const json&)> parsingJobFactory = [](const json& jsonData) -> Job* {
+        return new ParsingJob(jsonData);
+    };
+
+    std::function<Job* (const json&)> jsonJobFactory = [](const json& jsonData) -> Job* {
+        return new JsonJob(jsonData);
+    };
+
+    std::function<Job* (const json&)> conditionalJobFactory = [](const json& jsonData) -> Job* {
+        return new LogicalConditionalJob(jsonData);
+    };
+
+    std::function<Job* (const json&)> compileUnitJobFactory = [](const json& jsonData) -> Job* {
+        return new CompileUnitJob(jsonData);
+    };
+
+    RegisterJobType("COMPILE_JOB", compileJobFactory);
+    RegisterJobType("PARSING_JOB", parsingJobFactory);
+    RegisterJobType("JSON_JOB", jsonJobFactory);
+    RegisterJobType("CONDITIONAL_JOB", conditionalJobFactory);
+    RegisterJobType("COMPILE_UNIT_JOB", compileUnitJobFactory);
+}
+
+bool JobSystem::IsJobTypeRegistered(const std::string& jobTypeIdentifier) const {
+    return m_jobTypeFactories.find(jobTypeIdentifier) != m_jobTypeFactories.end();
+}
+
+static void replaceAll(std::string& text, const std::string& from, const std::string& to){
+    for(size_t position = text.find(from); position != std::string::npos; position = text.find(from, position + to.size())){
+        text.replace(position, from.size(), to);
+    }
+}
+
+// Replaces the placeholders in every string of the template, keys included. Done on the parsed input, so items need no escaping.
+static void instantiateFanOutTemplate(json& value, const std::string& item, const std::string& index){
+    if(value.is_string()){
+        std::string text = value.get<std::string>();
+        if(text.find("${") != std::string::npos){
+            replaceAll(text, "${item}", item);
+            replaceAll(text, "${index}", index);
+            value = text;
+        }
+    } else if(value.is_array()){
+        for(json& element: value){
+            instantiateFanOutTemplate(element, item, index);
+        }
+    } else if(value.is_object()){
+        bool hasPlaceholderInKeys = false;
+        for(auto& [key, element]: value.items()){
+            instantiateFanOutTemplate(element, item, index);
+            hasPlaceholderInKeys = hasPlaceholderInKeys || key.find("${") != std::string::npos;
+        }
+        if(!hasPlaceholderInKeys){
+            return;
+        }
+
+        json instantiated = json::object();
+        for(auto& [key, element]: value.items()){
+            std::string instantiatedKey = key;
+            replaceAll(instantiatedKey, "${item}", item);
+            replaceAll(instantiatedKey, "${index}", index);
+            instantiated[instantiatedKey] = std::move(element);
+        }
+        value = std::move(instantiated);
+    }
+}
+
+bool JobSystem::CreateJobFanOut(const std::string& jobTypeIdentifier, const json& inputTemplate, const std::vector<std::string>& items, std::vector<Job*>& jobs){
+    jobs.clear();
+    if(!IsJobTypeRegistered(jobTypeIdentifier)){
+        std::cout << "Error: Job type with identifier: '" << jobTypeIdentifier << "' - not registered." << std::endl;
+        return false;
+    }
+
+    // NOTE:    CreateJob() refuses inputs that make a constructor throw json errors. Anything else thrown
+    //          (out of memory, a custom job type) still goes to the caller, just without the jobs created so far.
+    jobs.reserve(items.size());
+    for(size_t i = 0; i < items.size(); i++){
+        Job* job = nullptr;
+        try{
+            job = CreateJob(jobTypeIdentifier, InstantiateFanOutInput(inputTemplate, items[i], i));
+        } catch(...){
+            for(Job* createdJob: jobs){
+                delete createdJob;
+            }
+            jobs.clear();
+            throw;
+        }
+        if(!job){
+            // A fan-out one job short would be queued as if it were whole: none of it is
+            std::cout << "Error: Job " << i << " of the fan-out ('" << items[i] << "') could not be created from its input." << std::endl;
+            for(Job* createdJob: jobs){
+                delete createdJob;
+            }
+            jobs.clear();
+            return false;
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+json JobSystem::InstantiateFanOutInput(const json& inputTemplate, const std::string& item, size_t index){
+    json input = inputTemplate;
+    instantiateFanOutTemplate(input, item, std::to_string(index));
+    return input;
+}
+
+std::vector<std::string> JobSystem::ExpandFanOutPattern(const std::string& pattern){
+    std::vector<std::string> paths;
+    glob_t globResult;
+    if(glob(pattern.c_str(), 0, nullptr, &globResult) == 0){
+        for(size_t i = 0; i < globResult.gl_pathc; i++){
+            paths.push_back(globResult.gl_pathv[i]);
+        }
+    }
+    globfree(&globResult);
+    return paths;
+}
+
 std::vector<std::string> JobSystem::GetRegisteredJobTypes() const {
     std::vector<std::string> registeredJobTypes;
     for (const auto& pair : m_jobTypeFactories) {
@@ -379,24 +2133,111 @@ extern "C"{
            return;
         }
 
-        js->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x10000000); // Dedicated worker threads for COMPILE jobs
-        js->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x10000000);
+        js->CreateDefaultWorkerPool();
+        js->StartWorkerPoolController();
+    }
+
+    void SetWorkerProcesses(JobSystemHandle jobSystem, unsigned long workerJobChannels, const char* executablePath){
+        reinterpret_cast<JobSystem*>(jobSystem)->SetWorkerProcesses(workerJobChannels, executablePath ? executablePath : "");
+    }
+
+    void SetWorkerPoolLimits(JobSystemHandle jobSystem, unsigned long workerJobChannels, int minWorkers, int maxWorkers){
+        reinterpret_cast<JobSystem*>(jobSystem)->SetWorkerPoolLimits(workerJobChannels, minWorkers, maxWorkers);
+    }
+
+    void StartWorkerPoolController(JobSystemHandle jobSystem){
+        reinterpret_cast<JobSystem*>(jobSystem)->StartWorkerPoolController();
+    }
 
-        js->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x20000000); // Dedicated worker threads for PARSING jobs
-        js->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x20000000);
+    void StopWorkerPoolController(JobSystemHandle jobSystem){
+        reinterpret_cast<JobSystem*>(jobSystem)->StopWorkerPoolController();
+    }
 
-        js->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x40000000); // Dedicated worker threads for JSON jobs
-        js->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x40000000);
+    void SetWorkerPlacement(JobSystemHandle jobSystem, unsigned long workerJobChannels, int placementPolicy, const char* cpuList){
+        if(placementPolicy < 0 || placementPolicy >= NUM_WORKER_PLACEMENT_POLICIES){
+            std::cout << "Error: Unknown worker placement policy: " << placementPolicy << std::endl;
+            return;
+        }
 
-        js->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x8000000); // Dedicated worker threads for ANY other jobs
+        std::vector<int> cpuSet;
+        if(cpuList != nullptr){
+            cpuSet = CpuTopology::ParseCpuList(cpuList);
+        }
+        reinterpret_cast<JobSystem*>(jobSystem)->SetWorkerPlacement(workerJobChannels, (WorkerPlacementPolicy)placementPolicy, cpuSet);
     }
 
     JobHandle CreateJob(JobSystemHandle jobSystem, const char* jobTypeIdentifier, const char* jsonData){
         std::string id = jobTypeIdentifier;
-        Job* job = reinterpret_cast<JobSystem*>(jobSystem)->CreateJob(id, json::parse(jsonData));
+        // NOTE: Scripts give thousands of jobs the same input text. They all get the same parsed input.
+        JobSystem* js = reinterpret_cast<JobSystem*>(jobSystem);
+        Job* job = js->CreateJob(id, js->GetInternTable()->InternInput(jsonData));
+        return reinterpret_cast<JobHandle>(job);
+    }
+
+    JobHandle CreateJobFromBinary(JobSystemHandle jobSystem, const char* jobTypeIdentifier, const unsigned char* data, size_t dataSize, int dataFormat){
+        json jsonData;
+        if(!decodeJobData(data, dataSize, dataFormat, jsonData)){
+            std::cout << "Error: Unable to decode the input of a '" << jobTypeIdentifier << "' job (format " << dataFormat << ")" << std::endl;
+            return nullptr;
+        }
+
+        Job* job = reinterpret_cast<JobSystem*>(jobSystem)->CreateJob(jobTypeIdentifier, jsonData);
         return reinterpret_cast<JobHandle>(job);
     }
 
+    long long GetJobOutputEncoded(JobSystemHandle jobSystem, int jobID, int dataFormat, unsigned char* buffer, size_t bufferSize){
+        std::shared_ptr<const json> jobOutput = reinterpret_cast<JobSystem*>(jobSystem)->GetJobOutputByID(jobID);
+        std::vector<unsigned char> encodedOutput;
+        if(!jobOutput || !encodeJobData(*jobOutput, dataFormat, encodedOutput)){
+            return -1;
+        }
+
+        if(buffer != nullptr && bufferSize >= encodedOutput.size()){
+            std::copy(encodedOutput.begin(), encodedOutput.end(), buffer);
+        }
+        return (long long)encodedOutput.size();
+    }
+
+    long long GetJobOutputSize(JobSystemHandle jobSystem, int jobID){
+        std::shared_ptr<const std::string> jobOutput = reinterpret_cast<JobSystem*>(jobSystem)->GetSerializedJobOutputByID(jobID);
+        return jobOutput ? (long long)jobOutput->size() : -1;
+    }
+
+    long long GetJobOutput(JobSystemHandle jobSystem, int jobID, char* buffer, size_t bufferSize){
+        std::shared_ptr<const std::string> jobOutput = reinterpret_cast<JobSystem*>(jobSystem)->GetSerializedJobOutputByID(jobID);
+        if(!jobOutput){
+            return -1;
+        }
+
+        if(buffer != nullptr && bufferSize > jobOutput->size()){
+            memcpy(buffer, jobOutput->c_str(), jobOutput->size() + 1); // With its NUL
+        }
+        return (long long)jobOutput->size();
+    }
+
+    long long GetJobOutputs(JobSystemHandle jobSystem, const int* jobIDs, int numJobs, char* buffer, size_t bufferSize, long long* offsets, long long* sizes){
+        JobSystem* js = reinterpret_cast<JobSystem*>(jobSystem);
+        size_t numBytesNeeded = 0;
+
+        for(int i = 0; i < numJobs; i++){
+            std::shared_ptr<const std::string> jobOutput = js->GetSerializedJobOutputByID(jobIDs[i]);
+            offsets[i] = -1;
+            sizes[i] = -1;
+            if(!jobOutput){
+                continue;
+            }
+
+            sizes[i] = (long long)jobOutput->size();
+            if(buffer != nullptr && numBytesNeeded + jobOutput->size() + 1 <= bufferSize){
+                memcpy(buffer + numBytesNeeded, jobOutput->c_str(), jobOutput->size() + 1);
+                offsets[i] = (long long)numBytesNeeded;
+            }
+            numBytesNeeded += jobOutput->size() + 1;
+        }
+
+        return (long long)numBytesNeeded;
+    }
+
     void FinishJob(JobSystemHandle jobSystem, int jobID){
         reinterpret_cast<JobSystem*>(jobSystem)->FinishJob(jobID);
     }
@@ -416,6 +2257,14 @@ extern "C"{
         return reinterpret_cast<JobSystem*>(jobsystem)->GetJobStatus(jobID);
     }
 
+    int GetJobResult(JobSystemHandle jobsystem, int jobID){
+        return reinterpret_cast<JobSystem*>(jobsystem)->GetJobResult(jobID);
+    }
+
+    int CancelJob(JobSystemHandle jobsystem, int jobID, int recursive){
+        return reinterpret_cast<JobSystem*>(jobsystem)->CancelJob(jobID, recursive != 0);
+    }
+
     int GetJobID(JobSystemHandle jobsystem, JobHandle jobHandle){
         Job* job = reinterpret_cast<Job*>(jobHandle);
         return job->GetUniqueID();
@@ -432,6 +2281,345 @@ extern "C"{
         dependent->AddDependency(dependency->GetUniqueID());
     }
 
+    void SetJobPriority(JobHandle jobHandle, int priority){
+        Job* job = reinterpret_cast<Job*>(jobHandle);
+        job->SetPriority(priority);
+    }
+
+    void SetJobTimeout(JobHandle jobHandle, int timeoutMs){
+        Job* job = reinterpret_cast<Job*>(jobHandle);
+        job->SetTimeout(timeoutMs);
+    }
+
+    void SetJobRetries(JobHandle jobHandle, int maxRetries, int backoffMs){
+        Job* job = reinterpret_cast<Job*>(jobHandle);
+        job->SetRetries(maxRetries, backoffMs);
+    }
+
+    void SetJobGate(JobHandle jobHandle, JobHandle conditionalJobHandle, int runIfConditionMet){
+        Job* job = reinterpret_cast<Job*>(jobHandle);
+        job->SetGate(reinterpret_cast<Job*>(conditionalJobHandle)->GetUniqueID(), runIfConditionMet != 0);
+    }
+
+    void AddDependencyByID(JobHandle dependentHandle, int dependencyJobID){
+        reinterpret_cast<Job*>(dependentHandle)->AddDependency(dependencyJobID);
+    }
+
+    void SetJobGateByID(JobHandle jobHandle, int conditionalJobID, int runIfConditionMet){
+        reinterpret_cast<Job*>(jobHandle)->SetGate(conditionalJobID, runIfConditionMet != 0);
+    }
+
+    int RecordReusedJob(JobSystemHandle jobsystem, int jobType, int jobResult, const char* jobOutput){
+        json parsedOutput = json::parse(jobOutput, nullptr, false);
+        if(parsedOutput.is_discarded()){
+            return -1;
+        }
+        return reinterpret_cast<JobSystem*>(jobsystem)->RecordReusedJob(jobType, (JobResult)jobResult, parsedOutput);
+    }
+
+    JobFanOutHandle CreateJobFanOut(JobSystemHandle jobsystem, const char* jobTypeIdentifier, const char* inputTemplate, const char* const* items, int numItems, const char* globPattern){
+        JobSystem* js = reinterpret_cast<JobSystem*>(jobsystem);
+        if(!js->IsJobTypeRegistered(jobTypeIdentifier)){
+            std::cout << "Error: Job type with identifier: '" << jobTypeIdentifier << "' - not registered." << std::endl;
+            return nullptr;
+        }
+
+        std::vector<std::string> fanOutItems;
+        if(globPattern != nullptr){
+            fanOutItems = JobSystem::ExpandFanOutPattern(globPattern);
+        } else {
+            fanOutItems.assign(items, items + numItems);
+        }
+
+        // Never thrown at the caller, across "extern C"
+        json parsedTemplate = json::parse(inputTemplate, nullptr, false);
+        if(parsedTemplate.is_discarded()){
+            std::cout << "Error: The input template of a fan-out is not JSON: " << inputTemplate << std::endl;
+            return nullptr;
+        }
+
+        JobFanOut* fanOut = new JobFanOut();
+        if(!js->CreateJobFanOut(jobTypeIdentifier, parsedTemplate, fanOutItems, fanOut->m_jobs)){
+            delete fanOut;
+            return nullptr;
+        }
+        return reinterpret_cast<JobFanOutHandle>(fanOut);
+    }
+
+    int GetJobFanOutSize(JobFanOutHandle fanOutHandle){
+        return (int)reinterpret_cast<JobFanOut*>(fanOutHandle)->m_jobs.size();
+    }
+
+    int GetJobFanOutIDs(JobFanOutHandle fanOutHandle, int* jobIDs, int maxJobIDs){
+        JobFanOut* fanOut = reinterpret_cast<JobFanOut*>(fanOutHandle);
+        for(int i = 0; i < (int)fanOut->m_jobs.size() && i < maxJobIDs; i++){
+            jobIDs[i] = fanOut->m_jobs[i]->GetUniqueID();
+        }
+        return (int)fanOut->m_jobs.size();
+    }
+
+    void AddDependencyToFanOut(JobFanOutHandle dependentsHandle, JobHandle dependencyHandle){
+        int dependencyID = reinterpret_cast<Job*>(dependencyHandle)->GetUniqueID();
+        for(Job* dependent: reinterpret_cast<JobFanOut*>(dependentsHandle)->m_jobs){
+            dependent->AddDependency(dependencyID);
+        }
+    }
+
+    void AddFanOutDependency(JobHandle dependentHandle, JobFanOutHandle dependenciesHandle){
+        Job* dependent = reinterpret_cast<Job*>(dependentHandle);
+        for(Job* dependency: reinterpret_cast<JobFanOut*>(dependenciesHandle)->m_jobs){
+            dependent->AddDependency(dependency->GetUniqueID());
+        }
+    }
+
+    void AddFanOutToFanOutDependency(JobFanOutHandle dependentsHandle, JobFanOutHandle dependenciesHandle){
+        for(Job* dependent: reinterpret_cast<JobFanOut*>(dependentsHandle)->m_jobs){
+            for(Job* dependency: reinterpret_cast<JobFanOut*>(dependenciesHandle)->m_jobs){
+                dependent->AddDependency(dependency->GetUniqueID());
+            }
+        }
+    }
+
+    void SetJobFanOutPriority(JobFanOutHandle fanOutHandle, int priority){
+        for(Job* job: reinterpret_cast<JobFanOut*>(fanOutHandle)->m_jobs){
+            job->SetPriority(priority);
+        }
+    }
+
+    void SetJobFanOutGate(JobFanOutHandle fanOutHandle, JobHandle conditionalJobHandle, int runIfConditionMet){
+        int conditionalJobID = reinterpret_cast<Job*>(conditionalJobHandle)->GetUniqueID();
+        for(Job* job: reinterpret_cast<JobFanOut*>(fanOutHandle)->m_jobs){
+            job->SetGate(conditionalJobID, runIfConditionMet != 0);
+        }
+    }
+
+    void AddDependencyByIDToFanOut(JobFanOutHandle dependentsHandle, int dependencyJobID){
+        for(Job* dependent: reinterpret_cast<JobFanOut*>(dependentsHandle)->m_jobs){
+            dependent->AddDependency(dependencyJobID);
+        }
+    }
+
+    void SetJobFanOutGateByID(JobFanOutHandle fanOutHandle, int conditionalJobID, int runIfConditionMet){
+        for(Job* job: reinterpret_cast<JobFanOut*>(fanOutHandle)->m_jobs){
+            job->SetGate(conditionalJobID, runIfConditionMet != 0);
+        }
+    }
+
+    void QueueJobFanOut(JobSystemHandle jobsystem, JobFanOutHandle fanOutHandle){
+        JobFanOut* fanOut = reinterpret_cast<JobFanOut*>(fanOutHandle);
+        for(Job* job: fanOut->m_jobs){
+            reinterpret_cast<JobSystem*>(jobsystem)->QueueJob(job);
+        }
+        delete fanOut;
+    }
+
+    LazyJobGraphHandle CreateLazyJobGraph(){
+        return reinterpret_cast<LazyJobGraphHandle>(new LazyJobGraph());
+    }
+
+    int AddLazyGraphJob(LazyJobGraphHandle graphHandle, const char* jobTypeIdentifier, const char* jsonData, int priority){
+        // Checked now: the job is only created much later, by a worker, where nobody could tell the caller
+        size_t inputSize = strlen(jsonData);
+        if(!json::accept(jsonData, jsonData + inputSize)){
+            std::cout << "Error: The input of a lazy job is not JSON: " << jsonData << std::endl;
+            return -1;
+        }
+
+        LazyJobGraph* graph = reinterpret_cast<LazyJobGraph*>(graphHandle);
+        return graph->AddNode(graph->AddJobType(jobTypeIdentifier), jsonData, inputSize, priority);
+    }
+
+    int AddLazyGraphFanOut(LazyJobGraphHandle graphHandle, const char* jobTypeIdentifier, const char* inputTemplate, const char* const* items, int numItems, const char* globPattern, int priority, int* firstNode){
+        LazyJobGraph* graph = reinterpret_cast<LazyJobGraph*>(graphHandle);
+        *firstNode = graph->GetNumNodes();
+
+        // Like AddLazyGraphJob: checked now, and never thrown at the caller
+        json parsedTemplate = json::parse(inputTemplate, nullptr, false);
+        if(parsedTemplate.is_discarded()){
+            std::cout << "Error: The input template of a lazy fan-out is not JSON: " << inputTemplate << std::endl;
+            return -1;
+        }
+
+        std::vector<std::string> fanOutItems;
+        if(globPattern != nullptr){
+            fanOutItems = JobSystem::ExpandFanOutPattern(globPattern);
+        } else {
+            fanOutItems.assign(items, items + numItems);
+        }
+
+        uint32_t typeIndex = graph->AddJobType(jobTypeIdentifier);
+        for(size_t i = 0; i < fanOutItems.size(); i++){
+            std::string input = JobSystem::InstantiateFanOutInput(parsedTemplate, fanOutItems[i], i).dump();
+            if(graph->AddNode(typeIndex, input.c_str(), input.size(), priority) < 0){
+                std::cout << "Error: The lazy graph is full (or sealed), after " << i << " of the " << fanOutItems.size() << " nodes of a fan-out" << std::endl;
+                graph->RemoveNodesFrom(*firstNode); // All or nothing, like a fan-out of regular jobs
+                return -1;
+            }
+        }
+        return (int)fanOutItems.size();
+    }
+
+    void AddLazyGraphDependencies(LazyJobGraphHandle graphHandle, const int* dependencyNodes, const int* dependentNodes, int numDependencies){
+        LazyJobGraph* graph = reinterpret_cast<LazyJobGraph*>(graphHandle);
+        for(int i = 0; i < numDependencies; i++){
+            graph->AddEdge(dependencyNodes[i], dependentNodes[i]);
+        }
+    }
+
+    void SetLazyGraphGate(LazyJobGraphHandle graphHandle, int node, int conditionalNode, int runIfConditionMet){
+        reinterpret_cast<LazyJobGraph*>(graphHandle)->SetGate(node, conditionalNode, runIfConditionMet != 0);
+    }
+
+    int QueueLazyJobGraph(JobSystemHandle jobsystem, LazyJobGraphHandle graphHandle){
+        std::shared_ptr<LazyJobGraph> graph(reinterpret_cast<LazyJobGraph*>(graphHandle)); // The job system keeps it as long as it needs it
+        return reinterpret_cast<JobSystem*>(jobsystem)->QueueLazyJobGraph(graph);
+    }
+
+    void SetSchedulingMode(JobSystemHandle jobsystem, int schedulingMode){
+        if(schedulingMode < 0 || schedulingMode >= NUM_JOB_SCHEDULING_MODES){
+            std::cout << "Error: Unknown scheduling mode: " << schedulingMode << std::endl;
+            return;
+        }
+        reinterpret_cast<JobSystem*>(jobsystem)->SetSchedulingMode((JobSchedulingMode)schedulingMode);
+    }
+
+    void SetCompileParallelism(JobSystemHandle jobsystem, int numTokens){
+        reinterpret_cast<JobSystem*>(jobsystem)->SetCompileParallelism(numTokens);
+    }
+
+    FlowScriptTokensHandle ScanFlowScriptFile(const char* scriptPath){
+        FlowScriptScanner* scanner = new FlowScriptScanner();
+        if(!scanner->ScanFile(scriptPath)){
+            delete scanner;
+            return nullptr;
+        }
+        return reinterpret_cast<FlowScriptTokensHandle>(scanner);
+    }
+
+    int GetFlowScriptNumTokens(FlowScriptTokensHandle tokens){
+        return (int)reinterpret_cast<FlowScriptScanner*>(tokens)->GetNumTokens();
+    }
+
+    void GetFlowScriptTokenArrays(FlowScriptTokensHandle tokens, const uint8_t** types, const uint32_t** offsets, const uint32_t** lengths, const uint32_t** lines){
+        FlowScriptScanner* scanner = reinterpret_cast<FlowScriptScanner*>(tokens);
+        *types = scanner->GetTypes();
+        *offsets = scanner->GetOffsets();
+        *lengths = scanner->GetLengths();
+        *lines = scanner->GetLines();
+    }
+
+    const char* GetFlowScriptSource(FlowScriptTokensHandle tokens, size_t* sourceSize){
+        FlowScriptScanner* scanner = reinterpret_cast<FlowScriptScanner*>(tokens);
+        *sourceSize = scanner->GetSourceSize();
+        return scanner->GetSource();
+    }
+
+    int GetFlowScriptNumErrors(FlowScriptTokensHandle tokens){
+        return (int)reinterpret_cast<FlowScriptScanner*>(tokens)->GetErrors().size();
+    }
+
+    const char* GetFlowScriptError(FlowScriptTokensHandle tokens, int errorIndex, int* line){
+        const FlowScriptScanner::ScanError& error = reinterpret_cast<FlowScriptScanner*>(tokens)->GetErrors()[errorIndex];
+        *line = (int)error.m_line;
+        return error.m_message.c_str();
+    }
+
+    void FreeFlowScriptTokens(FlowScriptTokensHandle tokens){
+        delete reinterpret_cast<FlowScriptScanner*>(tokens);
+    }
+
+    int EnableJobJournal(JobSystemHandle jobsystem, const char* journalPath){
+        return reinterpret_cast<JobSystem*>(jobsystem)->EnableJournal(journalPath) ? 1 : 0;
+    }
+
+    int RecoverFromJournal(JobSystemHandle jobsystem, const char* journalPath){
+        return reinterpret_cast<JobSystem*>(jobsystem)->RecoverFromJournal(journalPath);
+    }
+
+    void SyncJobJournal(JobSystemHandle jobsystem){
+        reinterpret_cast<JobSystem*>(jobsystem)->SyncJournal();
+    }
+
+    int EnableJobHistoryStore(JobSystemHandle jobsystem, const char* folderPath){
+        return reinterpret_cast<JobSystem*>(jobsystem)->EnableHistoryStore(folderPath) ? 1 : 0;
+    }
+
+    int EnableJobSubmissionRing(JobSystemHandle jobsystem, const char* ringName, unsigned long long capacity){
+        return reinterpret_cast<JobSystem*>(jobsystem)->EnableSubmissionRing(ringName, capacity) ? 1 : 0;
+    }
+
+    JobRingHandle OpenJobRing(const char* ringName){
+        return reinterpret_cast<JobRingHandle>(JobRing::Open(ringName));
+    }
+
+    void CloseJobRing(JobRingHandle ring){
+        delete reinterpret_cast<JobRing*>(ring);
+    }
+
+    int SubmitJobToRing(JobRingHandle ring, unsigned long long tag, const char* jobTypeIdentifier, const unsigned char* input, size_t inputSize, int inputFormat,
+                        const unsigned long long* dependencyTags, int numDependencies, int priority){
+        SpscByteRing& submissions = reinterpret_cast<JobRing*>(ring)->GetSubmissions();
+
+        JobRingSubmission submission;
+        memset(&submission, 0, sizeof(submission));
+        submission.m_tag = tag;
+        submission.m_typeLength = (uint32_t)strlen(jobTypeIdentifier);
+        submission.m_numDependencies = (uint32_t)std::max(numDependencies, 0);
+        submission.m_inputSize = (uint32_t)inputSize;
+        submission.m_priority = priority;
+        submission.m_inputFormat = (uint8_t)inputFormat;
+
+        // NOTE: Assembled here, then copied into the ring in one go. One producer per ring, so one buffer per thread is plenty.
+        size_t typeSize = (submission.m_typeLength + 7) & ~(size_t)7;
+        size_t recordSize = sizeof(submission) + typeSize + submission.m_numDependencies * sizeof(uint64_t) + inputSize;
+        if(recordSize > submissions.GetMaxRecordSize()){
+            return -1;
+        }
+
+        static thread_local std::vector<unsigned char> record;
+        record.assign(recordSize, 0);
+        unsigned char* recordCursor = record.data();
+        memcpy(recordCursor, &submission, sizeof(submission));
+        recordCursor += sizeof(submission);
+        memcpy(recordCursor, jobTypeIdentifier, submission.m_typeLength);
+        recordCursor += typeSize;
+        if(submission.m_numDependencies > 0){
+            memcpy(recordCursor, dependencyTags, submission.m_numDependencies * sizeof(uint64_t));
+            recordCursor += submission.m_numDependencies * sizeof(uint64_t);
+        }
+        if(inputSize > 0){
+            memcpy(recordCursor, input, inputSize);
+        }
+
+        return submissions.TryWrite(record.data(), (uint32_t)recordSize) ? 1 : 0;
+    }
+
+    long long PollJobRingCompletion(JobRingHandle ring, unsigned long long* tag, int* jobID, int* jobStatus, unsigned char* buffer, size_t bufferSize){
+        SpscByteRing& completions = reinterpret_cast<JobRing*>(ring)->GetCompletions();
+
+        const unsigned char* record = nullptr;
+        uint32_t recordSize = 0;
+        if(!completions.Peek(record, recordSize) || recordSize < sizeof(JobRingCompletion)){
+            return -1;
+        }
+
+        JobRingCompletion completion;
+        memcpy(&completion, record, sizeof(completion));
+        *tag = completion.m_tag;
+        *jobID = completion.m_jobID;
+        *jobStatus = completion.m_jobStatus;
+
+        if(completion.m_outputSize > 0 && (buffer == nullptr || bufferSize < completion.m_outputSize)){
+            return completion.m_outputSize; // Left in the ring
+        }
+
+        if(completion.m_outputSize > 0){
+            memcpy(buffer, record + sizeof(completion), completion.m_outputSize);
+        }
+        completions.Consume();
+        return completion.m_outputSize;
+    }
+
     void RegisterJobType(JobSystemHandle jobsystem, const char* jobIdentifier, void* (*jobFactoryFunction)(const char*)){
         //
         std::function<Job* (const char*)> factoryFunctionWrapper = [=](const char* jsonData){
@@ -485,40 +2673,11 @@ extern "C"{
     }
 
     void InitJobSystem(){
-
         // Register jobs
+        JobSystem::CreateOrGet()->RegisterBuiltInJobTypes();
 
-        std::function<Job* (const char *)> compileJobFactory = [](const char *jsonData) -> Job* {
-            return new CompileJob(jsonData);
-        };
-
-        std::function<Job* (const char *)> parsingJobFactory = [](const char *jsonData) -> Job* {
-            return new ParsingJob(jsonData);
-        };
-
-        std::function<Job* (const char *)> jsonJobFactory = [](const char *jsonData) -> Job* {
-            return new JsonJob(jsonData);
-        };
-
-        std::function<Job* (const char*)> conditionalJobFactory = [](const char* jsonData) -> Job* {
-            return new LogicalConditionalJob(jsonData);
-        };
-
-        JobSystem::CreateOrGet()->RegisterJobType("COMPILE_JOB", compileJobFactory);
-        JobSystem::CreateOrGet()->RegisterJobType("PARSING_JOB", parsingJobFactory);
-        JobSystem::CreateOrGet()->RegisterJobType("JSON_JOB", jsonJobFactory);
-        JobSystem::CreateOrGet()->RegisterJobType("CONDITIONAL_JOB", conditionalJobFactory);
-
-        // Kick off worker threads
-        JobSystem::CreateOrGet()->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x10000000); // Dedicated worker threads for COMPILE jobs
-        JobSystem::CreateOrGet()->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x10000000);
-
-        JobSystem::CreateOrGet()->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x20000000); // Dedicated worker threads for PARSING jobs
-        JobSystem::CreateOrGet()->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x20000000);
-
-        JobSystem::CreateOrGet()->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x40000000); // Dedicated worker threads for JSON jobs
-        JobSystem::CreateOrGet()->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x40000000);
-
-        JobSystem::CreateOrGet()->CreateWorkerThread(JobSystem::generateRandomThreadWorkerName(), 0x8000000); // Dedicated worker threads for ANY other jobs
+        // Kick off worker threads, then let the controller grow or shrink the pool with the load
+        JobSystem::CreateOrGet()->CreateDefaultWorkerPool();
+        JobSystem::CreateOrGet()->StartWorkerPoolController();
     }
 }
\ No newline at end of file
@@ -6,12 +6,34 @@
 #include <vector>
 #include <thread>
 #include <functional>
+#include <condition_variable>
+#include <chrono>
 #include "json.hpp"
+#include "workerplacement.h"
+#include "jobserver.h"
+#include "buildmanifest.h"
+#include "jobjournal.h"
+#include "jobhistorystore.h"
+#include "jobdata.h"
+#include "workerprocess.h"
+#include "jobring.h"
+#include "jobreactor.h"
+#include "fileioservice.h"
+#include "jobresult.h"
+#include "lazyjobgraph.h"
+#include "interntable.h"
+#include "flowscriptscanner.h"
 
 using json = nlohmann::json;
 
 constexpr int JOB_TYPE_ANY = -1;
 
+// Channels the built-in job types are routed through
+constexpr unsigned long JOB_CHANNEL_COMPILE = 0x10000000;
+constexpr unsigned long JOB_CHANNEL_PARSING = 0x20000000;
+constexpr unsigned long JOB_CHANNEL_JSON    = 0x40000000;
+constexpr unsigned long JOB_CHANNEL_OTHER   = 0x8000000;
+
 class JobWorkerThread; // Forward declaration, tell jobsystem that it should be aware of but is actually implemented somewhere else. If the compiler do not find it, we get an error.
 
 enum JobStatus
@@ -21,9 +43,18 @@ enum JobStatus
     JOB_STATUS_RUNNING,
     JOB_STATUS_COMPLETED,
     JOB_STATUS_RETIRED,
+    JOB_STATUS_SKIPPED, // Never ran: on the branch a conditional job did not take, or depending on a job that was skipped (or cancelled)
+    JOB_STATUS_CANCELLED, // Never ran: cancelled while it was queued (see CancelJob). A running job that gets cancelled completes, as a failure.
     NUM_JOB_STATUSES
 };
 
+enum JobSchedulingMode
+{
+    JOB_SCHEDULING_FIFO,            // Ready jobs are claimed by priority, then in the order they were queued
+    JOB_SCHEDULING_CRITICAL_PATH,   // Ready jobs are claimed by priority, then by the length of the longest chain of jobs waiting on them
+    NUM_JOB_SCHEDULING_MODES
+};
+
 struct JobHistoryEntry
 {
     JobHistoryEntry(int jobID, int jobType, JobStatus jobStatus) : m_jobID(jobID), m_jobType(jobType), m_jobStatus(jobStatus) {}
@@ -31,14 +62,34 @@ struct JobHistoryEntry
     int m_jobID = -1;
     int m_jobType = -1;
     int m_jobStatus = JOB_STATUS_NEVER_SEEN;
-    json m_jobOutput; // Will store the output of jobs
+    JobResult m_jobResult = JOB_RESULT_NONE; // Set once the job completed. Also in "m_jobResults", for readers that do not want the lock.
+    int m_numaNode = -1; // NUMA node of the worker that ran the job, -1 if unknown
+    std::shared_ptr<const json> m_jobOutput; // Will store the output of jobs. Shared with the job and its dependents, never copied.
+    mutable std::shared_ptr<const std::string> m_serializedOutput; // The output as JSON text, made the first time someone asks for it through the C API
+};
+
+// Bounds the pool controller keeps the number of workers serving a channel within
+struct WorkerPoolChannelConfig
+{
+    WorkerPoolChannelConfig(unsigned long jobChannels, int minWorkers, int maxWorkers) : m_jobChannels(jobChannels), m_minWorkers(minWorkers), m_maxWorkers(maxWorkers) {}
+
+    unsigned long m_jobChannels = 0xFFFFFFFF;
+    int m_minWorkers = 1;
+    int m_maxWorkers = 1;
 };
 
 class Job; // Another forward declaration
 
+// The jobs of a fan-out: one job type and one input template, expanded over a list of items (see JobSystem::CreateJobFanOut)
+struct JobFanOut
+{
+    std::vector<Job*> m_jobs;
+};
+
 class JobSystem
 {
     friend JobWorkerThread;
+    friend JobReactor; // Completes the async jobs it resumes
 
 public:
     ~JobSystem();
@@ -50,23 +101,62 @@ public:
     int jobrunning = 0;
     int jobcompleted = 0;
     int jobretired = 0;
+    int jobskipped = 0;
+    int jobcancelled = 0;
+    int jobretried = 0; // Attempts that failed and were run again
+    int joblazy = 0; // Jobs of lazy graphs that were not created yet
+    int jobreused = 0; // Results of a previous run, recorded instead of running the job again (see RecordReusedJob)
 
     void FinishCompletedJobs();
     void FinishJob(int jobID);
+    bool FinishJobIfCompleted(int jobID); // Never waits. False if the job is not completed, or someone else finished it first.
 
     void CreateWorkerThread(const char *uniqueName, unsigned long workerJobChannels = 0xFFFFFFFF);
     void DestroyWorkerThread(const char *uniqueName);
+
+    // Worker pool sizing. The controller starts workers for a channel when ready jobs outnumber its idle
+    // workers, and retires workers that stayed idle, always staying within the channel's min and max.
+    void SetWorkerPoolLimits(unsigned long workerJobChannels, int minWorkers, int maxWorkers);
+    void CreateDefaultWorkerPool(); // Sizes the pool of each built-in channel from the number of hardware threads
+    void StartWorkerPoolController();
+    void StopWorkerPoolController();
+
+    // Which CPUs the workers of a channel get pinned to. Also applies to the channel's existing workers.
+    void SetWorkerPlacement(unsigned long workerJobChannels, WorkerPlacementPolicy policy, const std::vector<int>& cpuSet = {});
+    // Workers of the channel hand their jobs to a "jobworker" process each, instead of running them in this one.
+    // An empty path means the "jobworker.out" built next to the library. Also applies to the channel's existing workers.
+    void SetWorkerProcesses(unsigned long workerJobChannels, const std::string& executablePath = "");
+    json ExecuteJobRequest(const json& request); // What a "jobworker" process does with a job it receives. Returns the reply.
+    void InterruptJobRequest(); // Kills the child process of the job ExecuteJobRequest() is running, if any. It then fails.
     static const char* generateRandomThreadWorkerName(int length = 3); // I don't want to have to name them everytime I create a worker thread
     void QueueJob(Job *job); // Sets the status of the job to "QUEUED" and adds it to the "m_jobsQueued" vector.
-    json GetJsonJobOutputByID(int jobID) const;
+    std::shared_ptr<const json> GetJobOutputByID(int jobID) const; // nullptr until the job completed. Cheap: no copy of the output.
+    json GetJsonJobOutputByID(int jobID) const; // Same, but returns a (deep) copy
+    std::shared_ptr<const std::string> GetSerializedJobOutputByID(int jobID) const; // As JSON text. Serialized once, then cached.
 
     // Status Queries
     JobStatus GetJobStatus(int jobID) const;
     bool isJobComplete(int jobID) const; // OLD NAME: isComplete
+    JobResult GetJobResult(int jobID) const; // Lock-free. JOB_RESULT_NONE until the job completed (and for skipped jobs).
+
+    // NOTE:    Cancels a queued job, or interrupts a running one (its child process is killed, and it completes
+    //          as a failure, without retries). With "recursive", every queued job downstream is cancelled too,
+    //          in time proportional to their number. Otherwise, they are skipped once they come up, as jobs
+    //          depending on a cancelled job. Returns the number of jobs cancelled or interrupted.
+    int CancelJob(int jobID, bool recursive);
+    JobStatus WaitForJob(int jobID) const; // Blocks (politely) until the job is no longer queued or running
 
     void GetJobDetails() const;
 
+    // Factories that take the input as JSON text. It gets serialized for them every time a job is created.
     void RegisterJobType(const std::string& jobTypeIdentifier, std::function<Job* (const char*)> jobFactoryFunction){
+        RegisterJobType(jobTypeIdentifier, std::function<Job* (const json&)>([jobFactoryFunction](const json& jsonData){
+            return jobFactoryFunction(jsonData.dump().c_str());
+        }));
+    }
+
+    // Factories that take the input already parsed. What the built-in job types use.
+    void RegisterJobType(const std::string& jobTypeIdentifier, std::function<Job* (const json&)> jobFactoryFunction){
         auto it = m_jobTypeFactories.find(jobTypeIdentifier);
         if (it == m_jobTypeFactories.end()){
             // The identifier does not already exist, registration can take place
@@ -76,20 +166,109 @@ public:
         }
     }
 
+    void RegisterBuiltInJobTypes(); // Compile, parsing, JSON, conditional and compile unit jobs
+    Job* CreateJob(const std::string jobTypeIdentifier, std::shared_ptr<const json> jsonData); // The job keeps the input it was created from, without copying it
     Job* CreateJob(const std::string jobTypeIdentifier, const json& jsonData); // Returns an instance of a job based on type identifier. This function implements the FACTORY pattern.
 
+    // NOTE:    One job per item. Every "${item}" in the strings of the input template is replaced by the item,
+    //          and every "${index}" by its position. Nothing is queued. All or nothing: false (and no jobs) if the
+    //          job type is not registered or one of the jobs could not be created from its input.
+    bool CreateJobFanOut(const std::string& jobTypeIdentifier, const json& inputTemplate, const std::vector<std::string>& items, std::vector<Job*>& jobs);
+    static std::vector<std::string> ExpandFanOutPattern(const std::string& pattern); // The paths matching a glob pattern, sorted
+    static json InstantiateFanOutInput(const json& inputTemplate, const std::string& item, size_t index); // The input of one job of a fan-out
+
+    // NOTE:    Lazy job graphs. Their nodes get consecutive job IDs (returned: the first one, -1 if the graph was
+    //          not queued), and read as QUEUED right away, but a node's job is only created once every one of
+    //          its dependencies is done, and retired (freed) as soon as it completed. The jobs held in memory
+    //          follow the width of the graph, not its size. Not journaled: refused when the journal is enabled.
+    int QueueLazyJobGraph(std::shared_ptr<LazyJobGraph> graph);
+
     std::vector<std::string> GetRegisteredJobTypes() const; // Returns a list of registered job types in the job system
+    bool IsJobTypeRegistered(const std::string& jobTypeIdentifier) const;
+
+    // Token pool shared with every "make" spawned by compile jobs. Defaults to one token per hardware thread.
+    JobServer* GetJobServer();
+    void SetCompileParallelism(int numTokens);
+
+    // Resumes async jobs (see Job::AwaitReadable) once what they wait for is ready. Started the first time a job suspends.
+    JobReactor* GetJobReactor();
+
+    // Batched file reads and writes for the jobs (their output files, makefiles, sources). io_uring when the kernel has it.
+    FileIOService* GetFileIOService();
+
+    // Inputs and files many jobs share, kept once (see InternTable)
+    InternTable* GetInternTable() { return &m_internTable; }
+
+    BuildManifest* GetBuildManifest(); // What incremental compile jobs built, and from what. Persisted in "./Data/build_manifest.json"
+
+    void SetSchedulingMode(JobSchedulingMode schedulingMode);
+    JobSchedulingMode GetSchedulingMode() const;
+
+    // Write-ahead journal. Once enabled (before queuing any job), every submission and status change is logged.
+    // After a crash, recovering marks the jobs that completed as done, with their output, and re-queues the others.
+    bool EnableJournal(const std::string& journalPath);
+    int RecoverFromJournal(const std::string& journalPath); // Number of jobs found in the journal, -1 if there is none. Keeps journaling to it.
+    void SyncJournal(); // Blocks until everything journaled so far is on disk
+
+    // Incremental runs: a job whose result a previous run already has is never created. Its output is recorded
+    // as a retired job's, under a new ID, and jobs can depend on it (or be gated on it) like on any other.
+    int RecordReusedJob(int jobType, JobResult jobResult, const json& jobOutput);
+
+    // Keeps the status and output of every job in memory-mapped files, instead of in "m_jobHistory".
+    // Outputs of previous runs stay queryable by ID, and new jobs get IDs after theirs. Enable before creating jobs.
+    bool EnableHistoryStore(const std::string& folderPath);
+
+    // Lets another process submit jobs through a shared-memory ring (see jobring.h), and read their outputs back from it
+    bool EnableSubmissionRing(const std::string& ringName, uint64_t capacity);
 
 private:
     JobSystem();
     
-    Job* ClaimAJob(unsigned long workerJobFlags); // go through queued job, and find a job comp with a thread. And move the job queued to running queue
+    Job* ClaimAJob(unsigned long workerJobFlags, int workerNumaNode = -1); // go through queued job, and find a job comp with a thread. And move the job queued to running queue
+    bool IsJobInputOnNumaNode(const Job *job, int numaNode) const; // Did the job's (first) dependency run on this NUMA node?
+    bool IsDependencySatisfied(int jobID) const; // Completed, already retired, or skipped (then so are its dependents)
+    bool IsJobSkipped(const Job* job) const; // A dependency was skipped, or its gate's condition came out the other way
+    void SkipJobsNotTaken(const std::vector<int>& gatedJobIDs); // Skips the branch not taken, right away. Called when a conditional job completes, with the jobs that were waiting on it.
+    void SkipQueuedJobs(const std::vector<Job*>& jobsToSkip); // Expects "m_jobsQueuedMutex" to be held
+    void RetireSkippedJobs(const std::vector<Job*>& skippedJobs); // Once "m_jobsQueuedMutex" is released. Deletes them.
+    JobHistoryEntry& GetHistoryEntry(int jobID); // Grows the history up to "jobID" if needed. Expects "m_jobHistoryMutex" to be held.
+    void StoreHistoryEntry(const JobHistoryEntry& entry, bool clearOutput = false); // Mirrors the entry in the history store, if enabled. Expects "m_jobHistoryMutex" to be held.
+    bool ExecuteInWorkerProcess(Job *job, WorkerProcess *workerProcess); // False if the job has to run in this process
+    WorkerProcess* NewWorkerProcess(const std::string& executablePath); // Expects "m_workerThreadsMutex" to be held
     void OnJobCompleted(Job *jobJustExecuted); // when a thread completes the job, will mve from running queue to completed queue
+    void SuspendJob(Job *jobJustExecuted); // The job returned with a continuation: hand it to the reactor. It stays "RUNNING" meanwhile.
+    void DestroyWorkerThread(JobWorkerThread *doomedWorker);
+    void RetireIdleWorkerThread(unsigned long workerJobChannels, std::chrono::milliseconds idleDuration); // One worker of the channel, idle for that long. Does not wait for it.
+    void ReapRetiredWorkerThreads(); // Deletes the retired workers that exited
+    int CountReadyJobs(unsigned long workerJobChannels) const; // Number of queued jobs on these channels whose dependencies are done
+    void WorkerPoolControllerMain(); // Called in the controller thread, runs until StopWorkerPoolController() is called
+    void UpdateCriticalPaths(Job *queuedJob); // Propagates the critical path length of a newly queued job to the queued jobs it depends on. Expects "m_jobsQueuedMutex" to be held.
+    bool RetryJob(Job* failedJob); // Re-creates the job, to queue it again after its backoff. False if it cannot be re-created.
+    bool QueueJob(Job* job, bool unlessCancelled);
+    bool QueueLazyJob(Job* job); // QueueJob(), unless CancelJob() got to it while it was being created. False then: it is not queued.
+    Job* TakeCompletedJob(int jobID); // Out of "m_jobsCompleted", in one step: only one caller gets it. nullptr if it is not there.
+    void RetireCompletedJob(Job* completedJob); // Calls its callback, marks it RETIRED and deletes it. Once out of "m_jobsCompleted".
+    Job* CreateJob(const std::string& jobTypeIdentifier, std::shared_ptr<const json> jsonData, int jobID); // Under an ID it already has
+    std::shared_ptr<LazyJobGraph> FindLazyJobGraph(int jobID) const; // nullptr if the job is not part of one (anymore)
+    void OnLazyJobDone(int jobID); // Completed, skipped or cancelled. Creates and queues the jobs of its graph that only waited for it.
+    void CreateLazyJobs(const std::shared_ptr<LazyJobGraph>& graph, std::vector<int> readyNodes, bool isGraphDone);
+    void StartWatchdog(); // Started by the first job queued with a timeout or retries
+    void StopWatchdog(); // Jobs still waiting for their retry are dropped
+    void WatchdogMain(); // Called in the watchdog thread: times out running jobs, queues retries once their backoff is over
 
     static JobSystem *s_jobSystem;
 
     std::vector<JobWorkerThread *>      m_workerThreads;
+    std::vector<JobWorkerThread *>      m_retiredWorkerThreads; // Retired by the pool controller, deleted once they exited. Guarded by "m_workerThreadsMutex"
     mutable std::mutex                  m_workerThreadsMutex;
+
+    std::vector< WorkerPoolChannelConfig > m_workerPoolConfigs; // Guarded by "m_workerThreadsMutex"
+    std::map< unsigned long, WorkerPlacementConfig > m_workerPlacementConfigs; // Guarded by "m_workerThreadsMutex"
+    WorkerPlacement                     m_workerPlacement; // Guarded by "m_workerThreadsMutex"
+    std::map< unsigned long, std::string > m_workerProcessPaths; // Channels served by worker processes -> their executable. Guarded by "m_workerThreadsMutex"
+    std::thread*                        m_poolControllerThread = nullptr;
+    bool                                m_isPoolControllerStopping = false;
+    mutable std::mutex                  m_poolControllerMutex;
     std::deque< Job* >                  m_jobsQueued;
     std::deque< Job* >                  m_jobsRunning;
     std::deque< Job* >                  m_jobsCompleted;
@@ -97,16 +276,58 @@ private:
     mutable std::mutex                  m_jobsRunningMutex;
     mutable std::mutex                  m_jobsCompletedMutex;
 
-    std::vector< JobHistoryEntry >      m_jobHistory;
+    JobSchedulingMode                   m_schedulingMode = JOB_SCHEDULING_FIFO;
+    std::map< int, Job* >               m_jobsQueuedByID;       // Guarded by "m_jobsQueuedMutex"
+    std::map< int, std::vector<int> >   m_queuedDependents;     // Job ID -> IDs of the queued jobs waiting on it, until it completes. Guarded by "m_jobsQueuedMutex"
+
+    std::thread*                        m_watchdogThread = nullptr;
+    bool                                m_isWatchdogStopping = false;
+    std::multimap< std::chrono::steady_clock::time_point, Job* > m_jobsAwaitingRetry; // By when they are queued again. Guarded by "m_watchdogMutex"
+    std::mutex                          m_watchdogMutex;
+    std::condition_variable             m_watchdogSignal;
+
+    std::map< int, std::shared_ptr<LazyJobGraph> > m_lazyJobGraphs; // By first job ID, until all of their jobs are done
+    mutable std::mutex                  m_lazyJobGraphsMutex;
+
+    Job*                                m_jobRequestJob = nullptr; // The one ExecuteJobRequest() is running
+    std::mutex                          m_jobRequestMutex;
+
+    std::vector< JobHistoryEntry >      m_jobHistory; // Indexed by job ID. IDs that were never queued hold a NEVER_SEEN entry.
     mutable int                         m_jobHistoryLowestActiveIndex = 0; // The index of the oldest thread that is still running. Because JobID will only keep increasing.
     mutable std::mutex                  m_jobHistoryMutex;
+    JobResultTable                      m_jobResults; // Job ID -> result. Not guarded: see JobResultTable.
+
+    JobServer*                          m_jobServer = nullptr;
+    bool                                m_mayHaveLostJobServerTokens = false; // An interrupted job completed since the pool was last refilled. Under "m_jobsRunningMutex".
+    std::mutex                          m_jobServerMutex;
+
+    JobReactor*                         m_jobReactor = nullptr;
+    std::mutex                          m_jobReactorMutex;
+
+    FileIOService*                      m_fileIOService = nullptr;
+    std::mutex                          m_fileIOServiceMutex;
+
+    InternTable                         m_internTable;
+
+    BuildManifest*                      m_buildManifest = nullptr;
+    std::mutex                          m_buildManifestMutex;
+
+    JobJournal*                         m_journal = nullptr; // Only set before jobs get queued
+    JobHistoryStore*                    m_historyStore = nullptr; // Same
+
+    std::vector< JobRingServer* >       m_ringServers;
+    std::mutex                          m_ringServersMutex;
 
-    std::map<std::string, std::function<Job* (const char*)> > m_jobTypeFactories; // associate a string, with a function template that can store callable (function in our case) that takes a constant ref to a JSON and returns a pointer to a Job instance.
+    std::map<std::string, std::function<Job* (const json&)> > m_jobTypeFactories; // associate a string, with a function template that can store callable (function in our case) that takes a constant ref to a JSON and returns a pointer to a Job instance.
 };
 
 // Define JobSystemHandle and JobHandle as void pointers
 typedef void* JobSystemHandle;
 typedef void* JobHandle;
+typedef void* JobRingHandle;
+typedef void* JobFanOutHandle;
+typedef void* LazyJobGraphHandle;
+typedef void* FlowScriptTokensHandle;
 
 extern "C"{
     // Start - Destroy job system
@@ -115,15 +336,94 @@ extern "C"{
 
     // Create worker threads
     void CreateWorkerThreads(JobSystemHandle jobSystem);
+    void SetWorkerPoolLimits(JobSystemHandle jobSystem, unsigned long workerJobChannels, int minWorkers, int maxWorkers);
+    void StartWorkerPoolController(JobSystemHandle jobSystem);
+    void StopWorkerPoolController(JobSystemHandle jobSystem);
+    void SetWorkerPlacement(JobSystemHandle jobSystem, unsigned long workerJobChannels, int placementPolicy, const char* cpuList);
+    void SetWorkerProcesses(JobSystemHandle jobSystem, unsigned long workerJobChannels, const char* executablePath); // nullptr for the default "jobworker.out"
 
     // Create, Complete, queue, query status jobs, add dependency
     JobHandle CreateJob(JobSystemHandle jobsystem, const char* jobTypeIdentifier, const char* jsonData);
+    JobHandle CreateJobFromBinary(JobSystemHandle jobsystem, const char* jobTypeIdentifier, const unsigned char* data, size_t dataSize, int dataFormat);
+    // Encodes the output of a completed job. Returns its size, and copies it if "buffer" is big enough. -1 if there is no output (yet).
+    long long GetJobOutputEncoded(JobSystemHandle jobsystem, int jobID, int dataFormat, unsigned char* buffer, size_t bufferSize);
+
+    // Output of a completed job, as JSON text, in a buffer the caller owns. Sizes do not count the terminating NUL.
+    long long GetJobOutputSize(JobSystemHandle jobsystem, int jobID); // -1 if there is no output (yet)
+    long long GetJobOutput(JobSystemHandle jobsystem, int jobID, char* buffer, size_t bufferSize); // Copies (with a NUL) only if it fits. Returns the size.
+    // Packs the outputs of many jobs back to back (each NUL terminated) in one call. For each job: its offset in
+    // "buffer" (-1 if it did not fit or has no output) and its size (-1 if it has no output). Returns the bytes needed for all of them.
+    long long GetJobOutputs(JobSystemHandle jobsystem, const int* jobIDs, int numJobs, char* buffer, size_t bufferSize, long long* offsets, long long* sizes);
     void FinishJob(JobSystemHandle jobsystem, int jobID);
     void FinishCompletedJobs(JobSystemHandle jobsystem);
     void QueueJob(JobSystemHandle jobsystem, JobHandle jobHandle);
     int GetJobStatus(JobSystemHandle jobsystem, int jobID);
+    int GetJobResult(JobSystemHandle jobsystem, int jobID); // JobResult. Does not take any lock.
+    int CancelJob(JobSystemHandle jobsystem, int jobID, int recursive); // Number of jobs cancelled (or interrupted)
     int GetJobID(JobSystemHandle jobsystem, JobHandle jobHandle);
     void AddDependency(JobHandle dependentHandle, JobHandle dependencyHandle);
+    void SetJobPriority(JobHandle jobHandle, int priority);
+    void SetJobTimeout(JobHandle jobHandle, int timeoutMs); // 0: none
+    void SetJobRetries(JobHandle jobHandle, int maxRetries, int backoffMs);
+    // The job runs only if the conditional job's condition comes out as "runIfConditionMet" (0 or 1). Skipped otherwise.
+    void SetJobGate(JobHandle jobHandle, JobHandle conditionalJobHandle, int runIfConditionMet);
+    // Same, on jobs known by ID only (reused ones, see RecordReusedJob)
+    void AddDependencyByID(JobHandle dependentHandle, int dependencyJobID);
+    void SetJobGateByID(JobHandle jobHandle, int conditionalJobID, int runIfConditionMet);
+    int RecordReusedJob(JobSystemHandle jobsystem, int jobType, int jobResult, const char* jobOutput); // Its job ID. -1 if the output is not JSON.
+
+    // Fan-outs: many jobs from one template, in one call. Over "items", or over the paths matching "globPattern" when it is not null.
+    // nullptr if the job type is not registered, the input template is not JSON, or if one of its jobs could not be created. Queuing the fan-out queues all of its jobs, and frees the handle.
+    JobFanOutHandle CreateJobFanOut(JobSystemHandle jobsystem, const char* jobTypeIdentifier, const char* inputTemplate, const char* const* items, int numItems, const char* globPattern);
+    int GetJobFanOutSize(JobFanOutHandle fanOutHandle);
+    int GetJobFanOutIDs(JobFanOutHandle fanOutHandle, int* jobIDs, int maxJobIDs); // Copies up to "maxJobIDs" of them. Returns how many there are.
+    void AddDependencyToFanOut(JobFanOutHandle dependentsHandle, JobHandle dependencyHandle); // Every job of the fan-out waits for the job
+    void AddFanOutDependency(JobHandle dependentHandle, JobFanOutHandle dependenciesHandle); // The job waits for every job of the fan-out (a join)
+    void AddFanOutToFanOutDependency(JobFanOutHandle dependentsHandle, JobFanOutHandle dependenciesHandle);
+    void SetJobFanOutPriority(JobFanOutHandle fanOutHandle, int priority);
+    void SetJobFanOutGate(JobFanOutHandle fanOutHandle, JobHandle conditionalJobHandle, int runIfConditionMet);
+    void AddDependencyByIDToFanOut(JobFanOutHandle dependentsHandle, int dependencyJobID);
+    void SetJobFanOutGateByID(JobFanOutHandle fanOutHandle, int conditionalJobID, int runIfConditionMet);
+    void QueueJobFanOut(JobSystemHandle jobsystem, JobFanOutHandle fanOutHandle);
+
+    // Lazy job graphs: nodes are added by index (0, 1, ...), and only turned into jobs once they can run (see JobSystem::QueueLazyJobGraph)
+    LazyJobGraphHandle CreateLazyJobGraph();
+    int AddLazyGraphJob(LazyJobGraphHandle graphHandle, const char* jobTypeIdentifier, const char* jsonData, int priority); // Index of the node. -1 if the input is not JSON.
+    // One node per item (or per path matching "globPattern"), at consecutive indices. Returns how many, and the first index in "firstNode".
+    // -1 (and no node added) if the input template is not JSON, or if the graph cannot take them all.
+    int AddLazyGraphFanOut(LazyJobGraphHandle graphHandle, const char* jobTypeIdentifier, const char* inputTemplate, const char* const* items, int numItems, const char* globPattern, int priority, int* firstNode);
+    void AddLazyGraphDependencies(LazyJobGraphHandle graphHandle, const int* dependencyNodes, const int* dependentNodes, int numDependencies);
+    void SetLazyGraphGate(LazyJobGraphHandle graphHandle, int node, int conditionalNode, int runIfConditionMet);
+    int QueueLazyJobGraph(JobSystemHandle jobsystem, LazyJobGraphHandle graphHandle); // Job ID of node 0, the others follow. -1 if not queued. Frees the handle.
+    void SetSchedulingMode(JobSystemHandle jobsystem, int schedulingMode);
+    void SetCompileParallelism(JobSystemHandle jobsystem, int numTokens);
+
+    // FlowScript, tokenized natively (see FlowScriptScanner). Does not need (or start) a job system.
+    FlowScriptTokensHandle ScanFlowScriptFile(const char* scriptPath); // nullptr if the file cannot be read
+    int GetFlowScriptNumTokens(FlowScriptTokensHandle tokens);
+    // The arrays: type, offset and length (in bytes, in the source) and line of every token. Valid until the handle is freed.
+    void GetFlowScriptTokenArrays(FlowScriptTokensHandle tokens, const uint8_t** types, const uint32_t** offsets, const uint32_t** lengths, const uint32_t** lines);
+    const char* GetFlowScriptSource(FlowScriptTokensHandle tokens, size_t* sourceSize); // The mapped file
+    int GetFlowScriptNumErrors(FlowScriptTokensHandle tokens);
+    const char* GetFlowScriptError(FlowScriptTokensHandle tokens, int errorIndex, int* line);
+    void FreeFlowScriptTokens(FlowScriptTokensHandle tokens);
+
+    // Crash recovery
+    int EnableJobJournal(JobSystemHandle jobsystem, const char* journalPath);
+    int RecoverFromJournal(JobSystemHandle jobsystem, const char* journalPath);
+    void SyncJobJournal(JobSystemHandle jobsystem);
+    int EnableJobHistoryStore(JobSystemHandle jobsystem, const char* folderPath);
+
+    // Submission from other processes, through shared memory. The job system creates the ring, a client opens it by name.
+    int EnableJobSubmissionRing(JobSystemHandle jobsystem, const char* ringName, unsigned long long capacity);
+    JobRingHandle OpenJobRing(const char* ringName); // Client side. Does not need (or start) a job system.
+    void CloseJobRing(JobRingHandle ring);
+    // 1 if it was submitted, 0 if the ring is full for now, -1 if it can never fit
+    int SubmitJobToRing(JobRingHandle ring, unsigned long long tag, const char* jobTypeIdentifier, const unsigned char* input, size_t inputSize, int inputFormat,
+                        const unsigned long long* dependencyTags, int numDependencies, int priority);
+    // Next completion: -1 if there is none yet. Otherwise the size of its output, copied if "buffer" is big enough.
+    // When it is not, the completion stays in the ring (call again with a bigger buffer) and only "tag", "jobID" and "jobStatus" are set.
+    long long PollJobRingCompletion(JobRingHandle ring, unsigned long long* tag, int* jobID, int* jobStatus, unsigned char* buffer, size_t bufferSize);
 
     // Register job types
     void RegisterJobType(JobSystemHandle jobsystem, const char* jobIdentifier, void* (*jobFactoryFunction)(const char*));
@@ -0,0 +1,328 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "jobsystemdaemon.h"
+#include "jobsystem.h"
+#include "workerprocess.h"
+#include "job.h"
+
+JobSystemDaemon::JobSystemDaemon(JobSystem* jobSystem, const std::string& socketPath): m_jobSystem(jobSystem), m_socketPath(socketPath) {}
+
+JobSystemDaemon::~JobSystemDaemon(){
+    RequestShutdown();
+
+    // Wake the client threads up from their recv(), then wait for them
+    m_clientsMutex.lock();
+    for(int clientFD: m_clientFDs){
+        shutdown(clientFD, SHUT_RDWR);
+    }
+    std::vector<std::thread*> clientThreads;
+    clientThreads.swap(m_clientThreads);
+    m_clientsMutex.unlock();
+
+    for(std::thread* clientThread: clientThreads){
+        clientThread->join();
+        delete clientThread;
+    }
+
+    if(m_listenFD >= 0){
+        close(m_listenFD);
+        m_listenFD = -1;
+        unlink(m_socketPath.c_str());
+    }
+}
+
+bool JobSystemDaemon::Listen(){
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(m_socketPath.size() >= sizeof(address.sun_path)){
+        std::cerr << "Error: The daemon socket path is too long: " << m_socketPath << std::endl;
+        return false;
+    }
+    strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    // A socket file left behind is only stale if nobody answers on it
+    int probeFD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(probeFD >= 0 && connect(probeFD, (sockaddr*)&address, sizeof(address)) == 0){
+        close(probeFD);
+        std::cerr << "Error: A daemon already listens on " << m_socketPath << std::endl;
+        return false;
+    }
+    if(probeFD >= 0){
+        close(probeFD);
+    }
+    unlink(m_socketPath.c_str());
+
+    m_listenFD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(m_listenFD < 0 || bind(m_listenFD, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_listenFD, 16) != 0){
+        std::cerr << "Error: Unable to listen on " << m_socketPath << " (" << strerror(errno) << ")" << std::endl;
+        if(m_listenFD >= 0){
+            close(m_listenFD);
+            m_listenFD = -1;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void JobSystemDaemon::RequestShutdown(){
+    m_isStopping = true;
+    if(m_listenFD >= 0){
+        shutdown(m_listenFD, SHUT_RDWR); // accept() returns right away
+    }
+}
+
+void JobSystemDaemon::Serve(){
+    while(!m_isStopping){
+        int clientFD = accept4(m_listenFD, nullptr, nullptr, SOCK_CLOEXEC);
+        if(clientFD < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            break; // Shut down
+        }
+
+        m_clientsMutex.lock();
+        ReapFinishedClientThreads();
+        m_clientFDs.push_back(clientFD);
+        m_clientThreads.push_back(new std::thread(&JobSystemDaemon::ServeClient, this, clientFD));
+        m_clientsMutex.unlock();
+    }
+}
+
+void JobSystemDaemon::ServeClient(int clientFD){
+    json request;
+    int dataFormat = JOB_DATA_FORMAT_MSGPACK;
+    while(!m_isStopping && ReadJobFrame(clientFD, request, &dataFormat)){
+        json reply;
+        try {
+            reply = HandleRequest(request);
+        } catch (const json::exception& exception) {
+            reply = { {"error", std::string("Malformed request: ") + exception.what()} };
+        }
+
+        if(!WriteJobFrame(clientFD, reply, dataFormat)){
+            break;
+        }
+        if(request.value("op", "") == "shutdown"){
+            RequestShutdown();
+        }
+    }
+
+    m_clientsMutex.lock();
+    m_clientFDs.erase(std::remove(m_clientFDs.begin(), m_clientFDs.end(), clientFD), m_clientFDs.end());
+    m_finishedClientThreadIDs.push_back(std::this_thread::get_id()); // Joined by the next accept(), or at shutdown
+    m_clientsMutex.unlock();
+    close(clientFD);
+}
+
+void JobSystemDaemon::ReapFinishedClientThreads(){
+    // NOTE: A daemon lives for many runs. Without this, every client it ever had kept its thread (and stack) until shutdown.
+    for(std::thread::id finishedThreadID: m_finishedClientThreadIDs){
+        for(auto threadIter = m_clientThreads.begin(); threadIter != m_clientThreads.end(); ++threadIter){
+            if((*threadIter)->get_id() == finishedThreadID){
+                (*threadIter)->join(); // It is returning already
+                delete *threadIter;
+                m_clientThreads.erase(threadIter);
+                break;
+            }
+        }
+    }
+    m_finishedClientThreadIDs.clear();
+}
+
+json JobSystemDaemon::HandleRequest(const json& request){
+    std::string op = request.value("op", "");
+    std::vector<int> jobIDs = request.value("ids", std::vector<int>());
+
+    if(op == "submit"){
+        return Submit(request);
+    }
+    else if(op == "status" || op == "wait"){
+        json statuses = json::array();
+        for(int jobID: jobIDs){
+            statuses.push_back(op == "wait" ? m_jobSystem->WaitForJob(jobID) : m_jobSystem->GetJobStatus(jobID));
+        }
+        if(op == "wait"){
+            return { {"statuses", statuses} };
+        }
+
+        json results = json::array();
+        for(int jobID: jobIDs){
+            results.push_back(m_jobSystem->GetJobResult(jobID));
+        }
+        return { {"statuses", statuses}, {"results", results} };
+    }
+    else if(op == "outputs"){
+        json outputs = json::array();
+        for(int jobID: jobIDs){
+            std::shared_ptr<const json> jobOutput = m_jobSystem->GetJobOutputByID(jobID);
+            outputs.push_back(jobOutput ? *jobOutput : json());
+        }
+        return { {"outputs", outputs} };
+    }
+    else if(op == "finish"){
+        // Only the completed ones: FinishJob() would wait for the others, and hold up this client. Another
+        // client (or a job ring) finishing the same job at the same time gets it, or we do: never both.
+        json finishedIDs = json::array();
+        for(int jobID: jobIDs){
+            if(m_jobSystem->FinishJobIfCompleted(jobID)){
+                finishedIDs.push_back(jobID);
+            }
+        }
+        return { {"finished", finishedIDs} };
+    }
+    else if(op == "cancel"){
+        bool isRecursive = request.value("recursive", true);
+        int numCancelledJobs = 0;
+        for(int jobID: jobIDs){
+            numCancelledJobs += m_jobSystem->CancelJob(jobID, isRecursive);
+        }
+        return { {"cancelled", numCancelledJobs} };
+    }
+    else if(op == "job_types"){
+        return { {"jobTypes", m_jobSystem->GetRegisteredJobTypes()} };
+    }
+    else if(op == "ping"){
+        m_clientsMutex.lock();
+        int numClients = (int)m_clientFDs.size();
+        m_clientsMutex.unlock();
+
+        std::error_code errorCode;
+        return {
+            {"pid", (int)getpid()},
+            {"cwd", std::filesystem::current_path(errorCode).string()},
+            {"uptimeSeconds", std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - m_startTime).count()},
+            {"numClients", numClients}
+        };
+    }
+    else if(op == "shutdown"){
+        return json::object();
+    }
+
+    return { {"error", "Unknown op '" + op + "'"} };
+}
+
+// NOTE:    Creates every job before queuing any, so a submission with one bad job type (or a
+//          dependency on a name it does not have) leaves nothing half-queued behind it.
+json JobSystemDaemon::Submit(const json& request){
+    const json& jobDescriptions = request.at("jobs");
+
+    // NOTE: One group per description. Just one job, unless the description is a fan-out.
+    std::vector< std::vector<Job*> > jobGroups;
+    json jobIDs = json::object();
+    std::map< std::string, std::vector<int> > groupIDs;
+    std::string error;
+
+    // NOTE:    A malformed description (a "foreach" that is not a list of strings, a priority that is not a
+    //          number...) throws. Caught here rather than by ServeClient(), so the jobs created before it are deleted.
+    try {
+        for(const json& jobDescription: jobDescriptions){
+            std::string name = jobDescription.value("name", std::to_string(jobGroups.size()));
+            std::string jobTypeIdentifier = jobDescription.value("jobTypeIdentifier", "");
+            const json input = jobDescription.contains("input") ? jobDescription["input"] : json::object();
+            if(!m_jobSystem->IsJobTypeRegistered(jobTypeIdentifier)){
+                error = "Job '" + name + "' has an unknown job type";
+                break;
+            }
+
+            std::vector<Job*> jobGroup;
+            if(jobDescription.contains("foreach")){
+                const json& foreach = jobDescription["foreach"];
+                std::vector<std::string> items = foreach.is_string() ? JobSystem::ExpandFanOutPattern(foreach.get<std::string>()) : foreach.get< std::vector<std::string> >();
+                if(!m_jobSystem->CreateJobFanOut(jobTypeIdentifier, input, items, jobGroup)){
+                    error = "Job '" + name + "' could not be created from its input, for one of its items";
+                    break;
+                }
+            } else if(Job* job = m_jobSystem->CreateJob(jobTypeIdentifier, input)){
+                jobGroup.push_back(job);
+            } else {
+                error = "Job '" + name + "' could not be created from its input";
+                break;
+            }
+
+            jobGroups.push_back(jobGroup); // From here on, deleted with the others if the submission is rejected
+
+            std::vector<int>& ids = groupIDs[name];
+            for(Job* job: jobGroup){
+                job->SetPriority(jobDescription.value("priority", 0));
+                ids.push_back(job->GetUniqueID());
+            }
+
+            if(jobDescription.contains("foreach")){
+                jobIDs[name] = ids;
+            } else {
+                jobIDs[name] = ids.front();
+            }
+        }
+
+        for(size_t i = 0; error.empty() && i < jobGroups.size(); i++){
+            const json& jobDescription = jobDescriptions[i];
+            if(!jobDescription.contains("dependencies")){
+                continue;
+            }
+
+            for(const json& dependency: jobDescription["dependencies"]){
+                std::vector<int> dependencyIDs;
+                if(dependency.is_number_integer()){
+                    dependencyIDs.push_back(dependency.get<int>());
+                } else if(dependency.is_string() && groupIDs.count(dependency.get<std::string>())){
+                    dependencyIDs = groupIDs[dependency.get<std::string>()];
+                } else {
+                    error = "Job '" + jobDescription.value("name", std::to_string(i)) + "' depends on an unknown job: " + dependency.dump();
+                    break;
+                }
+
+                for(Job* job: jobGroups[i]){
+                    for(int dependencyID: dependencyIDs){
+                        job->AddDependency(dependencyID);
+                    }
+                }
+            }
+
+            if(error.empty() && jobDescription.contains("gate")){
+                const json& gate = jobDescription["gate"];
+                const json gateJob = gate.value("job", json());
+                int gateJobID = -1;
+                if(gateJob.is_number_integer()){
+                    gateJobID = gateJob.get<int>();
+                } else if(gateJob.is_string() && groupIDs.count(gateJob.get<std::string>()) && groupIDs[gateJob.get<std::string>()].size() == 1){
+                    gateJobID = groupIDs[gateJob.get<std::string>()].front();
+                } else {
+                    error = "Job '" + jobDescription.value("name", std::to_string(i)) + "' is gated on an unknown (or fan-out) job: " + gateJob.dump();
+                    break;
+                }
+
+                for(Job* job: jobGroups[i]){
+                    job->SetGate(gateJobID, gate.value("runIfConditionMet", true));
+                }
+            }
+        }
+    } catch (const json::exception& exception) {
+        error = std::string("Malformed request: ") + exception.what();
+    }
+
+    if(!error.empty()){
+        for(const std::vector<Job*>& jobGroup: jobGroups){
+            for(Job* job: jobGroup){
+                delete job;
+            }
+        }
+        return { {"error", error} };
+    }
+
+    for(const std::vector<Job*>& jobGroup: jobGroups){
+        for(Job* job: jobGroup){
+            m_jobSystem->QueueJob(job);
+        }
+    }
+    return { {"jobIDs", jobIDs} };
+}
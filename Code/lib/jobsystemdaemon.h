@@ -0,0 +1,59 @@
+// Serves a job system on a Unix domain socket, so short-lived clients (FlowScript runs) share one long-lived, warm job system
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+class JobSystem;
+
+// NOTE:    Same frames as the worker processes (see workerprocess.h): size, encoding, message. Every
+//          request is a map with an "op", and gets one reply, in the encoding the request came in, so a
+//          client without MessagePack can talk JSON. Replies to requests that failed have an "error".
+//
+//          "submit"    {"jobs": [{"name", "jobTypeIdentifier", "input", "dependencies", "priority"}]}
+//                      Dependencies are names of jobs in the same submission, or IDs of jobs submitted
+//                      before. All the jobs are queued, or none are. -> {"jobIDs": {name: ID}}
+//                      With "foreach" (a list of items, or a glob pattern), the description is a fan-out:
+//                      one job per item (see JobSystem::CreateJobFanOut), and its name maps to their IDs.
+//                      With "gate" {"job": name or ID, "runIfConditionMet"}, it is a branch of a conditional job.
+//          "status"    {"ids": [...]}  -> {"statuses": [...], "results": [...]}, see JobStatus and JobResult
+//          "wait"      {"ids": [...]}  -> {"statuses": [...]}, once none of them is queued or running
+//          "outputs"   {"ids": [...]}  -> {"outputs": [...]}, null for jobs without output (yet)
+//          "finish"    {"ids": [...]}  -> {"finished": [...]}, the completed ones, now retired
+//          "cancel"    {"ids": [...], "recursive"} -> {"cancelled": number of jobs cancelled or interrupted}
+//          "job_types"                 -> {"jobTypes": [...]}
+//          "ping"                      -> {"pid", "cwd", "uptimeSeconds", "numClients"}
+//          "shutdown"                  -> {} then the daemon stops
+class JobSystemDaemon
+{
+public:
+    JobSystemDaemon(JobSystem* jobSystem, const std::string& socketPath);
+    ~JobSystemDaemon(); // Disconnects the clients, and removes the socket
+
+    bool Listen(); // False if the socket cannot be created, or another daemon already listens on it
+    void Serve(); // Accepts clients until RequestShutdown()
+    void RequestShutdown(); // Safe to call from a signal handler
+
+private:
+    void ServeClient(int clientFD); // Called in the client's thread, until it disconnects
+    void ReapFinishedClientThreads(); // Joins the threads of the clients that disconnected. Expects "m_clientsMutex" to be held.
+    json HandleRequest(const json& request);
+    json Submit(const json& request);
+
+    JobSystem*                  m_jobSystem;
+    std::string                 m_socketPath;
+    int                         m_listenFD = -1;
+    std::atomic<bool>           m_isStopping{false};
+    std::chrono::steady_clock::time_point m_startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread*>   m_clientThreads;
+    std::vector<std::thread::id> m_finishedClientThreadIDs; // Their client disconnected, not joined yet
+    std::vector<int>            m_clientFDs;
+    std::mutex                  m_clientsMutex;
+};
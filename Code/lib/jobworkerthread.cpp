@@ -17,22 +17,77 @@ JobWorkerThread::~JobWorkerThread(){
     m_thread->join();
     delete m_thread;
     m_thread = nullptr;
+
+    delete m_workerProcess; // Only once the thread is done with it
+    m_workerProcess = nullptr;
 }
 
 void JobWorkerThread::StartUp(){
+    m_workerStatusMutex.lock();
     m_thread = new std::thread(WorkerThreadMain, this);
+    if(!m_cpuAffinity.empty()){
+        PinThreadToCpus(*m_thread, m_cpuAffinity);
+    }
+    m_workerStatusMutex.unlock();
 }
 
+// NOTE:    Linux hands out memory pages from the NUMA node of the CPU that first touches them.
+//          Once a worker is pinned to one node, everything a job allocates while executing on it
+//          (its output in particular) lives on that node, without having to go through libnuma.
+void JobWorkerThread::SetCpuAffinity(const std::vector<int>& cpuIDs){
+    m_workerStatusMutex.lock();
+    m_cpuAffinity = cpuIDs;
+    m_numaNode = GetNumaNodeOfCpus(cpuIDs);
+    if(m_thread != nullptr){
+        if(cpuIDs.empty()){
+            // Un-pin: allow every CPU again
+            std::vector<int> allCpus;
+            for(const CpuInfo& cpu: CpuTopology::Get().GetCpus()){
+                allCpus.push_back(cpu.m_cpuID);
+            }
+            PinThreadToCpus(*m_thread, allCpus);
+        } else {
+            PinThreadToCpus(*m_thread, cpuIDs);
+        }
+    }
+    m_workerStatusMutex.unlock();
+}
+
+// NOTE:    The job is claimed under "m_workerStatusMutex", and the worker marked busy right away. It used to be
+//          marked once the claim returned: in between, the pool controller could pick it to be retired, and then
+//          wait for the job it had just claimed (a whole compile, maybe) before it could size any pool again.
 void JobWorkerThread::Work(){
-    while(!isStopping()){
+    while(true){
         m_workerStatusMutex.lock();
+        if(m_isStopping){
+            m_workerStatusMutex.unlock();
+            break;
+        }
         unsigned long workerJobChannels = m_workerJobChannels;
+        int numaNode = m_numaNode;
+        WorkerProcess* workerProcess = m_workerProcess;
+
+        Job* job = m_jobSystem->ClaimAJob(workerJobChannels, numaNode); //this thread wants to get a job... given the channels. If there is a job with compatible channels, the thread get it
+        if(job){
+            m_isBusy = true;
+        }
         m_workerStatusMutex.unlock();
 
-        Job* job = m_jobSystem->ClaimAJob(m_workerJobChannels); //this thread wants to get a job... given the channels. If there is a job with compatible channels, the thread get it
         if(job){ // IF we get a thread
-            job->Execute();
-            m_jobSystem->OnJobCompleted(job); // Update the status of this job. the job is moved from running queue to completed queue. Call the job system to perform this move.
+            if(workerProcess == nullptr || !m_jobSystem->ExecuteInWorkerProcess(job, workerProcess)){
+                job->Execute();
+            }
+
+            if(job->IsSuspended()){
+                m_jobSystem->SuspendJob(job); // Async job waiting on something: the reactor completes it, we move on
+            } else {
+                m_jobSystem->OnJobCompleted(job); // Update the status of this job. the job is moved from running queue to completed queue. Call the job system to perform this move.
+            }
+
+            m_workerStatusMutex.lock();
+            m_isBusy = false;
+            m_lastBusyTime = std::chrono::steady_clock::now();
+            m_workerStatusMutex.unlock();
         }
 
         std::this_thread::sleep_for( std::chrono::microseconds(1) ); // Rest a little bit. To reliquishing control a little bit to the CPU. We don't want to poll jobs to quickly as well.
@@ -54,13 +109,63 @@ bool JobWorkerThread::isStopping() const {
     return shouldClose;
 }
 
+bool JobWorkerThread::isIdleFor(std::chrono::milliseconds duration) const {
+    m_workerStatusMutex.lock();
+    bool isIdle = !m_isBusy && (std::chrono::steady_clock::now() - m_lastBusyTime) >= duration;
+    m_workerStatusMutex.unlock();
+
+    return isIdle;
+}
+
+bool JobWorkerThread::TryRetire(std::chrono::milliseconds idleDuration){
+    m_workerStatusMutex.lock();
+    bool isRetired = !m_isStopping && !m_isBusy && (std::chrono::steady_clock::now() - m_lastBusyTime) >= idleDuration;
+    if(isRetired){
+        m_isStopping = true; // It claims nothing more, and exits on its own
+    }
+    m_workerStatusMutex.unlock();
+
+    return isRetired;
+}
+
+bool JobWorkerThread::HasExited() const {
+    m_workerStatusMutex.lock();
+    bool hasExited = m_hasExited;
+    m_workerStatusMutex.unlock();
+
+    return hasExited;
+}
+
+unsigned long JobWorkerThread::GetWorkerJobChannels() const {
+    m_workerStatusMutex.lock();
+    unsigned long workerJobChannels = m_workerJobChannels;
+    m_workerStatusMutex.unlock();
+
+    return workerJobChannels;
+}
+
 void JobWorkerThread::SetWorkerJobChannels(unsigned long workerJobChannels){
     m_workerStatusMutex.lock();
     m_workerJobChannels = workerJobChannels;
     m_workerStatusMutex.unlock();
 }
 
+void JobWorkerThread::SetWorkerProcess(WorkerProcess* workerProcess){
+    m_workerStatusMutex.lock();
+    if(m_workerProcess == nullptr){
+        m_workerProcess = workerProcess;
+        workerProcess = nullptr;
+    }
+    m_workerStatusMutex.unlock();
+
+    delete workerProcess; // Never started, nothing to wait for
+}
+
 void JobWorkerThread::WorkerThreadMain(void* workThreadObject){
     JobWorkerThread* thisWorker = (JobWorkerThread*) workThreadObject; // cast void pointer into workerthread object. It gives you the size, the offest, memeber functions etc. A void pointer is ptr to anything. It just a starting point. It could be anything. But casting, makes sure we are dealing with the workerthread object
     thisWorker->Work();
+
+    thisWorker->m_workerStatusMutex.lock();
+    thisWorker->m_hasExited = true;
+    thisWorker->m_workerStatusMutex.unlock();
 }
\ No newline at end of file
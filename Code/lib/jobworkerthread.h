@@ -5,8 +5,11 @@
 #include <deque>
 #include <vector>
 #include <thread>
+#include <chrono>
 
 #include "job.h"
+#include "workerplacement.h"
+#include "workerprocess.h"
 
 class JobSystem; // pointer... its is a forward class declaration... promise to the compiler... that it will find the definition to this object
 // the compiler will trust you... if it don't find it we get a linker error.
@@ -24,14 +27,26 @@ private:
     void ShutDown(); // Signal that work should at next opportunity
 
     bool isStopping() const;
+    bool isIdleFor(std::chrono::milliseconds duration) const; // True when the worker has not been running a job for at least "duration"
+    bool TryRetire(std::chrono::milliseconds idleDuration); // Stops the worker if it was idle for that long. Never one that just claimed a job.
+    bool HasExited() const; // Its thread is done: deleting it does not block
+    unsigned long GetWorkerJobChannels() const;
+    void SetCpuAffinity(const std::vector<int>& cpuIDs); // Pins the worker to these CPUs. Empty lets it run anywhere.
     void SetWorkerJobChannels(unsigned long workerJobChannels);
+    void SetWorkerProcess(WorkerProcess* workerProcess); // Takes ownership. Only the first one sticks, a worker never switches processes mid-job.
     static void WorkerThreadMain(void *workThreadObject);
 
 private:
     const char *m_uniqueName;
     unsigned long m_workerJobChannels = 0xffffffff;
     bool m_isStopping = false;
+    bool m_isBusy = false; // Set as the job is claimed
+    bool m_hasExited = false;
+    std::chrono::steady_clock::time_point m_lastBusyTime = std::chrono::steady_clock::now();
     JobSystem *m_jobSystem = nullptr;
     std::thread *m_thread = nullptr;
+    std::vector<int> m_cpuAffinity;
+    int m_numaNode = -1; // NUMA node the worker is pinned to, -1 if it is not pinned to a single node
+    WorkerProcess *m_workerProcess = nullptr; // Runs the jobs of this worker when set, instead of this thread
     mutable std::mutex m_workerStatusMutex;
 };
\ No newline at end of file
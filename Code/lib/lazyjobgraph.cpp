@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "lazyjobgraph.h"
+
+uint32_t LazyJobGraph::AddJobType(const std::string& jobTypeIdentifier){
+    auto typeIter = m_jobTypeIndices.find(jobTypeIdentifier);
+    if(typeIter != m_jobTypeIndices.end()){
+        return typeIter->second;
+    }
+
+    uint32_t typeIndex = (uint32_t)m_jobTypes.size();
+    m_jobTypes.push_back(jobTypeIdentifier);
+    m_jobTypeIndices[jobTypeIdentifier] = typeIndex;
+    return typeIndex;
+}
+
+int LazyJobGraph::AddNode(uint32_t typeIndex, const char* input, size_t inputSize, int priority){
+    // Offsets are 32 bits: 4 GB of distinct inputs, and as many nodes as an int can number
+    if(m_isSealed || typeIndex >= m_jobTypes.size() || m_nodes.size() >= (size_t)INT32_MAX || m_inputBlob.size() + inputSize > UINT32_MAX){
+        return -1;
+    }
+
+    // NOTE: Inputs are NUL terminated in the blob, so the job can parse them in place
+    std::string_view inputText(input, inputSize);
+    size_t inputHash = std::hash<std::string_view>()(inputText);
+    uint32_t inputOffset = (uint32_t)m_inputBlob.size();
+    bool isShared = false;
+    auto range = m_inputOffsetsByHash.equal_range(inputHash);
+    for(auto offsetIter = range.first; offsetIter != range.second; ++offsetIter){
+        if(m_inputBlob.compare(offsetIter->second, inputSize, inputText) == 0 && m_inputBlob[offsetIter->second + inputSize] == '\0'){
+            inputOffset = offsetIter->second;
+            isShared = true;
+            break;
+        }
+    }
+    if(!isShared){
+        m_inputBlob.append(inputText);
+        m_inputBlob.push_back('\0');
+        m_inputOffsetsByHash.insert({ inputHash, inputOffset });
+    }
+
+    LazyJobNode node;
+    node.m_typeIndex = typeIndex;
+    node.m_inputOffset = inputOffset;
+    node.m_inputSize = (uint32_t)inputSize;
+    node.m_priority = priority;
+    m_nodes.push_back(node);
+    return (int)m_nodes.size() - 1;
+}
+
+void LazyJobGraph::RemoveNodesFrom(int firstNode){
+    if(!m_isSealed && firstNode >= 0 && firstNode < (int)m_nodes.size()){
+        m_nodes.resize(firstNode);
+    }
+}
+
+bool LazyJobGraph::AddEdge(int dependencyNode, int dependentNode){
+    if(m_isSealed || dependencyNode < 0 || dependentNode < 0 || dependencyNode >= (int)m_nodes.size() || dependentNode >= (int)m_nodes.size()){
+        return false;
+    }
+
+    m_edges.push_back({ (uint32_t)dependencyNode, (uint32_t)dependentNode });
+    return true;
+}
+
+bool LazyJobGraph::SetGate(int node, int conditionalNode, bool runIfConditionMet){
+    if(!AddEdge(conditionalNode, node)){
+        return false;
+    }
+
+    m_gates[(uint32_t)node] = { (uint32_t)conditionalNode, runIfConditionMet };
+    return true;
+}
+
+// NOTE:    Counting sort of the edges, once by dependent and once by dependency. It is stable, so
+//          each node's dependencies keep the order they were added in. An edge added twice is only
+//          kept once. The chain lengths come from Kahn's walk backwards: from the nodes nothing waits
+//          for, up to the roots. If the walk does not reach every node, some are on a cycle.
+bool LazyJobGraph::Seal(int firstJobID){
+    if(m_isSealed){
+        return false;
+    }
+
+    size_t numNodes = m_nodes.size();
+    std::vector<uint32_t> dependenciesOffsets(numNodes + 1, 0);
+    for(const auto& edge: m_edges){
+        dependenciesOffsets[edge.second + 1]++;
+    }
+    for(size_t node = 0; node < numNodes; node++){
+        dependenciesOffsets[node + 1] += dependenciesOffsets[node];
+    }
+
+    std::vector<uint32_t> dependencies(m_edges.size());
+    std::vector<uint32_t> nextSlot(dependenciesOffsets.begin(), dependenciesOffsets.end() - 1);
+    for(const auto& edge: m_edges){
+        dependencies[nextSlot[edge.second]++] = edge.first;
+    }
+
+    // Drop the duplicates, compacting in place. "lastDependent" marks the dependencies already seen for the current node.
+    std::vector<uint32_t> lastDependent(numNodes, UINT32_MAX);
+    uint32_t numKept = 0;
+    for(size_t node = 0; node < numNodes; node++){
+        uint32_t begin = dependenciesOffsets[node];
+        uint32_t end = dependenciesOffsets[node + 1];
+        dependenciesOffsets[node] = numKept;
+        for(uint32_t edgeIndex = begin; edgeIndex < end; edgeIndex++){
+            uint32_t dependency = dependencies[edgeIndex];
+            if(lastDependent[dependency] != node){
+                lastDependent[dependency] = (uint32_t)node;
+                dependencies[numKept++] = dependency;
+            }
+        }
+    }
+    dependenciesOffsets[numNodes] = numKept;
+    dependencies.resize(numKept);
+    dependencies.shrink_to_fit();
+
+    std::vector<uint32_t> dependentsOffsets(numNodes + 1, 0);
+    for(uint32_t dependency: dependencies){
+        dependentsOffsets[dependency + 1]++;
+    }
+    for(size_t node = 0; node < numNodes; node++){
+        dependentsOffsets[node + 1] += dependentsOffsets[node];
+    }
+
+    std::vector<uint32_t> dependents(numKept);
+    nextSlot.assign(dependentsOffsets.begin(), dependentsOffsets.end() - 1);
+    for(size_t node = 0; node < numNodes; node++){
+        for(uint32_t edgeIndex = dependenciesOffsets[node]; edgeIndex < dependenciesOffsets[node + 1]; edgeIndex++){
+            dependents[nextSlot[dependencies[edgeIndex]]++] = (uint32_t)node;
+        }
+    }
+
+    // Backwards: a node's chain is known once all of its dependents' are
+    std::vector<uint32_t> chainLengths(numNodes, 1);
+    std::vector<uint32_t> numDependentsLeft(numNodes);
+    std::vector<uint32_t> order;
+    order.reserve(numNodes);
+    for(size_t node = 0; node < numNodes; node++){
+        numDependentsLeft[node] = dependentsOffsets[node + 1] - dependentsOffsets[node];
+        if(numDependentsLeft[node] == 0){
+            order.push_back((uint32_t)node);
+        }
+    }
+    for(size_t i = 0; i < order.size(); i++){ // Grows while we walk it
+        uint32_t node = order[i];
+        for(uint32_t edgeIndex = dependenciesOffsets[node]; edgeIndex < dependenciesOffsets[node + 1]; edgeIndex++){
+            uint32_t dependency = dependencies[edgeIndex];
+            chainLengths[dependency] = std::max(chainLengths[dependency], chainLengths[node] + 1);
+            if(--numDependentsLeft[dependency] == 0){
+                order.push_back(dependency);
+            }
+        }
+    }
+    if(order.size() != numNodes){
+        return false;
+    }
+
+    m_dependenciesOffsets = std::move(dependenciesOffsets);
+    m_dependencies = std::move(dependencies);
+    m_dependentsOffsets = std::move(dependentsOffsets);
+    m_dependents = std::move(dependents);
+    m_chainLengths = std::move(chainLengths);
+
+    m_numPendingDependencies.reset(new std::atomic<uint32_t>[numNodes]);
+    m_nodeStates.reset(new std::atomic<uint8_t>[numNodes]);
+    for(size_t node = 0; node < numNodes; node++){
+        m_numPendingDependencies[node].store(m_dependenciesOffsets[node + 1] - m_dependenciesOffsets[node]);
+        m_nodeStates[node].store(NODE_NOT_CREATED);
+    }
+
+    // What was only needed to build it
+    m_edges.clear();
+    m_edges.shrink_to_fit();
+    m_inputOffsetsByHash.clear();
+    m_jobTypeIndices.clear();
+    m_nodes.shrink_to_fit();
+    m_inputBlob.shrink_to_fit();
+
+    m_firstJobID = firstJobID;
+    m_isSealed = true;
+    return true;
+}
+
+std::vector<int> LazyJobGraph::GetDependencyJobIDs(int node) const{
+    std::vector<int> dependencyJobIDs;
+    dependencyJobIDs.reserve(m_dependenciesOffsets[node + 1] - m_dependenciesOffsets[node]);
+    for(uint32_t edgeIndex = m_dependenciesOffsets[node]; edgeIndex < m_dependenciesOffsets[node + 1]; edgeIndex++){
+        dependencyJobIDs.push_back(GetJobID((int)m_dependencies[edgeIndex]));
+    }
+    return dependencyJobIDs;
+}
+
+bool LazyJobGraph::GetGate(int node, int& conditionalJobID, bool& runIfConditionMet) const{
+    auto gateIter = m_gates.find((uint32_t)node);
+    if(gateIter == m_gates.end()){
+        return false;
+    }
+
+    conditionalJobID = GetJobID((int)gateIter->second.first);
+    runIfConditionMet = gateIter->second.second;
+    return true;
+}
+
+std::vector<int> LazyJobGraph::GetRootNodes() const{
+    std::vector<int> rootNodes;
+    for(size_t node = 0; node < m_nodes.size(); node++){
+        if(m_dependenciesOffsets[node + 1] == m_dependenciesOffsets[node]){
+            rootNodes.push_back((int)node);
+        }
+    }
+    return rootNodes;
+}
+
+bool LazyJobGraph::OnNodeDone(int node, std::vector<int>& readyNodes){
+    auto dependents = GetDependents(node);
+    for(const uint32_t* dependent = dependents.first; dependent != dependents.second; ++dependent){
+        if(m_numPendingDependencies[*dependent].fetch_sub(1) == 1){
+            readyNodes.push_back((int)*dependent);
+        }
+    }
+
+    return m_numNodesDone.fetch_add(1) + 1 == (int)m_nodes.size();
+}
+
+size_t LazyJobGraph::GetMemoryUsage() const{
+    size_t numBytes = m_nodes.capacity() * sizeof(LazyJobNode) + m_inputBlob.capacity();
+    numBytes += (m_dependenciesOffsets.capacity() + m_dependencies.capacity() + m_dependentsOffsets.capacity() + m_dependents.capacity() + m_chainLengths.capacity()) * sizeof(uint32_t);
+    numBytes += m_nodes.size() * (sizeof(std::atomic<uint32_t>) + sizeof(std::atomic<uint8_t>));
+    numBytes += m_edges.capacity() * sizeof(m_edges[0]);
+    return numBytes;
+}
@@ -0,0 +1,112 @@
+// A whole job graph kept as compact descriptors. Its jobs are only created once they can run (see JobSystem::QueueLazyJobGraph)
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr int32_t LAZY_JOB_INPUT_PRIORITY = INT32_MIN; // The node keeps the priority of its input (or 0)
+
+// What a job of the graph is created from. 16 bytes, against a Job, its strings and its parsed input.
+struct LazyJobNode
+{
+    uint32_t m_typeIndex = 0;   // Into the graph's job type identifiers
+    uint32_t m_inputOffset = 0; // Into the graph's input blob (JSON text)
+    uint32_t m_inputSize = 0;
+    int32_t  m_priority = 0;
+};
+
+// NOTE:    Built node by node, then sealed: the edges become two CSR arrays (for each node, its
+//          dependencies in the order they were added, and its dependents) and the input blob stops
+//          growing. Nodes get consecutive job IDs, starting at the first one given to Seal(). Once
+//          sealed, the graph only changes through OnNodeDone(), which any thread can call: every
+//          node keeps an atomic count of the dependencies it still waits for. Identical inputs (a
+//          generated graph repeats them a lot) share their bytes in the blob.
+class LazyJobGraph
+{
+public:
+    LazyJobGraph() {}
+
+    // Building. Indices of nodes are also their offset from the first job ID.
+    uint32_t AddJobType(const std::string& jobTypeIdentifier); // Interned: adding it again returns the same index
+    int AddNode(uint32_t typeIndex, const char* input, size_t inputSize, int priority = LAZY_JOB_INPUT_PRIORITY); // -1 once sealed, or if the graph is full
+    bool AddEdge(int dependencyNode, int dependentNode); // The dependent waits for the dependency
+    bool SetGate(int node, int conditionalNode, bool runIfConditionMet); // Also adds the edge
+    void RemoveNodesFrom(int firstNode); // Drops the nodes added last, that nothing refers to yet (a fan-out that did not fit). Their inputs stay in the blob.
+    int GetNumNodes() const { return (int)m_nodes.size(); }
+    const std::vector<std::string>& GetJobTypes() const { return m_jobTypes; }
+
+    // NOTE:    Builds the CSR arrays, and the length of the longest chain of nodes starting at each node.
+    //          Fails (and stays unsealed) if the graph has a cycle: its nodes would wait forever.
+    bool Seal(int firstJobID);
+    bool IsSealed() const { return m_isSealed; }
+
+    int GetFirstJobID() const { return m_firstJobID; }
+    bool Contains(int jobID) const { return m_isSealed && jobID >= m_firstJobID && jobID - m_firstJobID < (int)m_nodes.size(); }
+    int GetNode(int jobID) const { return jobID - m_firstJobID; }
+    int GetJobID(int node) const { return m_firstJobID + node; }
+
+    // What the job of a node is created from
+    const std::string& GetJobType(int node) const { return m_jobTypes[m_nodes[node].m_typeIndex]; }
+    const char* GetInput(int node) const { return m_inputBlob.data() + m_nodes[node].m_inputOffset; }
+    size_t GetInputSize(int node) const { return m_nodes[node].m_inputSize; }
+    int GetPriority(int node) const { return m_nodes[node].m_priority; }
+    std::vector<int> GetDependencyJobIDs(int node) const; // In the order they were added: jobs read their first one
+    bool GetGate(int node, int& conditionalJobID, bool& runIfConditionMet) const; // False if the node is not gated
+    uint32_t GetChainLength(int node) const { return m_chainLengths[node]; }
+
+    std::pair<const uint32_t*, const uint32_t*> GetDependents(int node) const {
+        return { m_dependents.data() + m_dependentsOffsets[node], m_dependents.data() + m_dependentsOffsets[node + 1] };
+    }
+
+    std::vector<int> GetRootNodes() const; // Waiting for nothing: ready as soon as the graph is queued
+
+    // NOTE:    Called once per node, when its job is done for good (completed, skipped or cancelled).
+    //          Appends the dependents that were only waiting for it. Returns true once every node is done.
+    bool OnNodeDone(int node, std::vector<int>& readyNodes);
+
+    // A node is created or cancelled before it is created, never both. The first one to claim it wins.
+    bool TryCreateNode(int node) { return TrySetNodeState(node, NODE_CREATED); }
+    bool TryCancelNode(int node) { return TrySetNodeState(node, NODE_CANCELLED); }
+    bool IsNodeCreated(int node) const { return m_nodeStates[node].load() == NODE_CREATED; }
+
+    size_t GetMemoryUsage() const; // Bytes held by the descriptors, the edges and the inputs
+
+private:
+    enum NodeState : uint8_t
+    {
+        NODE_NOT_CREATED,
+        NODE_CREATED,
+        NODE_CANCELLED
+    };
+
+    bool TrySetNodeState(int node, NodeState state){
+        uint8_t notCreated = NODE_NOT_CREATED;
+        return m_nodeStates[node].compare_exchange_strong(notCreated, state);
+    }
+
+    bool                                    m_isSealed = false;
+    int                                     m_firstJobID = -1;
+
+    std::vector<std::string>                m_jobTypes;
+    std::unordered_map<std::string, uint32_t> m_jobTypeIndices; // Building only
+    std::vector<LazyJobNode>                m_nodes;
+    std::string                             m_inputBlob;
+    std::unordered_multimap<size_t, uint32_t> m_inputOffsetsByHash; // Building only. Hash of an input -> where it already is.
+    std::vector< std::pair<uint32_t, uint32_t> > m_edges; // Building only. (dependency, dependent), in the order they were added.
+    std::unordered_map<uint32_t, std::pair<uint32_t, bool> > m_gates; // Node -> conditional node, runIfConditionMet. Few nodes are gated.
+
+    // CSR, once sealed. The dependencies of node N are "m_dependencies[m_dependenciesOffsets[N]]" up to the next node's offset.
+    std::vector<uint32_t>                   m_dependenciesOffsets;
+    std::vector<uint32_t>                   m_dependencies;
+    std::vector<uint32_t>                   m_dependentsOffsets;
+    std::vector<uint32_t>                   m_dependents;
+    std::vector<uint32_t>                   m_chainLengths;
+
+    std::unique_ptr< std::atomic<uint32_t>[] > m_numPendingDependencies;
+    std::unique_ptr< std::atomic<uint8_t>[] > m_nodeStates;
+    std::atomic<int>                        m_numNodesDone{0};
+};
@@ -0,0 +1,202 @@
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <map>
+#include <algorithm>
+#include <cctype>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "workerplacement.h"
+
+namespace fs = std::filesystem;
+
+static std::string readFirstLine(const fs::path& filePath){
+    std::ifstream file(filePath);
+    std::string line;
+    if(file.is_open()){
+        std::getline(file, line);
+    }
+    return line;
+}
+
+const CpuTopology& CpuTopology::Get(){
+    static CpuTopology s_cpuTopology; // Initialized once, thread safe since C++11
+    return s_cpuTopology;
+}
+
+CpuTopology::CpuTopology(){
+    const fs::path cpuFolderPath = "/sys/devices/system/cpu/";
+    const fs::path nodeFolderPath = "/sys/devices/system/node/";
+
+    std::vector<int> onlineCpus = ParseCpuList(readFirstLine(cpuFolderPath / "online"));
+    if(onlineCpus.empty()){
+        // No sysfs (or not Linux). Pretend every hardware thread is its own core.
+        int numHardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+        for(int cpuID = 0; cpuID < numHardwareThreads; cpuID++){
+            onlineCpus.push_back(cpuID);
+        }
+    }
+
+    std::map<int, int> numaNodeOfCpu;
+    std::error_code errorCode;
+    if(fs::exists(nodeFolderPath, errorCode)){
+        for(const auto& entry: fs::directory_iterator(nodeFolderPath, errorCode)){
+            std::string folderName = entry.path().filename().string();
+            if(folderName.rfind("node", 0) != 0 || folderName.size() == 4 || !std::isdigit((unsigned char)folderName[4])){
+                continue;
+            }
+
+            int numaNode = std::stoi(folderName.substr(4));
+            for(int cpuID: ParseCpuList(readFirstLine(entry.path() / "cpulist"))){
+                numaNodeOfCpu[cpuID] = numaNode;
+            }
+        }
+    }
+
+    for(int cpuID: onlineCpus){
+        CpuInfo cpu;
+        cpu.m_cpuID = cpuID;
+
+        fs::path topologyPath = cpuFolderPath / ("cpu" + std::to_string(cpuID)) / "topology";
+        std::string coreID = readFirstLine(topologyPath / "core_id");
+        std::string packageID = readFirstLine(topologyPath / "physical_package_id");
+        cpu.m_coreID = coreID.empty() ? cpuID : std::stoi(coreID);
+        cpu.m_packageID = packageID.empty() ? 0 : std::stoi(packageID);
+
+        auto nodeIter = numaNodeOfCpu.find(cpuID);
+        cpu.m_numaNode = (nodeIter != numaNodeOfCpu.end()) ? nodeIter->second : 0;
+
+        m_cpus.push_back(cpu);
+    }
+
+    // Group the logical CPUs by physical core, and the physical cores by NUMA node
+    std::map< std::pair<int, int>, std::vector<int> > cpusOfCore; // (package, core) -> logical CPUs
+    std::map< std::pair<int, int>, int > numaNodeOfCore;
+    for(const CpuInfo& cpu: m_cpus){
+        std::pair<int, int> coreKey(cpu.m_packageID, cpu.m_coreID);
+        cpusOfCore[coreKey].push_back(cpu.m_cpuID);
+        numaNodeOfCore[coreKey] = cpu.m_numaNode;
+    }
+
+    std::map< int, std::vector< std::vector<int> > > coresOfNode;
+    for(const auto& entry: cpusOfCore){
+        coresOfNode[numaNodeOfCore[entry.first]].push_back(entry.second);
+    }
+
+    // Interleave the nodes, so handing out cores in order spreads the workers over every socket
+    bool coreAdded = true;
+    for(size_t coreIndex = 0; coreAdded; coreIndex++){
+        coreAdded = false;
+        for(const auto& entry: coresOfNode){
+            if(coreIndex < entry.second.size()){
+                m_physicalCores.push_back(entry.second[coreIndex]);
+                coreAdded = true;
+            }
+        }
+    }
+}
+
+int CpuTopology::GetNumaNodeOfCpu(int cpuID) const{
+    for(const CpuInfo& cpu: m_cpus){
+        if(cpu.m_cpuID == cpuID){
+            return cpu.m_numaNode;
+        }
+    }
+    return -1;
+}
+
+std::vector<int> CpuTopology::ParseCpuList(const std::string& cpuList){
+    std::vector<int> cpuIDs;
+    std::istringstream listStream(cpuList);
+    std::string range;
+
+    while(std::getline(listStream, range, ',')){
+        if(range.empty()){
+            continue;
+        }
+
+        try {
+            size_t dashPosition = range.find('-');
+            if(dashPosition == std::string::npos){
+                cpuIDs.push_back(std::stoi(range));
+            } else {
+                int first = std::stoi(range.substr(0, dashPosition));
+                int last = std::stoi(range.substr(dashPosition + 1));
+                for(int cpuID = first; cpuID <= last; cpuID++){
+                    cpuIDs.push_back(cpuID);
+                }
+            }
+        } catch (const std::exception&) {
+            // Ignore the malformed range, but keep the rest of the list
+        }
+    }
+
+    return cpuIDs;
+}
+
+std::vector<int> WorkerPlacement::AssignCpus(const WorkerPlacementConfig& config){
+    const std::vector< std::vector<int> >& physicalCores = CpuTopology::Get().GetPhysicalCores();
+    if(physicalCores.empty()){
+        return {};
+    }
+
+    switch(config.m_policy){
+        case WORKER_PLACEMENT_WHOLE_CORES: {
+            std::vector<int> cpuIDs = physicalCores[m_nextWholeCore % physicalCores.size()];
+            m_nextWholeCore++;
+            return cpuIDs;
+        }
+        case WORKER_PLACEMENT_SMT_SIBLINGS: {
+            // Walk the cores from the last one down, filling every sibling of a core before moving on
+            std::vector<int> siblingOrder;
+            for(auto coreIter = physicalCores.rbegin(); coreIter != physicalCores.rend(); ++coreIter){
+                siblingOrder.insert(siblingOrder.end(), coreIter->begin(), coreIter->end());
+            }
+            int cpuID = siblingOrder[m_nextSiblingCpu % siblingOrder.size()];
+            m_nextSiblingCpu++;
+            return { cpuID };
+        }
+        case WORKER_PLACEMENT_CPU_SET:
+            return config.m_cpuSet;
+        default:
+            return {};
+    }
+}
+
+bool PinThreadToCpus(std::thread& thread, const std::vector<int>& cpuIDs){
+#ifdef __linux__
+    if(cpuIDs.empty()){
+        return false;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for(int cpuID: cpuIDs){
+        if(cpuID >= 0 && cpuID < CPU_SETSIZE){
+            CPU_SET(cpuID, &cpuSet);
+        }
+    }
+
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+    (void)thread;
+    (void)cpuIDs;
+    return false;
+#endif
+}
+
+int GetNumaNodeOfCpus(const std::vector<int>& cpuIDs){
+    int numaNode = -1;
+    for(int cpuID: cpuIDs){
+        int cpuNode = CpuTopology::Get().GetNumaNodeOfCpu(cpuID);
+        if(cpuNode < 0 || (numaNode >= 0 && cpuNode != numaNode)){
+            return -1;
+        }
+        numaNode = cpuNode;
+    }
+    return numaNode;
+}
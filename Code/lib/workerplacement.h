@@ -0,0 +1,62 @@
+// Decides which CPUs a worker thread is allowed to run on
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+
+enum WorkerPlacementPolicy
+{
+    WORKER_PLACEMENT_NONE,          // Let the OS schedule the worker anywhere
+    WORKER_PLACEMENT_WHOLE_CORES,   // Each worker gets a physical core (with all of its SMT siblings) to itself
+    WORKER_PLACEMENT_SMT_SIBLINGS,  // Each worker gets ONE logical CPU, so workers end up sharing physical cores
+    WORKER_PLACEMENT_CPU_SET,       // Workers float over an explicit list of CPUs, e.g. "0-3,8"
+    NUM_WORKER_PLACEMENT_POLICIES
+};
+
+struct CpuInfo
+{
+    int m_cpuID = -1;
+    int m_coreID = -1;
+    int m_packageID = -1;
+    int m_numaNode = 0;
+};
+
+// Snapshot of the machine's CPUs, read once from sysfs
+class CpuTopology
+{
+public:
+    static const CpuTopology& Get();
+
+    const std::vector<CpuInfo>& GetCpus() const { return m_cpus; }
+    const std::vector< std::vector<int> >& GetPhysicalCores() const { return m_physicalCores; } // Logical CPUs grouped by physical core. Consecutive cores alternate between NUMA nodes.
+    int GetNumaNodeOfCpu(int cpuID) const;
+
+    static std::vector<int> ParseCpuList(const std::string& cpuList); // Parses the kernel's list format: "0-3,8,10-11"
+
+private:
+    CpuTopology();
+
+    std::vector<CpuInfo>                m_cpus;
+    std::vector< std::vector<int> >     m_physicalCores;
+};
+
+// Hands out CPUs to the workers of ONE channel, according to its policy
+struct WorkerPlacementConfig
+{
+    WorkerPlacementPolicy   m_policy = WORKER_PLACEMENT_NONE;
+    std::vector<int>        m_cpuSet;           // Only used by WORKER_PLACEMENT_CPU_SET
+};
+
+class WorkerPlacement
+{
+public:
+    // Returns the CPUs the next worker using this config should be pinned to. Empty means "anywhere".
+    std::vector<int> AssignCpus(const WorkerPlacementConfig& config);
+
+private:
+    int m_nextWholeCore = 0;      // Whole cores are handed out from the first core up...
+    int m_nextSiblingCpu = 0;     // ...and single logical CPUs from the last core down, so the two policies collide as late as possible
+};
+
+bool PinThreadToCpus(std::thread& thread, const std::vector<int>& cpuIDs);
+int GetNumaNodeOfCpus(const std::vector<int>& cpuIDs); // NUMA node the CPUs belong to, or -1 if they span nodes (or are empty)
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "workerprocess.h"
+#include "jobsystem.h"
+
+extern char** environ;
+
+static const uint32_t s_maxFrameSize = 1u << 30; // Anything bigger is a corrupted size, not a job
+
+static bool writeAll(int socketFD, const void* data, size_t dataSize){
+    const char* bytes = (const char*)data;
+    while(dataSize > 0){
+        // MSG_NOSIGNAL: a dead worker process must not SIGPIPE us
+        ssize_t result = send(socketFD, bytes, dataSize, MSG_NOSIGNAL);
+        if(result < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        bytes += result;
+        dataSize -= (size_t)result;
+    }
+    return true;
+}
+
+static bool readAll(int socketFD, void* data, size_t dataSize){
+    char* bytes = (char*)data;
+    while(dataSize > 0){
+        ssize_t result = recv(socketFD, bytes, dataSize, 0);
+        if(result < 0 && errno == EINTR){
+            continue;
+        }
+        if(result <= 0){
+            return false; // End of file: the other side is gone
+        }
+        bytes += result;
+        dataSize -= (size_t)result;
+    }
+    return true;
+}
+
+bool WriteJobFrame(int socketFD, const json& message, int dataFormat){
+    std::vector<unsigned char> payload;
+    if(!encodeJobData(message, dataFormat, payload)){
+        return false;
+    }
+
+    uint32_t frameSize = (uint32_t)payload.size();
+    unsigned char frameFormat = (unsigned char)dataFormat;
+    return writeAll(socketFD, &frameSize, sizeof(frameSize))
+        && writeAll(socketFD, &frameFormat, sizeof(frameFormat))
+        && writeAll(socketFD, payload.data(), payload.size());
+}
+
+bool ReadJobFrame(int socketFD, json& message, int* dataFormat){
+    uint32_t frameSize = 0;
+    unsigned char frameFormat = 0;
+    if(!readAll(socketFD, &frameSize, sizeof(frameSize)) || !readAll(socketFD, &frameFormat, sizeof(frameFormat)) || frameSize > s_maxFrameSize){
+        return false;
+    }
+
+    std::vector<unsigned char> payload(frameSize);
+    if(!readAll(socketFD, payload.data(), payload.size())){
+        return false;
+    }
+
+    if(dataFormat != nullptr){
+        *dataFormat = frameFormat;
+    }
+    return decodeJobData(payload.data(), payload.size(), frameFormat, message);
+}
+
+WorkerProcess::WorkerProcess(const std::string& executablePath, const std::vector<std::string>& environment):
+    m_executablePath(executablePath),
+    m_environment(environment) {}
+
+WorkerProcess::~WorkerProcess(){
+    Reap();
+}
+
+bool WorkerProcess::Spawn(){
+    int socketFDs[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socketFDs) != 0){
+        std::cerr << "Error: Unable to create the socket of a worker process" << std::endl;
+        return false;
+    }
+
+    // NOTE:    The process gets its end under the SAME number it has here, so it cannot land on top of
+    //          a descriptor it must inherit (the jobserver pipe). dup2() from a copy clears close-on-exec
+    //          on it in the child only, a compile spawned by another worker meanwhile never inherits it.
+    int childFD = socketFDs[1];
+    int copyFD = fcntl(socketFDs[1], F_DUPFD_CLOEXEC, 0);
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_adddup2(&fileActions, copyFD, childFD);
+
+    std::vector<std::string> environment;
+    for(char** variable = environ; *variable != nullptr; variable++){
+        environment.push_back(*variable);
+    }
+    environment.insert(environment.end(), m_environment.begin(), m_environment.end());
+
+    std::vector<char*> environmentPointers;
+    for(std::string& variable: environment){
+        environmentPointers.push_back(&variable[0]);
+    }
+    environmentPointers.push_back(nullptr);
+
+    std::string childFDArgument = std::to_string(childFD);
+    char* arguments[] = { &m_executablePath[0], &childFDArgument[0], nullptr };
+
+    // posix_spawn(), not fork(): we have threads, and the child must not copy the whole job system to exec right after
+    int result = posix_spawn(&m_pid, m_executablePath.c_str(), &fileActions, nullptr, arguments, environmentPointers.data());
+    posix_spawn_file_actions_destroy(&fileActions);
+    close(copyFD);
+    close(socketFDs[1]);
+
+    if(result != 0){
+        std::cerr << "Error: Unable to start the worker process: " << m_executablePath << " (" << strerror(result) << ")" << std::endl;
+        close(socketFDs[0]);
+        m_pid = -1;
+        return false;
+    }
+
+    m_socketFD = socketFDs[0];
+    return true;
+}
+
+void WorkerProcess::Reap(){
+    if(m_socketFD >= 0){
+        close(m_socketFD);
+        m_socketFD = -1;
+    }
+    if(m_pid > 0){
+        int status = 0;
+        while(waitpid(m_pid, &status, 0) < 0 && errno == EINTR) {}
+        m_pid = -1;
+    }
+}
+
+bool WorkerProcess::Call(const json& request, json& reply){
+    if(m_pid <= 0 && !Spawn()){
+        return false;
+    }
+
+    if(WriteJobFrame(m_socketFD, request) && ReadJobFrame(m_socketFD, reply)){
+        return true;
+    }
+
+    // The process died (or is talking nonsense). Start a fresh one for the next job.
+    std::cerr << "Error: Worker process " << m_pid << " (" << m_executablePath << ") died while running a job" << std::endl;
+    kill(m_pid, SIGKILL); // In case it is only confused, not dead
+    Reap();
+    return false;
+}
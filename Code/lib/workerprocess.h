@@ -0,0 +1,45 @@
+// A "jobworker" process that executes jobs for a worker thread, so a crash (or a leak) in a job does not take the job system down with it
+#pragma once
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <csignal>
+#include "json.hpp"
+#include "jobdata.h"
+
+using json = nlohmann::json;
+
+// NOTE:    The worker thread and its process talk over a Unix domain socket pair, one request and
+//          one reply at a time. Every message is a frame: its size (uint32_t, host byte order, both
+//          ends are on the same machine), its encoding (one byte, a JobDataFormat), then the message.
+//          Requests carry the job (type identifier, input, ID, dependencies) and the outputs of its
+//          dependencies, since the process has no job history of its own. Replies carry the output.
+bool WriteJobFrame(int socketFD, const json& message, int dataFormat = JOB_DATA_FORMAT_MSGPACK);
+bool ReadJobFrame(int socketFD, json& message, int* dataFormat = nullptr); // False on end of file, or on a frame that does not decode
+
+class WorkerProcess
+{
+public:
+    // "environment" is added to ours when the process is started
+    WorkerProcess(const std::string& executablePath, const std::vector<std::string>& environment);
+    ~WorkerProcess(); // Closes the socket, which tells the process to exit, and waits for it
+
+    // Sends the request and waits for the reply. Starts the process the first time, and again after it died.
+    // False if the process could not be started, or died before replying.
+    bool Call(const json& request, json& reply);
+    bool Start() { return m_pid > 0 || Spawn(); } // Call() does it too. For callers that want the process ID first.
+
+    // Sent by the job system to interrupt the job a process is running (see JobSystem::InterruptJobRequest)
+    static constexpr int INTERRUPT_SIGNAL = SIGUSR1;
+
+    pid_t GetPid() const { return m_pid; }
+
+private:
+    bool Spawn();
+    void Reap(); // Closes our end of the socket and waits for the process
+
+    std::string                 m_executablePath;
+    std::vector<std::string>    m_environment;
+    pid_t                       m_pid = -1;
+    int                         m_socketFD = -1;
+};
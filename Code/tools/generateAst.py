@@ -69,7 +69,7 @@ def main():
         "Expression     : expression",
         "Function       : name, statements",
         "Var            : name, expr",
-        "JobDeclaration : job_identifier, job_type, input",
+        "JobDeclaration : job_identifier, job_type, input, priority, foreach",
         "ConditionalJob : job_identifier, test_type, if_true_job_id, else_job_id",
         "Dependency     : dependencies"
     ])
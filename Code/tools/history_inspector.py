@@ -0,0 +1,73 @@
+# Reads the job history store (see Code/lib/jobhistorystore.h) written by the job system.
+# Safe to run while the job system is running: it only ever reads the files.
+#
+#   python3 Code/tools/history_inspector.py ./Data/job_history            -> one line per job
+#   python3 Code/tools/history_inspector.py ./Data/job_history --id 3     -> the output of job 3
+import os
+import sys
+import json
+import struct
+import argparse
+
+HEADER_FORMAT = "<8sIIQQ"   # magic, version, record size, number of records, capacity
+RECORD_FORMAT = "<iiiiQQ"   # job ID, job type, status, NUMA node, output offset, output size
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+
+STATUS_NAMES = ["NEVER_SEEN", "QUEUED", "RUNNING", "COMPLETED", "RETIRED", "SKIPPED", "CANCELLED"]
+
+
+def read_records(folder: str):
+    with open(os.path.join(folder, "records.bin"), "rb") as records_file:
+        magic, version, record_size, num_records, capacity = struct.unpack(HEADER_FORMAT, records_file.read(HEADER_SIZE))
+        if magic.rstrip(b"\0") != b"JOBHIST" or version != 1 or record_size != RECORD_SIZE:
+            raise ValueError(f"{folder} is not a job history store this inspector understands")
+
+        records = []
+        for job_id in range(num_records):
+            data = records_file.read(RECORD_SIZE)
+            if len(data) < RECORD_SIZE:
+                break # The job system is growing the file as we speak
+            _, job_type, status, numa_node, output_offset, output_size = struct.unpack(RECORD_FORMAT, data)
+            records.append({"id": job_id, "type": job_type, "status": status, "numaNode": numa_node,
+                            "outputOffset": output_offset, "outputSize": output_size})
+        return records
+
+
+def read_output(folder: str, record):
+    if record["outputSize"] == 0:
+        return None
+    with open(os.path.join(folder, "outputs.bin"), "rb") as outputs_file:
+        outputs_file.seek(record["outputOffset"])
+        return json.loads(outputs_file.read(record["outputSize"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Inspect the job history store of the job system.")
+    parser.add_argument("folder", help="Folder of the store (the one given to --history-store).")
+    parser.add_argument("--id", type=int, help="Print the output of this job.")
+    args = parser.parse_args()
+
+    try:
+        records = read_records(args.folder)
+    except (OSError, ValueError) as error:
+        print(f"Error: {error}")
+        sys.exit(1)
+
+    if args.id is not None:
+        if args.id < 0 or args.id >= len(records):
+            print(f"Error: No job # {args.id} in the store")
+            sys.exit(1)
+        print(json.dumps(read_output(args.folder, records[args.id]), indent=4))
+        return
+
+    print(f"{'ID':<8}{'Status':<12}{'Type':<6}{'NUMA':<6}{'Output':>10}")
+    for record in records:
+        if record["status"] == 0:
+            continue # Never queued
+        status = STATUS_NAMES[record["status"]] if record["status"] < len(STATUS_NAMES) else str(record["status"])
+        print(f"{record['id']:<8}{status:<12}{record['type']:<6}{record['numaNode']:<6}{record['outputSize']:>10}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,73 @@
+# Submits jobs to a running job system through its shared-memory ring (see Code/lib/jobring.h), and prints their outputs.
+# Only the client side of libjobsystem.so is used: no job system is started in this process.
+#
+#   python3 Code/fs_interpreter/flowscript.py --submission-ring flowscript Data/FlowScript/dependency.fscript
+#   python3 Code/tools/ring_client.py flowscript                    -> compiles ./Data/testCode, then parses the result
+#   python3 Code/tools/ring_client.py flowscript --count 100        -> 100 compile + parse pairs, in one burst
+import os
+import sys
+import json
+import time
+import ctypes
+import argparse
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "../fs_interpreter"))
+from job_sys_functions import open_job_ring, close_job_ring, submit_job_to_ring, poll_ring_completion, JOB_DATA_FORMAT_JSON, JOB_RING_REJECTED, JOB_STATUS_SKIPPED, JOB_STATUS_CANCELLED
+
+COMPILE_INPUT = {"jobChannels": 268435456, "jobType": 1, "makefile": "./Data/testCode/Makefile", "isFilePath": True}
+PARSING_INPUT = {"jobChannels": 536870912, "jobType": 2, "content": ""}
+
+
+def submit(ring, tag: int, job_type: str, job_input: dict, dependency_tags=()):
+    data = json.dumps(job_input).encode('utf-8')
+    dependencies = (ctypes.c_ulonglong * len(dependency_tags))(*dependency_tags)
+    while True:
+        result = submit_job_to_ring(ring, tag, job_type.encode('utf-8'), data, len(data), JOB_DATA_FORMAT_JSON, dependencies, len(dependency_tags), 0)
+        if result == 1:
+            return
+        if result < 0:
+            raise ValueError(f"Job {tag} is too big for the ring")
+        time.sleep(0.0001) # Full: the job system is catching up
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Submit jobs through a job system's shared-memory ring.")
+    parser.add_argument("ring", help="Name of the ring, as given to --submission-ring")
+    parser.add_argument("--count", type=int, default=1, help="Number of compile + parse pairs to submit")
+    args = parser.parse_args()
+
+    ring = open_job_ring(args.ring.encode('utf-8'))
+    if not ring:
+        sys.exit(1)
+
+    start = time.perf_counter()
+    for i in range(args.count):
+        submit(ring, 2 * i, "COMPILE_JOB", COMPILE_INPUT)
+        submit(ring, 2 * i + 1, "PARSING_JOB", PARSING_INPUT, [2 * i])
+    submitted = time.perf_counter()
+
+    num_pending = 2 * args.count
+    while num_pending > 0:
+        completion = poll_ring_completion(ring)
+        if completion is None:
+            time.sleep(0.0001)
+            continue
+
+        tag, job_id, status, output = completion
+        num_pending -= 1
+        if status == JOB_RING_REJECTED:
+            print(f"tag {tag}: rejected")
+        elif status == JOB_STATUS_SKIPPED:
+            print(f"tag {tag}: job # {job_id} -> skipped")
+        elif status == JOB_STATUS_CANCELLED:
+            print(f"tag {tag}: job # {job_id} -> cancelled")
+        else:
+            print(f"tag {tag}: job # {job_id} -> {json.loads(output).get('status')}")
+
+    done = time.perf_counter()
+    print(f"\nSubmitted {2 * args.count} jobs in {(submitted - start) * 1e6:.0f} us, all completed after {(done - start) * 1e3:.1f} ms")
+    close_job_ring(ring)
+
+
+if __name__ == "__main__":
+    main()